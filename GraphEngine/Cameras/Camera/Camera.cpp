@@ -1,6 +1,15 @@
 #include "Camera.hpp"
 
 
+namespace {
+    const gre::UniformHandle SCREEN_TEXTURE_SIZE_UNIFORM("screen_texture_size");
+    const gre::UniformHandle CHECK_POINT_UNIFORM("check_point");
+    const gre::UniformHandle VIEW_POS_UNIFORM("view_pos");
+    const gre::UniformHandle VIEW_UNIFORM("view");
+    const gre::UniformHandle PROJECTION_UNIFORM("projection");
+}  // anonymous namespace
+
+
 // ControlSystem
 namespace gre {
     void ControlSystem::switch_active(sf::RenderWindow * window) {
@@ -284,7 +293,7 @@ namespace gre {
         glViewport(static_cast<GLint>(viewport_position_.x), static_cast<GLint>(window_->getSize().y - viewport_size_.y - viewport_position_.y), static_cast<GLsizei>(viewport_size_.x), static_cast<GLsizei>(viewport_size_.y));
         GRE_CHECK_GL_ERRORS;
 
-        shader.set_uniform_f("screen_texture_size", static_cast<GLfloat>(viewport_size_.x / window_->getSize().x), static_cast<GLfloat>(viewport_size_.y / window_->getSize().y));
+        shader.set_uniform_f(SCREEN_TEXTURE_SIZE_UNIFORM, static_cast<GLfloat>(viewport_size_.x / window_->getSize().x), static_cast<GLfloat>(viewport_size_.y / window_->getSize().y));
     }
 
     // MAIN shader expected
@@ -292,10 +301,10 @@ namespace gre {
         glViewport(0, 0, static_cast<GLsizei>(viewport_size_.x), static_cast<GLsizei>(viewport_size_.y));
         GRE_CHECK_GL_ERRORS;
 
-        shader.set_uniform_f("check_point", static_cast<GLfloat>(check_point_.x * viewport_size_.x), static_cast<GLfloat>(check_point_.y * viewport_size_.y));
-        shader.set_uniform_f("view_pos", position);
-        shader.set_uniform_matrix("view", get_view_matrix());
-        shader.set_uniform_matrix("projection", projection_);
+        shader.set_uniform_f(CHECK_POINT_UNIFORM, static_cast<GLfloat>(check_point_.x * viewport_size_.x), static_cast<GLfloat>(check_point_.y * viewport_size_.y));
+        shader.set_uniform_f(VIEW_POS_UNIFORM, position);
+        shader.set_uniform_matrix(VIEW_UNIFORM, get_view_matrix());
+        shader.set_uniform_matrix(PROJECTION_UNIFORM, projection_);
     }
 
     // Private functions
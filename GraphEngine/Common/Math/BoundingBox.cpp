@@ -0,0 +1,124 @@
+#include "BoundingBox.hpp"
+
+
+// BoundingBox
+namespace gre {
+    // Constructors
+    BoundingBox::BoundingBox() noexcept {
+    }
+
+    BoundingBox::BoundingBox(const Vec3& min_point, const Vec3& max_point) noexcept
+        : min_point(min_point)
+        , max_point(max_point)
+    {}
+
+    // Operators
+    bool BoundingBox::operator==(const BoundingBox& other) const noexcept {
+        if (empty() || other.empty()) {
+            return empty() && other.empty();
+        }
+        return min_point == other.min_point && max_point == other.max_point;
+    }
+
+    bool BoundingBox::operator!=(const BoundingBox& other) const noexcept {
+        return !(*this == other);
+    }
+
+    // Getters
+    Vec3 BoundingBox::get_center() const noexcept {
+        GRE_CHECK(!empty(), "center of empty box");
+
+        return (min_point + max_point) / 2.0;
+    }
+
+    Vec3 BoundingBox::get_size() const noexcept {
+        if (empty()) {
+            return Vec3(0.0);
+        }
+        return max_point - min_point;
+    }
+
+    bool BoundingBox::empty() const noexcept {
+        return min_point.x > max_point.x || min_point.y > max_point.y || min_point.z > max_point.z;
+    }
+
+    // Math functions
+    void BoundingBox::extend(const Vec3& point) noexcept {
+        min_point = Vec3(std::min(min_point.x, point.x), std::min(min_point.y, point.y), std::min(min_point.z, point.z));
+        max_point = Vec3(std::max(max_point.x, point.x), std::max(max_point.y, point.y), std::max(max_point.z, point.z));
+    }
+
+    void BoundingBox::extend(const BoundingBox& other) noexcept {
+        if (other.empty()) {
+            return;
+        }
+
+        extend(other.min_point);
+        extend(other.max_point);
+    }
+
+    bool BoundingBox::contains(const Vec3& point) const noexcept {
+        return min_point.x <= point.x && point.x <= max_point.x
+            && min_point.y <= point.y && point.y <= max_point.y
+            && min_point.z <= point.z && point.z <= max_point.z;
+    }
+
+    bool BoundingBox::intersects(const BoundingBox& other) const noexcept {
+        return min_point.x <= other.max_point.x && other.min_point.x <= max_point.x
+            && min_point.y <= other.max_point.y && other.min_point.y <= max_point.y
+            && min_point.z <= other.max_point.z && other.min_point.z <= max_point.z;
+    }
+
+    bool BoundingBox::intersects_ray(const Vec3& origin, const Vec3& direction, double& distance) const noexcept {
+        if (empty()) {
+            return false;
+        }
+
+        double near_distance = -std::numeric_limits<double>::infinity();
+        double far_distance = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < 3; ++i) {
+            if (equality(direction[i], 0.0)) {
+                if (origin[i] < min_point[i] || max_point[i] < origin[i]) {
+                    return false;
+                }
+                continue;
+            }
+
+            double first = (min_point[i] - origin[i]) / direction[i];
+            double second = (max_point[i] - origin[i]) / direction[i];
+            near_distance = std::max(near_distance, std::min(first, second));
+            far_distance = std::min(far_distance, std::max(first, second));
+        }
+
+        if (near_distance > far_distance || far_distance < 0.0) {
+            return false;
+        }
+
+        distance = std::max(near_distance, 0.0);
+        return true;
+    }
+
+    BoundingBox BoundingBox::transform(const Matrix4x4& matrix) const noexcept {
+        if (empty()) {
+            return BoundingBox();
+        }
+
+        // Arvo's method: each output axis is the translation plus extreme contributions of the rows
+        BoundingBox result(Vec3(matrix[0][3], matrix[1][3], matrix[2][3]), Vec3(matrix[0][3], matrix[1][3], matrix[2][3]));
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                double first = matrix[i][j] * min_point[j];
+                double second = matrix[i][j] * max_point[j];
+                result.min_point[i] += std::min(first, second);
+                result.max_point[i] += std::max(first, second);
+            }
+        }
+        return result;
+    }
+
+    // External operators
+    std::ostream& operator<<(std::ostream& fout, const BoundingBox& box) {
+        fout << '[' << box.min_point << ", " << box.max_point << ']';
+        return fout;
+    }
+}  // namespace gre
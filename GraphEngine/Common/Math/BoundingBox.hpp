@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Matrix.hpp"
+
+
+// Axis aligned bounding box
+namespace gre {
+    class BoundingBox {
+    public:
+        // Empty box has min_point greater than max_point
+        Vec3 min_point = Vec3(std::numeric_limits<double>::infinity());
+        Vec3 max_point = Vec3(-std::numeric_limits<double>::infinity());
+
+        // Constructors
+        BoundingBox() noexcept;
+
+        BoundingBox(const Vec3& min_point, const Vec3& max_point) noexcept;
+
+        // Operators
+        bool operator==(const BoundingBox& other) const noexcept;
+
+        bool operator!=(const BoundingBox& other) const noexcept;
+
+        // Getters
+        Vec3 get_center() const noexcept;
+
+        Vec3 get_size() const noexcept;
+
+        bool empty() const noexcept;
+
+        // Math functions
+        void extend(const Vec3& point) noexcept;
+
+        void extend(const BoundingBox& other) noexcept;
+
+        bool contains(const Vec3& point) const noexcept;
+
+        bool intersects(const BoundingBox& other) const noexcept;
+
+        // Slab test, distance is set to the nearest intersection along the direction
+        bool intersects_ray(const Vec3& origin, const Vec3& direction, double& distance) const noexcept;
+
+        // Box containing this box after affine transform
+        BoundingBox transform(const Matrix4x4& matrix) const noexcept;
+    };
+
+    // External operators
+    std::ostream& operator<<(std::ostream& fout, const BoundingBox& box);
+}  // namespace gre
@@ -0,0 +1,91 @@
+#include "BoundingSphere.hpp"
+
+
+// BoundingSphere
+namespace gre {
+    // Constructors
+    BoundingSphere::BoundingSphere() noexcept {
+    }
+
+    BoundingSphere::BoundingSphere(const Vec3& center, double radius) noexcept
+        : center(center)
+        , radius(radius)
+    {}
+
+    BoundingSphere::BoundingSphere(const BoundingBox& box) noexcept {
+        if (box.empty()) {
+            return;
+        }
+
+        center = box.get_center();
+        radius = box.get_size().length() / 2.0;
+    }
+
+    // Operators
+    bool BoundingSphere::operator==(const BoundingSphere& other) const noexcept {
+        if (empty() || other.empty()) {
+            return empty() && other.empty();
+        }
+        return center == other.center && equality(radius, other.radius);
+    }
+
+    bool BoundingSphere::operator!=(const BoundingSphere& other) const noexcept {
+        return !(*this == other);
+    }
+
+    // Getters
+    bool BoundingSphere::empty() const noexcept {
+        return radius < 0.0;
+    }
+
+    // Math functions
+    void BoundingSphere::extend(const BoundingSphere& other) noexcept {
+        if (other.empty()) {
+            return;
+        }
+        if (empty()) {
+            *this = other;
+            return;
+        }
+
+        Vec3 offset = other.center - center;
+        double distance = offset.length();
+        if (distance + other.radius <= radius) {
+            return;
+        }
+        if (distance + radius <= other.radius) {
+            *this = other;
+            return;
+        }
+
+        double new_radius = (distance + radius + other.radius) / 2.0;
+        center += offset * ((new_radius - radius) / distance);
+        radius = new_radius;
+    }
+
+    bool BoundingSphere::contains(const Vec3& point) const noexcept {
+        return !empty() && (point - center).length() <= radius;
+    }
+
+    bool BoundingSphere::intersects(const BoundingSphere& other) const noexcept {
+        return !empty() && !other.empty() && (other.center - center).length() <= radius + other.radius;
+    }
+
+    BoundingSphere BoundingSphere::transform(const Matrix4x4& matrix) const noexcept {
+        if (empty()) {
+            return BoundingSphere();
+        }
+
+        double max_scale = 0.0;
+        for (size_t j = 0; j < 3; ++j) {
+            max_scale = std::max(max_scale, Vec3(matrix[0][j], matrix[1][j], matrix[2][j]).length());
+        }
+        return BoundingSphere(matrix * center, radius * max_scale);
+    }
+
+    // External operators
+    std::ostream& operator<<(std::ostream& fout, const BoundingSphere& sphere) {
+        fout << '(' << sphere.center << ", " << sphere.radius << ')';
+        return fout;
+    }
+}  // namespace gre
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+
+
+// Bounding sphere
+namespace gre {
+    class BoundingSphere {
+    public:
+        // Empty sphere has negative radius
+        Vec3 center = Vec3(0.0);
+        double radius = -1.0;
+
+        // Constructors
+        BoundingSphere() noexcept;
+
+        BoundingSphere(const Vec3& center, double radius) noexcept;
+
+        // Sphere around the box
+        explicit BoundingSphere(const BoundingBox& box) noexcept;
+
+        // Operators
+        bool operator==(const BoundingSphere& other) const noexcept;
+
+        bool operator!=(const BoundingSphere& other) const noexcept;
+
+        // Getters
+        bool empty() const noexcept;
+
+        // Math functions
+        void extend(const BoundingSphere& other) noexcept;
+
+        bool contains(const Vec3& point) const noexcept;
+
+        bool intersects(const BoundingSphere& other) const noexcept;
+
+        // Sphere containing this sphere after affine transform
+        BoundingSphere transform(const Matrix4x4& matrix) const noexcept;
+    };
+
+    // External operators
+    std::ostream& operator<<(std::ostream& fout, const BoundingSphere& sphere);
+}  // namespace gre
@@ -0,0 +1,91 @@
+#include "Frustum.hpp"
+
+
+// Frustum
+namespace gre {
+    // Constructors
+    Frustum::Frustum() noexcept {
+        // Degenerate planes, everything is inside
+        for (Plane& plane : planes_) {
+            plane.normal = Vec3(0.0);
+            plane.distance = 1.0;
+        }
+    }
+
+    Frustum::Frustum(const Matrix4x4& view_projection) noexcept {
+        // Gribb-Hartmann method: planes are sums and differences of the fourth row with the others
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t side = 0; side < 2; ++side) {
+                double sign = side == 0 ? 1.0 : -1.0;
+                Plane& plane = planes_[2 * i + side];
+                plane.normal = Vec3(
+                    view_projection[3][0] + sign * view_projection[i][0],
+                    view_projection[3][1] + sign * view_projection[i][1],
+                    view_projection[3][2] + sign * view_projection[i][2]
+                );
+                plane.distance = view_projection[3][3] + sign * view_projection[i][3];
+
+                double normal_length = plane.normal.length();
+                if (!equality(normal_length, 0.0)) {
+                    plane.normal /= normal_length;
+                    plane.distance /= normal_length;
+                }
+            }
+        }
+    }
+
+    // Getters
+    std::vector<float> Frustum::get_planes() const {
+        std::vector<float> result;
+        result.reserve(4 * std::size(planes_));
+        for (const Plane& plane : planes_) {
+            result.push_back(static_cast<float>(plane.normal.x));
+            result.push_back(static_cast<float>(plane.normal.y));
+            result.push_back(static_cast<float>(plane.normal.z));
+            result.push_back(static_cast<float>(plane.distance));
+        }
+        return result;
+    }
+
+    // Math functions
+    bool Frustum::contains(const Vec3& point) const noexcept {
+        for (const Plane& plane : planes_) {
+            if (plane.normal * point + plane.distance < 0.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const BoundingSphere& sphere) const noexcept {
+        if (sphere.empty()) {
+            return false;
+        }
+
+        for (const Plane& plane : planes_) {
+            if (plane.normal * sphere.center + plane.distance < -sphere.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const BoundingBox& box) const noexcept {
+        if (box.empty()) {
+            return false;
+        }
+
+        for (const Plane& plane : planes_) {
+            // The most positive vertex along the plane normal
+            Vec3 vertex(
+                plane.normal.x >= 0.0 ? box.max_point.x : box.min_point.x,
+                plane.normal.y >= 0.0 ? box.max_point.y : box.min_point.y,
+                plane.normal.z >= 0.0 ? box.max_point.z : box.min_point.z
+            );
+            if (plane.normal * vertex + plane.distance < 0.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace gre
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "BoundingSphere.hpp"
+
+
+// View frustum in world space, extracted from a view-projection matrix
+namespace gre {
+    class Frustum {
+        // Plane is a set of points p with normal * p + distance >= 0 inside the frustum
+        struct Plane {
+            Vec3 normal;
+            double distance = 0.0;
+        };
+
+        Plane planes_[6];
+
+    public:
+        // Constructors
+        Frustum() noexcept;
+
+        explicit Frustum(const Matrix4x4& view_projection) noexcept;
+
+        // Getters
+        // Normal and distance of each plane packed as four floats, matches vec4 array in shaders
+        std::vector<float> get_planes() const;
+
+        // Math functions
+        bool contains(const Vec3& point) const noexcept;
+
+        bool intersects(const BoundingSphere& sphere) const noexcept;
+
+        bool intersects(const BoundingBox& box) const noexcept;
+    };
+}  // namespace gre
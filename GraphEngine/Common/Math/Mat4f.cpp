@@ -0,0 +1,294 @@
+#include "Mat4f.hpp"
+
+
+// Vec3f
+namespace gre {
+    // Constructors
+    Vec3f::Vec3f(float x, float y, float z) noexcept
+        : x(x)
+        , y(y)
+        , z(z)
+    {}
+
+    Vec3f::Vec3f(const Vec3& vector) noexcept
+        : x(static_cast<float>(vector.x))
+        , y(static_cast<float>(vector.y))
+        , z(static_cast<float>(vector.z))
+    {}
+
+    // Operators
+    Vec3f::operator Vec3() const noexcept {
+        return Vec3(static_cast<double>(x), static_cast<double>(y), static_cast<double>(z));
+    }
+}  // namespace gre
+
+
+// Vec4f
+namespace gre {
+    // Constructors
+    Vec4f::Vec4f(float x, float y, float z, float w) noexcept
+        : x(x)
+        , y(y)
+        , z(z)
+        , w(w)
+    {}
+
+    Vec4f::Vec4f(const Vec3f& xyz, float w) noexcept
+        : x(xyz.x)
+        , y(xyz.y)
+        , z(xyz.z)
+        , w(w)
+    {}
+
+    // Operators
+    Vec4f Vec4f::operator+(const Vec4f& other) const noexcept {
+        Vec4f result;
+#ifdef GRE_SIMD_SSE
+        _mm_store_ps(&result.x, _mm_add_ps(_mm_load_ps(&x), _mm_load_ps(&other.x)));
+#else // GRE_SIMD_SSE
+        result = Vec4f(x + other.x, y + other.y, z + other.z, w + other.w);
+#endif // !GRE_SIMD_SSE
+        return result;
+    }
+
+    Vec4f Vec4f::operator-(const Vec4f& other) const noexcept {
+        Vec4f result;
+#ifdef GRE_SIMD_SSE
+        _mm_store_ps(&result.x, _mm_sub_ps(_mm_load_ps(&x), _mm_load_ps(&other.x)));
+#else // GRE_SIMD_SSE
+        result = Vec4f(x - other.x, y - other.y, z - other.z, w - other.w);
+#endif // !GRE_SIMD_SSE
+        return result;
+    }
+
+    Vec4f Vec4f::operator*(float other) const noexcept {
+        Vec4f result;
+#ifdef GRE_SIMD_SSE
+        _mm_store_ps(&result.x, _mm_mul_ps(_mm_load_ps(&x), _mm_set1_ps(other)));
+#else // GRE_SIMD_SSE
+        result = Vec4f(x * other, y * other, z * other, w * other);
+#endif // !GRE_SIMD_SSE
+        return result;
+    }
+
+    // Math functions
+    float Vec4f::dot(const Vec4f& other) const noexcept {
+        return x * other.x + y * other.y + z * other.z + w * other.w;
+    }
+
+    Vec3f Vec4f::xyz() const noexcept {
+        return Vec3f(x, y, z);
+    }
+}  // namespace gre
+
+
+// Mat4f
+namespace gre {
+    // Constructors
+    Mat4f::Mat4f() noexcept {
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+                columns_[j][i] = 0.0f;
+            }
+        }
+    }
+
+    Mat4f::Mat4f(const Matrix4x4& matrix) noexcept {
+        // Rows are taken once, element access of Matrix4x4 is range checked
+        for (size_t i = 0; i < 4; ++i) {
+            const double* row = matrix[i];
+            for (size_t j = 0; j < 4; ++j) {
+                columns_[j][i] = static_cast<float>(row[j]);
+            }
+        }
+    }
+
+    // Operators
+    Mat4f::operator Matrix4x4() const noexcept {
+        Matrix4x4 result;
+        for (size_t i = 0; i < 4; ++i) {
+            double* row = result[i];
+            for (size_t j = 0; j < 4; ++j) {
+                row[j] = static_cast<double>(columns_[j][i]);
+            }
+        }
+        return result;
+    }
+
+    Mat4f Mat4f::operator*(const Mat4f& other) const noexcept {
+        Mat4f result;
+        multiply(*this, &other, &result, 1);
+        return result;
+    }
+
+    Vec4f Mat4f::operator*(const Vec4f& other) const noexcept {
+        Vec4f result;
+#ifdef GRE_SIMD_SSE
+        __m128 sum = _mm_mul_ps(_mm_load_ps(columns_[0]), _mm_set1_ps(other.x));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(columns_[1]), _mm_set1_ps(other.y)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(columns_[2]), _mm_set1_ps(other.z)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(columns_[3]), _mm_set1_ps(other.w)));
+        _mm_store_ps(&result.x, sum);
+#else // GRE_SIMD_SSE
+        float* destination = &result.x;
+        for (size_t i = 0; i < 4; ++i) {
+            destination[i] = columns_[0][i] * other.x + columns_[1][i] * other.y + columns_[2][i] * other.z + columns_[3][i] * other.w;
+        }
+#endif // !GRE_SIMD_SSE
+        return result;
+    }
+
+    // Getters
+    const float* Mat4f::data() const noexcept {
+        return &columns_[0][0];
+    }
+
+    Vec4f Mat4f::get_column(size_t index) const {
+        GRE_ENSURE(index <= 3, GreOutOfRange, "index out of range");
+
+        return Vec4f(columns_[index][0], columns_[index][1], columns_[index][2], columns_[index][3]);
+    }
+
+    // Math functions
+    Vec3f Mat4f::transform_point(const Vec3f& point) const noexcept {
+        return (*this * Vec4f(point, 1.0f)).xyz();
+    }
+
+    Vec3f Mat4f::transform_direction(const Vec3f& direction) const noexcept {
+        return (*this * Vec4f(direction, 0.0f)).xyz();
+    }
+
+    Mat4f Mat4f::normal_matrix() const noexcept {
+        // Columns of the inverse transpose are cross products of the other two columns divided by the determinant
+        const float* a = columns_[0];
+        const float* b = columns_[1];
+        const float* c = columns_[2];
+        float cofactors[3][3] = {
+            { b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0] },
+            { c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0] },
+            { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] }
+        };
+
+        float det = a[0] * cofactors[0][0] + a[1] * cofactors[0][1] + a[2] * cofactors[0][2];
+        GRE_CHECK(det != 0.0f, "the matrix is not invertible");
+
+        float scale = det != 0.0f ? 1.0f / det : 0.0f;
+        Mat4f result;
+        for (size_t j = 0; j < 3; ++j) {
+            for (size_t i = 0; i < 3; ++i) {
+                result.columns_[j][i] = cofactors[j][i] * scale;
+            }
+        }
+        return result;
+    }
+
+    void Mat4f::store(GLfloat* destination, size_t count_columns) const noexcept {
+        std::memcpy(destination, columns_, sizeof(GLfloat) * 4 * std::min(count_columns, static_cast<size_t>(4)));
+    }
+
+    // Precalculated matrices
+    Mat4f Mat4f::one_matrix() noexcept {
+        Mat4f result;
+        for (size_t i = 0; i < 4; ++i) {
+            result.columns_[i][i] = 1.0f;
+        }
+        return result;
+    }
+
+    // Batched kernels
+    void Mat4f::transform_points(const Mat4f& transform, const float* points, float* result, size_t count) noexcept {
+        transform_vec3(transform, points, result, count, 1.0f);
+    }
+
+    void Mat4f::transform_directions(const Mat4f& transform, const float* directions, float* result, size_t count) noexcept {
+        transform_vec3(transform, directions, result, count, 0.0f);
+    }
+
+    void Mat4f::multiply(const Mat4f& left, const Mat4f* right, Mat4f* result, size_t count) noexcept {
+#ifdef GRE_SIMD_SSE
+        __m128 left_columns[4];
+        for (size_t k = 0; k < 4; ++k) {
+            left_columns[k] = _mm_load_ps(left.columns_[k]);
+        }
+
+        for (size_t n = 0; n < count; ++n) {
+            for (size_t j = 0; j < 4; ++j) {
+                const float* column = right[n].columns_[j];
+                __m128 sum = _mm_mul_ps(left_columns[0], _mm_set1_ps(column[0]));
+                sum = _mm_add_ps(sum, _mm_mul_ps(left_columns[1], _mm_set1_ps(column[1])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(left_columns[2], _mm_set1_ps(column[2])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(left_columns[3], _mm_set1_ps(column[3])));
+                _mm_store_ps(result[n].columns_[j], sum);
+            }
+        }
+#else // GRE_SIMD_SSE
+        Mat4f left_copy = left;
+        for (size_t n = 0; n < count; ++n) {
+            for (size_t j = 0; j < 4; ++j) {
+                float column[4];
+                for (size_t k = 0; k < 4; ++k) {
+                    column[k] = right[n].columns_[j][k];
+                }
+                for (size_t i = 0; i < 4; ++i) {
+                    result[n].columns_[j][i] = left_copy.columns_[0][i] * column[0] + left_copy.columns_[1][i] * column[1] + left_copy.columns_[2][i] * column[2] + left_copy.columns_[3][i] * column[3];
+                }
+            }
+        }
+#endif // !GRE_SIMD_SSE
+    }
+
+    // Private functions
+    void Mat4f::transform_vec3(const Mat4f& transform, const float* vectors, float* result, size_t count, float w) noexcept {
+        size_t n = 0;
+#ifdef GRE_SIMD_SSE
+        const __m128 column_x = _mm_load_ps(transform.columns_[0]);
+        const __m128 column_y = _mm_load_ps(transform.columns_[1]);
+        const __m128 column_z = _mm_load_ps(transform.columns_[2]);
+        const __m128 column_w = _mm_mul_ps(_mm_load_ps(transform.columns_[3]), _mm_set1_ps(w));
+
+        // Three floats are written by two stores, so the next vector is never overwritten before it is read
+        auto store_vec3 = [](float* destination, __m128 value) {
+            _mm_storel_pi(reinterpret_cast<__m64*>(destination), value);
+            _mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+        };
+
+#ifdef GRE_SIMD_AVX
+        // Two vectors per iteration, one in each half of the registers
+        const __m256 column_x2 = _mm256_broadcast_ps(&column_x);
+        const __m256 column_y2 = _mm256_broadcast_ps(&column_y);
+        const __m256 column_z2 = _mm256_broadcast_ps(&column_z);
+        const __m256 column_w2 = _mm256_broadcast_ps(&column_w);
+        for (; n + 2 <= count; n += 2) {
+            const float* source = vectors + 3 * n;
+            __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(source[0])), _mm_set1_ps(source[3]), 1);
+            __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(source[1])), _mm_set1_ps(source[4]), 1);
+            __m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(source[2])), _mm_set1_ps(source[5]), 1);
+
+            __m256 sum = _mm256_add_ps(column_w2, _mm256_mul_ps(column_x2, x));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(column_y2, y));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(column_z2, z));
+
+            store_vec3(result + 3 * n, _mm256_castps256_ps128(sum));
+            store_vec3(result + 3 * n + 3, _mm256_extractf128_ps(sum, 1));
+        }
+#endif // GRE_SIMD_AVX
+
+        for (; n < count; ++n) {
+            const float* source = vectors + 3 * n;
+            __m128 sum = _mm_add_ps(column_w, _mm_mul_ps(column_x, _mm_set1_ps(source[0])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(column_y, _mm_set1_ps(source[1])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(column_z, _mm_set1_ps(source[2])));
+            store_vec3(result + 3 * n, sum);
+        }
+#else // GRE_SIMD_SSE
+        for (; n < count; ++n) {
+            float x = vectors[3 * n];
+            float y = vectors[3 * n + 1];
+            float z = vectors[3 * n + 2];
+            for (size_t i = 0; i < 3; ++i) {
+                result[3 * n + i] = transform.columns_[0][i] * x + transform.columns_[1][i] * y + transform.columns_[2][i] * z + transform.columns_[3][i] * w;
+            }
+        }
+#endif // !GRE_SIMD_SSE
+    }
+}  // namespace gre
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstring>
+#include "Matrix.hpp"
+
+#ifndef GRE_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRE_SIMD_SSE
+#include <immintrin.h>
+#endif // SSE2
+#if defined(GRE_SIMD_SSE) && defined(__AVX__)
+#define GRE_SIMD_AVX
+#endif // AVX
+#endif // !GRE_NO_SIMD
+
+
+// Single precision vectors and matrices in GPU layout, batched kernels use SSE or AVX if available
+namespace gre {
+    struct Vec3f {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+
+        // Constructors
+        Vec3f() noexcept = default;
+
+        Vec3f(float x, float y, float z) noexcept;
+
+        explicit Vec3f(const Vec3& vector) noexcept;
+
+        // Operators
+        explicit operator Vec3() const noexcept;
+    };
+
+    struct alignas(16) Vec4f {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+        float w = 0.0f;
+
+        // Constructors
+        Vec4f() noexcept = default;
+
+        Vec4f(float x, float y, float z, float w) noexcept;
+
+        Vec4f(const Vec3f& xyz, float w) noexcept;
+
+        // Operators
+        Vec4f operator+(const Vec4f& other) const noexcept;
+
+        Vec4f operator-(const Vec4f& other) const noexcept;
+
+        Vec4f operator*(float other) const noexcept;
+
+        // Math functions
+        float dot(const Vec4f& other) const noexcept;
+
+        Vec3f xyz() const noexcept;
+    };
+
+    class alignas(16) Mat4f {
+        float columns_[4][4];  // Column major as in GLSL
+
+        static void transform_vec3(const Mat4f& transform, const float* vectors, float* result, size_t count, float w) noexcept;
+
+    public:
+        // Constructors
+        Mat4f() noexcept;
+
+        explicit Mat4f(const Matrix4x4& matrix) noexcept;
+
+        // Operators
+        explicit operator Matrix4x4() const noexcept;
+
+        Mat4f operator*(const Mat4f& other) const noexcept;
+
+        Vec4f operator*(const Vec4f& other) const noexcept;
+
+        // Getters
+        const float* data() const noexcept;
+
+        Vec4f get_column(size_t index) const;
+
+        // Math functions
+        Vec3f transform_point(const Vec3f& point) const noexcept;
+
+        Vec3f transform_direction(const Vec3f& direction) const noexcept;
+
+        // Inverse transpose of the upper 3x3 block, the last row and column are zero
+        Mat4f normal_matrix() const noexcept;
+
+        // Writes the first columns in GPU layout
+        void store(GLfloat* destination, size_t count_columns = 4) const noexcept;
+
+        // Precalculated matrices
+        static Mat4f one_matrix() noexcept;
+
+        // Batched kernels, points and directions are packed by three floats, results may overlap inputs
+        static void transform_points(const Mat4f& transform, const float* points, float* result, size_t count) noexcept;
+
+        static void transform_directions(const Mat4f& transform, const float* directions, float* result, size_t count) noexcept;
+
+        static void multiply(const Mat4f& left, const Mat4f* right, Mat4f* result, size_t count) noexcept;
+    };
+}  // namespace gre
@@ -4,31 +4,6 @@
 // Matrix4x4
 namespace gre {
     // Constructors
-    Matrix4x4::Matrix4x4() noexcept {
-        for (uint32_t i = 0; i < 4; ++i) {
-            for (uint32_t j = 0; j < 4; ++j) {
-                matrix_[i][j] = 0.0;
-            }
-        }
-    }
-
-    Matrix4x4::Matrix4x4(double value) noexcept {
-        for (uint32_t i = 0; i < 4; ++i) {
-            for (uint32_t j = 0; j < 4; ++j) {
-                matrix_[i][j] = value;
-            }
-        }
-    }
-
-    Matrix4x4::Matrix4x4(const Vec3& vector_x, const Vec3& vector_y, const Vec3& vector_z) noexcept {
-        *this = Matrix4x4({
-            { vector_x.x, vector_y.x, vector_z.x, 0.0 },
-            { vector_x.y, vector_y.y, vector_z.y, 0.0 },
-            { vector_x.z, vector_y.z, vector_z.z, 0.0 },
-            {        0.0,        0.0,        0.0, 1.0 }
-        });
-    }
-
     Matrix4x4::Matrix4x4(const aiMatrix4x4& init) noexcept {
         for (uint32_t i = 0; i < 4; ++i) {
             for (uint32_t j = 0; j < 4; ++j) {
@@ -38,22 +13,10 @@ namespace gre {
     }
 
     // Operators
-    double* Matrix4x4::operator[](size_t index) {
-        GRE_ENSURE(index <= 3, GreOutOfRange, "index out of range");
-
-        return matrix_[index];
-    }
-
-    const double* Matrix4x4::operator[](size_t index) const {
-        GRE_ENSURE(index <= 3, GreOutOfRange, "index out of range");
-
-        return matrix_[index];
-    }
-
     bool Matrix4x4::operator==(const Matrix4x4& other) const noexcept {
         for (uint32_t i = 0; i < 4; ++i) {
             for (uint32_t j = 0; j < 4; ++j) {
-                if (!equality(matrix_[i][j], other[i][j])) {
+                if (!equality(matrix_[i][j], other.matrix_[i][j])) {
                     return false;
                 }
             }
@@ -68,7 +31,7 @@ namespace gre {
     Matrix4x4& Matrix4x4::operator+=(const Matrix4x4& other)& noexcept {
         for (uint32_t i = 0; i < 4; i++) {
             for (uint32_t j = 0; j < 4; ++j) {
-                matrix_[i][j] += other[i][j];
+                matrix_[i][j] += other.matrix_[i][j];
             }
         }
         return *this;
@@ -77,7 +40,7 @@ namespace gre {
     Matrix4x4& Matrix4x4::operator-=(const Matrix4x4& other)& noexcept {
         for (uint32_t i = 0; i < 4; i++) {
             for (uint32_t j = 0; j < 4; ++j) {
-                matrix_[i][j] -= other[i][j];
+                matrix_[i][j] -= other.matrix_[i][j];
             }
         }
         return *this;
@@ -92,11 +55,6 @@ namespace gre {
         return *this;
     }
 
-    Matrix4x4& Matrix4x4::operator*=(const Matrix4x4& other)& noexcept {
-        *this = *this * other;
-        return *this;
-    }
-
     Matrix4x4& Matrix4x4::operator/=(double other)& noexcept {
         GRE_CHECK(!equality(other, 0.0), "division by zero");
 
@@ -128,26 +86,6 @@ namespace gre {
         return result *= other;
     }
 
-    Matrix4x4 Matrix4x4::operator*(const Matrix4x4& other) const noexcept {
-        Matrix4x4 result(0.0);
-        for (uint32_t i = 0; i < 4; ++i) {
-            for (uint32_t j = 0; j < 4; ++j) {
-                for (uint32_t k = 0; k < 4; ++k) {
-                    result[i][j] += matrix_[i][k] * other[k][j];
-                }
-            }
-        }
-        return result;
-    }
-
-    Vec3 Matrix4x4::operator*(const Vec3& other) const noexcept {
-        Vec3 result(0.0);
-        result.x = matrix_[0][0] * other[0] + matrix_[0][1] * other[1] + matrix_[0][2] * other[2] + matrix_[0][3];
-        result.y = matrix_[1][0] * other[0] + matrix_[1][1] * other[1] + matrix_[1][2] * other[2] + matrix_[1][3];
-        result.z = matrix_[2][0] * other[0] + matrix_[2][1] * other[1] + matrix_[2][2] * other[2] + matrix_[2][3];
-        return result;
-    }
-
     Matrix4x4 Matrix4x4::operator/(double other) const noexcept {
         GRE_CHECK(!equality(other, 0.0), "division by zero");
 
@@ -156,42 +94,33 @@ namespace gre {
     }
 
     // Math functions
-    Matrix4x4 Matrix4x4::transpose() const noexcept {
-        Matrix4x4 result;
-        for (uint32_t i = 0; i < 4; ++i) {
-            for (uint32_t j = 0; j < 4; ++j) {
-                result[j][i] = matrix_[i][j];
-            }
-        }
-        return result;
-    }
-
     Matrix4x4 Matrix4x4::inverse() const noexcept {
         Matrix4x4 result;
 
-        result[0][0] = algebraic_addition(1, 2, 3, 1, 2, 3);
-        result[1][0] = -algebraic_addition(1, 2, 3, 0, 2, 3);
-        result[2][0] = algebraic_addition(1, 2, 3, 0, 1, 3);
-        result[3][0] = -algebraic_addition(1, 2, 3, 0, 1, 2);
+        result.matrix_[0][0] = algebraic_addition(1, 2, 3, 1, 2, 3);
+        result.matrix_[1][0] = -algebraic_addition(1, 2, 3, 0, 2, 3);
+        result.matrix_[2][0] = algebraic_addition(1, 2, 3, 0, 1, 3);
+        result.matrix_[3][0] = -algebraic_addition(1, 2, 3, 0, 1, 2);
 
-        double det = result[0][0] * matrix_[0][0] + result[1][0] * matrix_[0][1] + result[2][0] * matrix_[0][2] + result[3][0] * matrix_[0][3];
+        result.matrix_[0][1] = -algebraic_addition(0, 2, 3, 1, 2, 3);
+        result.matrix_[1][1] = algebraic_addition(0, 2, 3, 0, 2, 3);
+        result.matrix_[2][1] = -algebraic_addition(0, 2, 3, 0, 1, 3);
+        result.matrix_[3][1] = algebraic_addition(0, 2, 3, 0, 1, 2);
 
-        GRE_CHECK(!equality(det, 0.0), "the matrix is not invertible");
+        result.matrix_[0][2] = algebraic_addition(0, 1, 3, 1, 2, 3);
+        result.matrix_[1][2] = -algebraic_addition(0, 1, 3, 0, 2, 3);
+        result.matrix_[2][2] = algebraic_addition(0, 1, 3, 0, 1, 3);
+        result.matrix_[3][2] = -algebraic_addition(0, 1, 3, 0, 1, 2);
 
-        result[0][1] = -algebraic_addition(0, 2, 3, 1, 2, 3);
-        result[1][1] = algebraic_addition(0, 2, 3, 0, 2, 3);
-        result[2][1] = -algebraic_addition(0, 2, 3, 0, 1, 3);
-        result[3][1] = algebraic_addition(0, 2, 3, 0, 1, 2);
+        result.matrix_[0][3] = -algebraic_addition(0, 1, 2, 1, 2, 3);
+        result.matrix_[1][3] = algebraic_addition(0, 1, 2, 0, 2, 3);
+        result.matrix_[2][3] = -algebraic_addition(0, 1, 2, 0, 1, 3);
+        result.matrix_[3][3] = algebraic_addition(0, 1, 2, 0, 1, 2);
 
-        result[0][2] = algebraic_addition(0, 1, 3, 1, 2, 3);
-        result[1][2] = -algebraic_addition(0, 1, 3, 0, 2, 3);
-        result[2][2] = algebraic_addition(0, 1, 3, 0, 1, 3);
-        result[3][2] = -algebraic_addition(0, 1, 3, 0, 1, 2);
+        // Checked after all cofactors are written, so the zero initialization of the result is dropped as dead stores
+        double det = result.matrix_[0][0] * matrix_[0][0] + result.matrix_[1][0] * matrix_[0][1] + result.matrix_[2][0] * matrix_[0][2] + result.matrix_[3][0] * matrix_[0][3];
 
-        result[0][3] = -algebraic_addition(0, 1, 2, 1, 2, 3);
-        result[1][3] = algebraic_addition(0, 1, 2, 0, 2, 3);
-        result[2][3] = -algebraic_addition(0, 1, 2, 0, 1, 3);
-        result[3][3] = algebraic_addition(0, 1, 2, 0, 1, 2);
+        GRE_CHECK(!equality(det, 0.0), "the matrix is not invertible");
 
         return result / det;
     }
@@ -201,75 +130,10 @@ namespace gre {
     }
 
     // Precalculated matrices
-    Matrix4x4 Matrix4x4::one_matrix() noexcept {
-        return Matrix4x4({
-            { 1.0, 0.0, 0.0, 0.0 },
-            { 0.0, 1.0, 0.0, 0.0 },
-            { 0.0, 0.0, 1.0, 0.0 },
-            { 0.0, 0.0, 0.0, 1.0 }
-        });
-    }
-
-    Matrix4x4 Matrix4x4::scale_matrix(double scale_x, double scale_y, double scale_z) noexcept {
-        return Matrix4x4({
-            { scale_x,     0.0,     0.0, 0.0 },
-            {     0.0, scale_y,     0.0, 0.0 },
-            {     0.0,     0.0, scale_z, 0.0 },
-            {     0.0,     0.0,     0.0, 1.0 }
-        });
-    }
-
-    Matrix4x4 Matrix4x4::scale_matrix(const Vec3& scale) noexcept {
-        return Matrix4x4({
-            { scale.x,     0.0,     0.0, 0.0 },
-            {     0.0, scale.y,     0.0, 0.0 },
-            {     0.0,     0.0, scale.z, 0.0 },
-            {     0.0,     0.0,     0.0, 1.0 }
-        });
-    }
-
-    Matrix4x4 Matrix4x4::scale_matrix(double scale) noexcept {
-        return Matrix4x4({
-            { scale,   0.0,   0.0, 0.0 },
-            {   0.0, scale,   0.0, 0.0 },
-            {   0.0,   0.0, scale, 0.0 },
-            {   0.0,   0.0,   0.0, 1.0 }
-        });
-    }
-
-    Matrix4x4 Matrix4x4::translation_matrix(const Vec3& translation) noexcept {
-        return Matrix4x4({
-            { 1.0, 0.0, 0.0, translation.x },
-            { 0.0, 1.0, 0.0, translation.y },
-            { 0.0, 0.0, 1.0, translation.z },
-            { 0.0, 0.0, 0.0,           1.0 }
-        });
-    }
-
     Matrix4x4 Matrix4x4::rotation_matrix(const Vec3& axis, double angle) noexcept {
         GRE_CHECK(!equality(axis.length(), 0.0), "the axis vector has zero length");
 
-        const Vec3& norm_axis = axis.normalize();
-        double x = norm_axis.x;
-        double y = norm_axis.y;
-        double z = norm_axis.z;
-        double c = cos(angle);
-        double s = sin(angle);
-
-        return Matrix4x4({
-            {     c + x * x * (1.0 - c), x * y * (1.0 - c) - z * s, x * z * (1.0 - c) + y * s, 0.0 },
-            { y * x * (1.0 - c) + z * s,     c + y * y * (1.0 - c), y * z * (1.0 - c) - x * s, 0.0 },
-            { z * x * (1.0 - c) - y * s, z * y * (1.0 - c) + x * s,     c + z * z * (1.0 - c), 0.0 },
-            {                       0.0,                       0.0,                       0.0, 1.0 }
-        });
-    }
-
-    Matrix4x4 Matrix4x4::rotation_matrix(const Quaternion& rotation_quaternion) noexcept {
-        Vec3 axis = rotation_quaternion.get_imaginary();
-        GRE_CHECK(axis.length() <= 1.0, "quaternion does not represent rotation");
-
-        double angle = 2.0 * atan2(axis.length(), rotation_quaternion.x);
-        return rotation_matrix(axis, angle);
+        return rotation_matrix(axis.normalize(), cos(angle), sin(angle));
     }
 
     // Private functions
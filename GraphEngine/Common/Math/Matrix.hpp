@@ -12,9 +12,19 @@ namespace gre {
 
     public:
         // Constructors
-        Matrix4x4() noexcept;
-
-        explicit Matrix4x4(double value) noexcept;
+        constexpr Matrix4x4() noexcept
+            : matrix_{}
+        {}
+
+        constexpr explicit Matrix4x4(double value) noexcept
+            : matrix_{}
+        {
+            for (uint32_t i = 0; i < 4; ++i) {
+                for (uint32_t j = 0; j < 4; ++j) {
+                    matrix_[i][j] = value;
+                }
+            }
+        }
 
         template <typename T>  // Casts required: double(T)
         Matrix4x4(const std::initializer_list<std::initializer_list<T>>& init) {
@@ -32,7 +42,16 @@ namespace gre {
             }
         }
 
-        Matrix4x4(const Vec3& vector_x, const Vec3& vector_y, const Vec3& vector_z) noexcept;
+        constexpr Matrix4x4(const Vec3& vector_x, const Vec3& vector_y, const Vec3& vector_z) noexcept
+            : matrix_{}
+        {
+            for (uint32_t i = 0; i < 3; ++i) {
+                matrix_[i][0] = vector_x[i];
+                matrix_[i][1] = vector_y[i];
+                matrix_[i][2] = vector_z[i];
+            }
+            matrix_[3][3] = 1.0;
+        }
 
         explicit Matrix4x4(const aiMatrix4x4& init) noexcept;
 
@@ -49,9 +68,17 @@ namespace gre {
             return result;
         }
 
-        double* operator[](size_t index);
+        constexpr double* operator[](size_t index) {
+            GRE_ENSURE_INDEX(index, 4);
+
+            return matrix_[index];
+        }
+
+        constexpr const double* operator[](size_t index) const {
+            GRE_ENSURE_INDEX(index, 4);
 
-        const double* operator[](size_t index) const;
+            return matrix_[index];
+        }
 
         bool operator==(const Matrix4x4& other) const noexcept;
 
@@ -63,7 +90,10 @@ namespace gre {
 
         Matrix4x4& operator*=(double other)& noexcept;
 
-        Matrix4x4& operator*=(const Matrix4x4& other)& noexcept;
+        constexpr Matrix4x4& operator*=(const Matrix4x4& other)& noexcept {
+            *this = *this * other;
+            return *this;
+        }
 
         Matrix4x4& operator/=(double other)& noexcept;
 
@@ -75,33 +105,118 @@ namespace gre {
 
         Matrix4x4 operator*(double other) const noexcept;
 
-        Matrix4x4 operator*(const Matrix4x4& other) const noexcept;
+        constexpr Matrix4x4 operator*(const Matrix4x4& other) const noexcept {
+            Matrix4x4 result;
+            for (uint32_t i = 0; i < 4; ++i) {
+                for (uint32_t j = 0; j < 4; ++j) {
+                    for (uint32_t k = 0; k < 4; ++k) {
+                        result.matrix_[i][j] += matrix_[i][k] * other.matrix_[k][j];
+                    }
+                }
+            }
+            return result;
+        }
 
-        Vec3 operator*(const Vec3& other) const noexcept;
+        constexpr Vec3 operator*(const Vec3& other) const noexcept {
+            return Vec3(
+                matrix_[0][0] * other.x + matrix_[0][1] * other.y + matrix_[0][2] * other.z + matrix_[0][3],
+                matrix_[1][0] * other.x + matrix_[1][1] * other.y + matrix_[1][2] * other.z + matrix_[1][3],
+                matrix_[2][0] * other.x + matrix_[2][1] * other.y + matrix_[2][2] * other.z + matrix_[2][3]
+            );
+        }
 
         Matrix4x4 operator/(double other) const noexcept;
 
         // Math functions
-        Matrix4x4 transpose() const noexcept;
+        constexpr Matrix4x4 transpose() const noexcept {
+            Matrix4x4 result;
+            for (uint32_t i = 0; i < 4; ++i) {
+                for (uint32_t j = 0; j < 4; ++j) {
+                    result.matrix_[j][i] = matrix_[i][j];
+                }
+            }
+            return result;
+        }
 
         Matrix4x4 inverse() const noexcept;
 
         static Matrix4x4 normal_transform(const Matrix4x4& transform) noexcept;
 
         // Precalculated matrices
-        static Matrix4x4 one_matrix() noexcept;
+        static constexpr Matrix4x4 one_matrix() noexcept {
+            return scale_matrix(1.0);
+        }
+
+        static constexpr Matrix4x4 scale_matrix(double scale_x, double scale_y, double scale_z) noexcept {
+            Matrix4x4 result;
+            result.matrix_[0][0] = scale_x;
+            result.matrix_[1][1] = scale_y;
+            result.matrix_[2][2] = scale_z;
+            result.matrix_[3][3] = 1.0;
+            return result;
+        }
 
-        static Matrix4x4 scale_matrix(double scale_x, double scale_y, double scale_z) noexcept;
+        static constexpr Matrix4x4 scale_matrix(const Vec3& scale) noexcept {
+            return scale_matrix(scale.x, scale.y, scale.z);
+        }
 
-        static Matrix4x4 scale_matrix(const Vec3& scale) noexcept;
+        static constexpr Matrix4x4 scale_matrix(double scale) noexcept {
+            return scale_matrix(scale, scale, scale);
+        }
 
-        static Matrix4x4 scale_matrix(double scale) noexcept;
+        static constexpr Matrix4x4 translation_matrix(const Vec3& translation) noexcept {
+            Matrix4x4 result = one_matrix();
+            result.matrix_[0][3] = translation.x;
+            result.matrix_[1][3] = translation.y;
+            result.matrix_[2][3] = translation.z;
+            return result;
+        }
 
-        static Matrix4x4 translation_matrix(const Vec3& translation) noexcept;
+        // Rotation around the unit axis by the angle with given cosine and sine
+        static constexpr Matrix4x4 rotation_matrix(const Vec3& axis, double cos_angle, double sin_angle) noexcept {
+            double x = axis.x;
+            double y = axis.y;
+            double z = axis.z;
+            double c = cos_angle;
+            double s = sin_angle;
+
+            Matrix4x4 result;
+            result.matrix_[0][0] = c + x * x * (1.0 - c);
+            result.matrix_[0][1] = x * y * (1.0 - c) - z * s;
+            result.matrix_[0][2] = x * z * (1.0 - c) + y * s;
+            result.matrix_[1][0] = y * x * (1.0 - c) + z * s;
+            result.matrix_[1][1] = c + y * y * (1.0 - c);
+            result.matrix_[1][2] = y * z * (1.0 - c) - x * s;
+            result.matrix_[2][0] = z * x * (1.0 - c) - y * s;
+            result.matrix_[2][1] = z * y * (1.0 - c) + x * s;
+            result.matrix_[2][2] = c + z * z * (1.0 - c);
+            result.matrix_[3][3] = 1.0;
+            return result;
+        }
 
         static Matrix4x4 rotation_matrix(const Vec3& axis, double angle) noexcept;
 
-        static Matrix4x4 rotation_matrix(const Quaternion& rotation_quaternion) noexcept;
+        // Quaternion is normalized, so any nonzero one gives a rotation
+        static constexpr Matrix4x4 rotation_matrix(const Quaternion& rotation_quaternion) noexcept {
+            double w = rotation_quaternion.x;
+            double x = rotation_quaternion.y;
+            double y = rotation_quaternion.u;
+            double z = rotation_quaternion.v;
+            double s = 2.0 / (w * w + x * x + y * y + z * z);
+
+            Matrix4x4 result;
+            result.matrix_[0][0] = 1.0 - s * (y * y + z * z);
+            result.matrix_[0][1] = s * (x * y - z * w);
+            result.matrix_[0][2] = s * (x * z + y * w);
+            result.matrix_[1][0] = s * (x * y + z * w);
+            result.matrix_[1][1] = 1.0 - s * (x * x + z * z);
+            result.matrix_[1][2] = s * (y * z - x * w);
+            result.matrix_[2][0] = s * (x * z - y * w);
+            result.matrix_[2][1] = s * (y * z + x * w);
+            result.matrix_[2][2] = 1.0 - s * (x * x + y * y);
+            result.matrix_[3][3] = 1.0;
+            return result;
+        }
     };
 
     // External operators
@@ -3,54 +3,7 @@
 
 // Quaternion
 namespace gre {
-    // Constructors
-    Quaternion::Quaternion() noexcept {
-    }
-
-    Quaternion::Quaternion(double value) noexcept
-        : x(value)
-        , y(0.0)
-        , u(0.0)
-        , v(0.0)
-    {}
-
-    Quaternion::Quaternion(double real, const Vec3& imaginary) noexcept
-        : x(real)
-        , y(imaginary.x)
-        , u(imaginary.y)
-        , v(imaginary.z)
-    {}
-
-    Quaternion::Quaternion(double x, double y, double u, double v) noexcept
-        : x(x)
-        , y(y)
-        , u(u)
-        , v(v)
-    {}
-
     // Operators
-    double& Quaternion::operator[](size_t index) {
-        GRE_ENSURE(index <= 3, GreOutOfRange, "index out of range");
-
-        switch (index) {
-            case 0: return x;
-            case 1: return y;
-            case 2: return u;
-            case 3: return v;
-        }
-    }
-
-    const double& Quaternion::operator[](size_t index) const {
-        GRE_ENSURE(index <= 3, GreOutOfRange, "index out of range");
-
-        switch (index) {
-            case 0: return x;
-            case 1: return y;
-            case 2: return u;
-            case 3: return v;
-        }
-    }
-
     bool Quaternion::operator==(const Quaternion& other) const noexcept {
         return equality(x, other.x) && equality(y, other.y) && equality(u, other.u) && equality(v, other.v);
     }
@@ -13,13 +13,29 @@ namespace gre {
         double v = 0.0;
 
         // Constructors
-        Quaternion() noexcept;
-        
-        explicit Quaternion(double value) noexcept;
-
-        Quaternion(double real, const Vec3& imaginary) noexcept;
+        constexpr Quaternion() noexcept {
+        }
 
-        Quaternion(double x, double y, double u, double v) noexcept;
+        constexpr explicit Quaternion(double value) noexcept
+            : x(value)
+            , y(0.0)
+            , u(0.0)
+            , v(0.0)
+        {}
+
+        constexpr Quaternion(double real, const Vec3& imaginary) noexcept
+            : x(real)
+            , y(imaginary.x)
+            , u(imaginary.y)
+            , v(imaginary.z)
+        {}
+
+        constexpr Quaternion(double x, double y, double u, double v) noexcept
+            : x(x)
+            , y(y)
+            , u(u)
+            , v(v)
+        {}
 
         template <typename T>  // Casts required: double(T)
         Quaternion(const std::initializer_list<T>& init) {
@@ -32,9 +48,17 @@ namespace gre {
         }
 
         // Operators
-        double& operator[](size_t index);
+        constexpr double& operator[](size_t index) {
+            GRE_ENSURE_INDEX(index, 4);
+
+            return index == 0 ? x : (index == 1 ? y : (index == 2 ? u : v));
+        }
+
+        constexpr const double& operator[](size_t index) const {
+            GRE_ENSURE_INDEX(index, 4);
 
-        const double& operator[](size_t index) const;
+            return index == 0 ? x : (index == 1 ? y : (index == 2 ? u : v));
+        }
 
         bool operator==(const Quaternion& other) const noexcept;
 
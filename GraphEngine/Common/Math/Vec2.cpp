@@ -4,19 +4,6 @@
 // Vec2
 namespace gre {
     // Constructors
-    Vec2::Vec2() noexcept {
-    }
-
-    Vec2::Vec2(double value) noexcept
-        : x(value)
-        , y(value)
-    {}
-
-    Vec2::Vec2(double x, double y) noexcept
-        : x(x)
-        , y(y)
-    {}
-
     Vec2::Vec2(const sf::Vector2f& init) noexcept
         : x(init.x)
         , y(init.y)
@@ -32,18 +19,6 @@ namespace gre {
         return sf::Vector2f(static_cast<float>(x), static_cast<float>(y));
     }
 
-    double& Vec2::operator[](size_t index) {
-        GRE_ENSURE(index <= 1, GreOutOfRange, "index out of range");
-
-        return index == 0 ? x : y;
-    }
-
-    const double& Vec2::operator[](size_t index) const {
-        GRE_ENSURE(index <= 1, GreOutOfRange, "index out of range");
-
-        return index == 0 ? x : y;
-    }
-
     bool Vec2::operator==(const Vec2& other) const noexcept {
         return equality(x, other.x) && equality(y, other.y);
     }
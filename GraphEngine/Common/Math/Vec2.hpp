@@ -15,11 +15,18 @@ namespace gre {
         double y = 0.0;
 
         // Constructors
-        Vec2() noexcept;
+        constexpr Vec2() noexcept {
+        }
 
-        explicit Vec2(double value) noexcept;
+        constexpr explicit Vec2(double value) noexcept
+            : x(value)
+            , y(value)
+        {}
 
-        Vec2(double x, double y) noexcept;
+        constexpr Vec2(double x, double y) noexcept
+            : x(x)
+            , y(y)
+        {}
 
         template <typename T>  // Casts required: double(T)
         Vec2(const std::initializer_list<T>& init) {
@@ -38,9 +45,17 @@ namespace gre {
         // Operators
         explicit operator sf::Vector2f() const;
 
-        double& operator[](size_t index);
+        constexpr double& operator[](size_t index) {
+            GRE_ENSURE_INDEX(index, 2);
+
+            return index == 0 ? x : y;
+        }
 
-        const double& operator[](size_t index) const;
+        constexpr const double& operator[](size_t index) const {
+            GRE_ENSURE_INDEX(index, 2);
+
+            return index == 0 ? x : y;
+        }
 
         bool operator==(const Vec2& other) const noexcept;
 
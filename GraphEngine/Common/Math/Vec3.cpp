@@ -4,33 +4,6 @@
 // Vec3
 namespace gre {
     // Constructors
-    Vec3::Vec3() noexcept {
-    }
-
-    Vec3::Vec3(double value) noexcept
-        : x(value)
-        , y(value)
-        , z(value)
-    {}
-
-    Vec3::Vec3(double x, double y, double z) noexcept
-        : x(x)
-        , y(y)
-        , z(z)
-    {}
-
-    Vec3::Vec3(const Vec2& xy, double z) noexcept
-        : x(xy.x)
-        , y(xy.y)
-        , z(z)
-    {}
-
-    Vec3::Vec3(double x, const Vec2& yz) noexcept
-        : x(x)
-        , y(yz.x)
-        , z(yz.y)
-    {}
-
     Vec3::Vec3(const sf::Color& color) noexcept
         : x(color.r)
         , y(color.g)
@@ -50,26 +23,6 @@ namespace gre {
     {}
 
     // Operators
-    double& Vec3::operator[](size_t index) {
-        GRE_ENSURE(index <= 2, GreOutOfRange, "index out of range");
-
-        switch (index) {
-            case 0: return x;
-            case 1: return y;
-            case 2: return z;
-        }
-    }
-
-    const double& Vec3::operator[](size_t index) const {
-        GRE_ENSURE(index <= 2, GreOutOfRange, "index out of range");
-
-        switch (index) {
-            case 0: return x;
-            case 1: return y;
-            case 2: return z;
-        }
-    }
-
     bool Vec3::operator==(const Vec3& other) const noexcept {
         return equality(x, other.x) && equality(y, other.y) && equality(z, other.z);
     }
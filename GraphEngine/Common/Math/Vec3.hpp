@@ -13,15 +13,32 @@ namespace gre {
         double z = 0.0;
 
         // Constructors
-        Vec3() noexcept;
-
-        explicit Vec3(double value) noexcept;
-
-        Vec3(double x, double y, double z) noexcept;
-
-        Vec3(const Vec2& xy, double z) noexcept;
+        constexpr Vec3() noexcept {
+        }
 
-        Vec3(double x, const Vec2& yz) noexcept;
+        constexpr explicit Vec3(double value) noexcept
+            : x(value)
+            , y(value)
+            , z(value)
+        {}
+
+        constexpr Vec3(double x, double y, double z) noexcept
+            : x(x)
+            , y(y)
+            , z(z)
+        {}
+
+        constexpr Vec3(const Vec2& xy, double z) noexcept
+            : x(xy.x)
+            , y(xy.y)
+            , z(z)
+        {}
+
+        constexpr Vec3(double x, const Vec2& yz) noexcept
+            : x(x)
+            , y(yz.x)
+            , z(yz.y)
+        {}
 
         template <typename T>  // Casts required: double(T)
         Vec3(const std::initializer_list<T>& init) {
@@ -40,9 +57,17 @@ namespace gre {
         explicit Vec3(const aiVector3D& init) noexcept;
 
         // Operators
-        double& operator[](size_t index);
+        constexpr double& operator[](size_t index) {
+            GRE_ENSURE_INDEX(index, 3);
 
-        const double& operator[](size_t index) const;
+            return index == 0 ? x : (index == 1 ? y : z);
+        }
+
+        constexpr const double& operator[](size_t index) const {
+            GRE_ENSURE_INDEX(index, 3);
+
+            return index == 0 ? x : (index == 1 ? y : z);
+        }
 
         bool operator==(const Vec3& other) const noexcept;
 
@@ -0,0 +1,141 @@
+#include "AtlasAllocator.hpp"
+
+
+// AtlasAllocator
+namespace gre {
+    // Tile
+    bool AtlasAllocator::Tile::operator==(const Tile& other) const noexcept {
+        return page == other.page && level == other.level && x == other.x && y == other.y;
+    }
+
+    bool AtlasAllocator::Tile::operator!=(const Tile& other) const noexcept {
+        return !(*this == other);
+    }
+
+    bool AtlasAllocator::Tile::operator<(const Tile& other) const noexcept {
+        if (page != other.page) {
+            return page < other.page;
+        }
+        if (level != other.level) {
+            return level < other.level;
+        }
+        if (y != other.y) {
+            return y < other.y;
+        }
+        return x < other.x;
+    }
+
+    // Constructors
+    AtlasAllocator::AtlasAllocator(size_t max_level, size_t count_pages) {
+        max_level_ = max_level;
+        free_tiles_.resize(max_level_ + 1);
+        grow(count_pages);
+    }
+
+    // Getters
+    size_t AtlasAllocator::get_count_pages() const noexcept {
+        return count_pages_;
+    }
+
+    size_t AtlasAllocator::get_max_level() const noexcept {
+        return max_level_;
+    }
+
+    double AtlasAllocator::get_usage() const noexcept {
+        if (count_pages_ == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(used_) / static_cast<double>(count_pages_ * get_area(0));
+    }
+
+    // Allocation
+    std::optional<AtlasAllocator::Tile> AtlasAllocator::allocate(size_t level) {
+        GRE_ENSURE(level <= max_level_, GreInvalidArgument, "invalid tile level for allocation");
+
+        size_t free_level = level + 1;
+        while (free_level > 0 && free_tiles_[free_level - 1].empty()) {
+            --free_level;
+        }
+        if (free_level == 0) {
+            return std::nullopt;
+        }
+
+        Tile tile = *free_tiles_[free_level - 1].begin();
+        free_tiles_[free_level - 1].erase(free_tiles_[free_level - 1].begin());
+
+        // The first quarter is split further, the other three become free
+        while (tile.level < level) {
+            tile = Tile{ tile.page, tile.level + 1, 2 * tile.x, 2 * tile.y };
+            free_tiles_[tile.level].insert(Tile{ tile.page, tile.level, tile.x + 1, tile.y });
+            free_tiles_[tile.level].insert(Tile{ tile.page, tile.level, tile.x, tile.y + 1 });
+            free_tiles_[tile.level].insert(Tile{ tile.page, tile.level, tile.x + 1, tile.y + 1 });
+        }
+
+        used_ += get_area(level);
+        return tile;
+    }
+
+    void AtlasAllocator::deallocate(const Tile& tile) {
+        GRE_ENSURE(tile.page < count_pages_ && tile.level <= max_level_ && get_area(tile.level) <= used_, GreInvalidArgument, "invalid tile for deallocation");
+
+        used_ -= get_area(tile.level);
+        insert_free_tile(tile);
+    }
+
+    void AtlasAllocator::grow(size_t count_pages) {
+        if (count_pages <= count_pages_) {
+            return;
+        }
+
+        for (size_t page = count_pages_; page < count_pages; ++page) {
+            free_tiles_[0].insert(Tile{ page, 0, 0, 0 });
+        }
+        count_pages_ = count_pages;
+    }
+
+    void AtlasAllocator::clear() noexcept {
+        count_pages_ = 0;
+        used_ = 0;
+        for (std::set<Tile>& free_tiles : free_tiles_) {
+            free_tiles.clear();
+        }
+    }
+
+    // Private functions
+    void AtlasAllocator::insert_free_tile(const Tile& tile) {
+        std::set<Tile>& free_tiles = free_tiles_[tile.level];
+        GRE_ENSURE(free_tiles.count(tile) == 0, GreInvalidArgument, "tile is already free");
+
+        if (tile.level == 0) {
+            free_tiles.insert(tile);
+            return;
+        }
+
+        // Merge with the neighbours inside of the parent tile
+        size_t parent_x = tile.x / 2;
+        size_t parent_y = tile.y / 2;
+        std::vector<std::set<Tile>::iterator> neighbours;
+        for (size_t i = 0; i < 4; ++i) {
+            Tile neighbour = Tile{ tile.page, tile.level, 2 * parent_x + i % 2, 2 * parent_y + i / 2 };
+            if (neighbour == tile) {
+                continue;
+            }
+
+            auto iterator = free_tiles.find(neighbour);
+            if (iterator == free_tiles.end()) {
+                free_tiles.insert(tile);
+                return;
+            }
+            neighbours.push_back(iterator);
+        }
+
+        for (auto iterator : neighbours) {
+            free_tiles.erase(iterator);
+        }
+        insert_free_tile(Tile{ tile.page, tile.level - 1, parent_x, parent_y });
+    }
+
+    size_t AtlasAllocator::get_area(size_t level) const noexcept {
+        return static_cast<size_t>(1) << (2 * (max_level_ - level));
+    }
+}  // namespace gre
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <optional>
+#include <set>
+#include <vector>
+#include "Functions.hpp"
+
+
+// Suballocator of square tiles inside equal square pages, the side of a tile is the page side divided by 2^level
+namespace gre {
+    class AtlasAllocator {
+    public:
+        struct Tile {
+            size_t page = 0;
+            size_t level = 0;
+            size_t x = 0;  // Position in tiles of the same level
+            size_t y = 0;
+
+            bool operator==(const Tile& other) const noexcept;
+
+            bool operator!=(const Tile& other) const noexcept;
+
+            // Ordered by page, so allocations are packed into the first pages
+            bool operator<(const Tile& other) const noexcept;
+        };
+
+    private:
+        size_t count_pages_ = 0;
+        size_t max_level_ = 0;
+        size_t used_ = 0;  // Area in tiles of the max level
+
+        // Free tiles of each level, four free neighbours are merged into the tile of the previous level
+        std::vector<std::set<Tile>> free_tiles_;
+
+        void insert_free_tile(const Tile& tile);
+
+        size_t get_area(size_t level) const noexcept;
+
+    public:
+        // Constructors
+        AtlasAllocator() noexcept = default;
+
+        explicit AtlasAllocator(size_t max_level, size_t count_pages = 0);
+
+        // Getters
+        size_t get_count_pages() const noexcept;
+
+        size_t get_max_level() const noexcept;
+
+        // Used part of the area of all pages
+        double get_usage() const noexcept;
+
+        // Allocation, the smallest fitting free tile is split
+        std::optional<Tile> allocate(size_t level);
+
+        void deallocate(const Tile& tile);
+
+        // Appends empty pages
+        void grow(size_t count_pages);
+
+        void clear() noexcept;
+    };
+}  // namespace gre
@@ -0,0 +1,98 @@
+#include "FreeListAllocator.hpp"
+
+
+// FreeListAllocator
+namespace gre {
+    // Constructors
+    FreeListAllocator::FreeListAllocator(size_t capacity) {
+        grow(capacity);
+    }
+
+    // Getters
+    size_t FreeListAllocator::get_capacity() const noexcept {
+        return capacity_;
+    }
+
+    size_t FreeListAllocator::get_used() const noexcept {
+        return used_;
+    }
+
+    size_t FreeListAllocator::get_count_free_ranges() const noexcept {
+        return free_ranges_.size();
+    }
+
+    // Allocation
+    std::optional<size_t> FreeListAllocator::allocate(size_t size) {
+        if (size == 0) {
+            return 0;
+        }
+
+        for (auto iterator = free_ranges_.begin(); iterator != free_ranges_.end(); ++iterator) {
+            auto [offset, range_size] = *iterator;
+            if (range_size < size) {
+                continue;
+            }
+
+            free_ranges_.erase(iterator);
+            if (range_size > size) {
+                free_ranges_.emplace(offset + size, range_size - size);
+            }
+
+            used_ += size;
+            return offset;
+        }
+        return std::nullopt;
+    }
+
+    void FreeListAllocator::deallocate(size_t offset, size_t size) {
+        if (size == 0) {
+            return;
+        }
+
+        GRE_ENSURE(offset + size <= capacity_ && size <= used_, GreInvalidArgument, "invalid range for deallocation");
+
+        used_ -= size;
+        insert_free_range(offset, size);
+    }
+
+    void FreeListAllocator::grow(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+
+        size_t offset = capacity_;
+        capacity_ = capacity;
+        insert_free_range(offset, capacity - offset);
+    }
+
+    void FreeListAllocator::clear() noexcept {
+        capacity_ = 0;
+        used_ = 0;
+        free_ranges_.clear();
+    }
+
+    // Private functions
+    void FreeListAllocator::insert_free_range(size_t offset, size_t size) {
+        auto next = free_ranges_.lower_bound(offset);
+        GRE_ENSURE(next == free_ranges_.end() || offset + size <= next->first, GreInvalidArgument, "range is already free");
+
+        // Merge with the next free range
+        if (next != free_ranges_.end() && offset + size == next->first) {
+            size += next->second;
+            next = free_ranges_.erase(next);
+        }
+
+        // Merge with the previous free range
+        if (next != free_ranges_.begin()) {
+            auto previous = std::prev(next);
+            GRE_ENSURE(previous->first + previous->second <= offset, GreInvalidArgument, "range is already free");
+
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+
+        free_ranges_.emplace(offset, size);
+    }
+}  // namespace gre
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include "Functions.hpp"
+
+
+// Suballocator of ranges inside a linear storage, free ranges are merged on deallocation
+namespace gre {
+    class FreeListAllocator {
+        size_t capacity_ = 0;
+        size_t used_ = 0;
+
+        // Offset to size of free ranges
+        std::map<size_t, size_t> free_ranges_;
+
+        void insert_free_range(size_t offset, size_t size);
+
+    public:
+        // Constructors
+        FreeListAllocator() noexcept = default;
+
+        explicit FreeListAllocator(size_t capacity);
+
+        // Getters
+        size_t get_capacity() const noexcept;
+
+        size_t get_used() const noexcept;
+
+        size_t get_count_free_ranges() const noexcept;
+
+        // Allocation, first fitting range is used
+        std::optional<size_t> allocate(size_t size);
+
+        void deallocate(size_t offset, size_t size);
+
+        // Appends free space to the end of the storage
+        void grow(size_t capacity);
+
+        void clear() noexcept;
+    };
+}  // namespace gre
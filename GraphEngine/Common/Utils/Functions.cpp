@@ -3,6 +3,43 @@
 
 namespace {
     bool GLEW_IS_OK = false;
+    gre::GlErrorMode GL_ERROR_MODE = gre::GlErrorMode::NONE;
+
+    [[maybe_unused]] const char* get_gl_debug_source_name(GLenum source) noexcept {
+        switch (source) {
+            case GL_DEBUG_SOURCE_API:             return "API";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "WINDOW_SYSTEM";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER_COMPILER";
+            case GL_DEBUG_SOURCE_THIRD_PARTY:     return "THIRD_PARTY";
+            case GL_DEBUG_SOURCE_APPLICATION:     return "APPLICATION";
+            default:                              return "OTHER";
+        }
+    }
+
+    [[maybe_unused]] const char* get_gl_debug_type_name(GLenum type) noexcept {
+        switch (type) {
+            case GL_DEBUG_TYPE_ERROR:               return "ERROR";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED_BEHAVIOR";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "UNDEFINED_BEHAVIOR";
+            case GL_DEBUG_TYPE_PORTABILITY:         return "PORTABILITY";
+            case GL_DEBUG_TYPE_PERFORMANCE:         return "PERFORMANCE";
+            default:                                return "OTHER";
+        }
+    }
+
+    // Separate call sites keep errors from being rate limited together with performance hints, low severity hints are only informational,
+    // source, id and message are unused when GRE_LOG_MIN_LEVEL compiles the log macros out
+    void GLAPIENTRY log_gl_debug_message([[maybe_unused]] GLenum source, GLenum type, [[maybe_unused]] GLuint id, GLenum severity, GLsizei /*length*/, [[maybe_unused]] const GLchar* message, const void* /*user_param*/) {
+        if (severity == GL_DEBUG_SEVERITY_NOTIFICATION || (type == GL_DEBUG_TYPE_PERFORMANCE && severity == GL_DEBUG_SEVERITY_LOW)) {
+            GRE_LOG_INFO("GL debug message " << id << " from " << get_gl_debug_source_name(source) << ": " << message);
+        }
+        else if (type == GL_DEBUG_TYPE_ERROR) {
+            GRE_LOG_WARNING("GL error " << id << " from " << get_gl_debug_source_name(source) << ": " << message);
+        }
+        else {
+            GRE_LOG_WARNING("GL debug message " << id << " of type " << get_gl_debug_type_name(type) << " from " << get_gl_debug_source_name(source) << ": " << message);
+        }
+    }
 }  // anonymous namespace
 
 
@@ -26,25 +63,6 @@ namespace gre {
 }  // namespace gre
 
 
-// MainLog
-namespace gre {
-    LogManager::LogManager() {
-    }
-
-    LogManager* LogManager::GetInstance() {
-        if (log_manager_ == nullptr) {
-            log_manager_ = new LogManager();
-        }
-        return log_manager_;
-    }
-
-    std::ofstream& LogManager::log_stream() noexcept {
-        log_out_.open("gre_log.txt");
-        return log_out_;
-    }
-}  // namespace gre
-
-
 // Common functions
 namespace gre {
     // Comparing
@@ -56,6 +74,14 @@ namespace gre {
         return left < right || equality(left, right);
     }
 
+    // Errors
+    void throw_index_error(const char* filename, const char* function, uint32_t line, size_t index) {
+        std::string message = "index " + std::to_string(index) + " out of range";
+        LogManager::GetInstance()->push(LogLevel::ERROR_LEVEL, filename, function, line, std::string(message));
+
+        throw GreOutOfRange(filename, function, line, message);
+    }
+
     // Work with strings
     std::vector<std::string> split(const std::string& str, std::function<bool(char)> pred) {
         std::vector<std::string> split_str(1);
@@ -79,4 +105,52 @@ namespace gre {
         glewExperimental = GL_TRUE;
         return GLEW_IS_OK = GLEW_IS_OK ? true : glewInit() == GLEW_OK;
     }
+
+    // GL errors
+    void set_gl_error_mode(GlErrorMode mode) {
+        GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
+
+        bool debug_output = mode == GlErrorMode::DEBUG_CALLBACK || mode == GlErrorMode::DEBUG_CALLBACK_SYNCHRONOUS;
+        if (debug_output && !GLEW_KHR_debug) {
+            GRE_LOG_WARNING("KHR_debug is not supported, GL errors are not reported");
+            mode = GlErrorMode::NONE;
+            debug_output = false;
+        }
+#ifndef GRE_CHECK_GL_CALLS
+        GRE_CHECK(mode != GlErrorMode::CHECK_CALLS, "GL calls are checked only if GRE_CHECK_GL_CALLS is defined");
+#endif // !GRE_CHECK_GL_CALLS
+
+        if (GLEW_KHR_debug) {
+            if (debug_output) {
+                glDebugMessageCallback(&log_gl_debug_message, nullptr);
+#ifdef GRE_INFO_LOG_ENABLED
+                glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_TRUE);
+                glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_SEVERITY_LOW, 0, nullptr, GL_TRUE);
+#else // GRE_INFO_LOG_ENABLED
+                glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+                glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_SEVERITY_LOW, 0, nullptr, GL_FALSE);
+#endif // !GRE_INFO_LOG_ENABLED
+                glEnable(GL_DEBUG_OUTPUT);
+            }
+            else {
+                glDisable(GL_DEBUG_OUTPUT);
+                glDebugMessageCallback(nullptr, nullptr);
+            }
+
+            if (mode == GlErrorMode::DEBUG_CALLBACK_SYNCHRONOUS) {
+                glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            }
+            else {
+                glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            }
+        }
+
+        // Errors raised before the switch are not attributed to the next checked call
+        while (glGetError() != GL_NO_ERROR) {}
+        GL_ERROR_MODE = mode;
+    }
+
+    GlErrorMode get_gl_error_mode() noexcept {
+        return GL_ERROR_MODE;
+    }
 }  // namespace gre
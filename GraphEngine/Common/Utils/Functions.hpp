@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include "LogManager.hpp"
 
 
 // GRE global constants
@@ -49,39 +50,38 @@ namespace gre {
 
 // GRE main log storage
 namespace gre {
-    // GRE main log manager
-    class LogManager {
-    private:
-        inline static LogManager* log_manager_ = nullptr;
+    // Messages below the level are compiled out: 0 info, 1 warning, 2 error
+#ifndef GRE_LOG_MIN_LEVEL
+#define GRE_LOG_MIN_LEVEL 1
+#endif // !GRE_LOG_MIN_LEVEL
 
-        std::ofstream log_out_;
-
-        LogManager();
-
-    public:
-        LogManager(const LogManager& other) = delete;
-
-        void operator=(const LogManager&) = delete;
-
-        static LogManager* GetInstance();
-
-        std::ofstream& log_stream() noexcept;
-    };
+#if GRE_LOG_MIN_LEVEL <= 0
+#define GRE_INFO_LOG_ENABLED
+#endif // GRE_LOG_MIN_LEVEL <= 0
 
+#if GRE_LOG_MIN_LEVEL <= 1
 #define GRE_WARNING_LOG_ENABLED
+#endif // GRE_LOG_MIN_LEVEL <= 1
 
-    // GRE log functions
-#define GRE_LOG_MESSAGE(stream, type)                                                                       \
+    // GRE log functions, the stream is formatted only for messages passing the runtime level and the rate limit of the call site
+#define GRE_LOG_MESSAGE(stream, level)                                                                      \
     do {                                                                                                    \
-        auto log_stream(std::move(gre::LogManager::GetInstance()->log_stream()));                           \
-        log_stream << type << " in file: " << __FILE__;                                                     \
-        log_stream << ", function: " << __func__;                                                           \
-        log_stream << ", line: " << __LINE__;                                                               \
-        log_stream << "\n" << stream << "\n\n";                                                             \
-        log_stream.close();                                                                                 \
-    } while (false)  
+        if (!gre::LogManager::is_enabled(level)) {                                                          \
+            break;                                                                                          \
+        }                                                                                                   \
+                                                                                                            \
+        static gre::LogSite log_site;                                                                       \
+        if (!log_site.allow()) {                                                                            \
+            break;                                                                                          \
+        }                                                                                                   \
+                                                                                                            \
+        std::ostringstream log_stream;                                                                      \
+        log_stream << stream;                                                                               \
+        gre::LogManager::GetInstance()->push(                                                               \
+            level, __FILE__, __func__, __LINE__, log_stream.str(), log_site.take_suppressed());             \
+    } while (false)
 
-#define GRE_LOG_ERROR(stream) GRE_LOG_MESSAGE(stream, "ERROR")
+#define GRE_LOG_ERROR(stream) GRE_LOG_MESSAGE(stream, gre::LogLevel::ERROR_LEVEL)
 
 #define GRE_ENSURE(condition, error_type, stream)                                                           \
     do {                                                                                                    \
@@ -93,10 +93,40 @@ namespace gre {
         }                                                                                                   \
     } while (false)
 
+    // Element access of math classes checks indices only if GRE_CHECKED_MATH is nonzero, by default in debug builds
+#ifndef GRE_CHECKED_MATH
+#ifdef _DEBUG
+#define GRE_CHECKED_MATH 1
+#else // _DEBUG
+#define GRE_CHECKED_MATH 0
+#endif // !_DEBUG
+#endif // !GRE_CHECKED_MATH
+
+#if GRE_CHECKED_MATH
+#define GRE_ENSURE_INDEX(index, size)                                                                       \
+    do {                                                                                                    \
+        if ((index) >= (size)) {                                                                            \
+            gre::throw_index_error(__FILE__, __func__, __LINE__, index);                                    \
+        }                                                                                                   \
+    } while (false)
+#else // GRE_CHECKED_MATH
+#define GRE_ENSURE_INDEX(index, size)
+#endif // !GRE_CHECKED_MATH
+
+
+#ifdef GRE_INFO_LOG_ENABLED
+
+    #define GRE_LOG_INFO(stream) GRE_LOG_MESSAGE(stream, gre::LogLevel::INFO_LEVEL)
+
+#else
+
+    #define GRE_LOG_INFO(stream)
+
+#endif
 
 #ifdef GRE_WARNING_LOG_ENABLED
 
-    #define GRE_LOG_WARNING(stream) GRE_LOG_MESSAGE(stream, "WARNING")
+    #define GRE_LOG_WARNING(stream) GRE_LOG_MESSAGE(stream, gre::LogLevel::WARNING_LEVEL)
     
     #define GRE_CHECK(condition, stream)                                                                    \
         do {                                                                                                \
@@ -105,8 +135,15 @@ namespace gre {
             }                                                                                               \
         } while (false)
 
+    // Each glGetError may stall the pipeline, so calls are checked only if requested at compile time and at runtime
+#ifdef GRE_CHECK_GL_CALLS
+
     #define GRE_CHECK_GL_ERRORS                                                                             \
         do {                                                                                                \
+            if (gre::get_gl_error_mode() != gre::GlErrorMode::CHECK_CALLS) {                                \
+                break;                                                                                      \
+            }                                                                                               \
+                                                                                                            \
             GLenum error_code = glGetError();                                                               \
             if (error_code == GL_NO_ERROR) {                                                                \
                 break;                                                                                      \
@@ -127,6 +164,12 @@ namespace gre {
             GRE_LOG_WARNING("GL error with name \"" << error << "\"");                                      \
         } while (false)
 
+#else // GRE_CHECK_GL_CALLS
+
+    #define GRE_CHECK_GL_ERRORS
+
+#endif // !GRE_CHECK_GL_CALLS
+
 #else
 
     #define GRE_LOG_WARNING(stream)
@@ -145,6 +188,9 @@ namespace gre {
     // GRE less or equality checking up to the EPS value
     bool less_equality(double left, double right) noexcept;
 
+    // GRE logging and throwing GreOutOfRange, out of line so that checked element access stays constexpr
+    [[noreturn]] void throw_index_error(const char* filename, const char* function, uint32_t line, size_t index);
+
     // GRE split string by given predicate
     std::vector<std::string> split(const std::string& str, std::function<bool(char)> pred);
 
@@ -156,4 +202,25 @@ namespace gre {
 
     // GLEW initialization
     bool glew_is_ok() noexcept;
+
+    // Reporting of GL errors, GRE_CHECK_GL_ERRORS works only in the CHECK_CALLS mode
+    enum class GlErrorMode {
+        NONE,
+        DEBUG_CALLBACK,              // KHR_debug messages, the driver may report them later and from its own thread
+        DEBUG_CALLBACK_SYNCHRONOUS,  // KHR_debug messages reported inside the failed call, slows down the driver
+        CHECK_CALLS                  // glGetError after the checked calls, requires GRE_CHECK_GL_CALLS
+    };
+
+#ifdef GRE_CHECK_GL_CALLS
+    constexpr GlErrorMode DEFAULT_GL_ERROR_MODE = GlErrorMode::CHECK_CALLS;
+#elif defined(GRE_WARNING_LOG_ENABLED)
+    constexpr GlErrorMode DEFAULT_GL_ERROR_MODE = GlErrorMode::DEBUG_CALLBACK;
+#else // GRE_WARNING_LOG_ENABLED
+    constexpr GlErrorMode DEFAULT_GL_ERROR_MODE = GlErrorMode::NONE;
+#endif // !GRE_WARNING_LOG_ENABLED
+
+    // Debug output is the state of the current context, the mode falls back to NONE without KHR_debug
+    void set_gl_error_mode(GlErrorMode mode);
+
+    GlErrorMode get_gl_error_mode() noexcept;
 }  // namespace gre
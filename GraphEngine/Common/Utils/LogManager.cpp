@@ -0,0 +1,228 @@
+#include "LogManager.hpp"
+
+
+// LogSite
+namespace gre {
+    bool LogSite::allow() noexcept {
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window_start = window_start_.load(std::memory_order_relaxed);
+        if (now - window_start >= WINDOW_DURATION && window_start_.compare_exchange_strong(window_start, now, std::memory_order_relaxed)) {
+            count_messages_.store(0, std::memory_order_relaxed);
+        }
+
+        if (count_messages_.fetch_add(1, std::memory_order_relaxed) < MAX_COUNT_MESSAGES) {
+            return true;
+        }
+        count_suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t LogSite::take_suppressed() noexcept {
+        return count_suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+}  // namespace gre
+
+
+// LogManager
+namespace gre {
+    // Constructors
+    LogManager::LogManager() {
+        for (size_t position = 0; position < QUEUE_SIZE; ++position) {
+            slots_[position].sequence.store(position, std::memory_order_relaxed);
+        }
+
+        writer_ = std::thread(&LogManager::write_messages, this);
+        std::atexit(&LogManager::stop_writer);
+    }
+
+    LogManager* LogManager::GetInstance() {
+        // Never destroyed, so messages from static destructors still have a target
+        static LogManager* log_manager = new LogManager();
+        return log_manager;
+    }
+
+    // Setters
+    void LogManager::set_level(LogLevel level) noexcept {
+        level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    void LogManager::set_log_file(const std::string& path, bool append) {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        log_out_.close();
+        log_path_ = path;
+        append_ = append;
+        open_log_file();
+    }
+
+    // Getters
+    LogLevel LogManager::get_level() noexcept {
+        return static_cast<LogLevel>(level_.load(std::memory_order_relaxed));
+    }
+
+    size_t LogManager::get_count_dropped() const noexcept {
+        return count_dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Logging
+    void LogManager::push(LogLevel level, const char* filename, const char* function, uint32_t line, std::string&& message, uint32_t count_suppressed) {
+        Record record;
+        record.level = level;
+        record.filename = filename;
+        record.function = function;
+        record.line = line;
+        record.count_suppressed = count_suppressed;
+        record.message = std::move(message);
+
+        if (stopped_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(file_mutex_);
+            write_record(record);
+            log_out_.flush();
+            return;
+        }
+
+        size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &slots_[position & (QUEUE_SIZE - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (sequence < position) {
+                if (level != LogLevel::ERROR_LEVEL) {
+                    count_dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                // Errors are never dropped, the writer is busy with the full queue
+                std::this_thread::yield();
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+            else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        // Pairs with the fence of the writer going idle, so either it sees the record or the writer is woken
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer_idle_.exchange(false)) {
+            wake_signal_.fetch_add(1);
+            wake_signal_.notify_one();
+        }
+
+        // Exception usually follows an error, it may terminate the program before the writer wakes up
+        if (level == LogLevel::ERROR_LEVEL) {
+            flush();
+        }
+    }
+
+    void LogManager::flush() {
+        size_t position = enqueue_position_.load(std::memory_order_acquire);
+        size_t written_position = written_position_.load(std::memory_order_acquire);
+        while (written_position < position && !stopped_.load(std::memory_order_acquire)) {
+            written_position_.wait(written_position);
+            written_position = written_position_.load(std::memory_order_acquire);
+        }
+    }
+
+    // Private functions
+    bool LogManager::pop(Record& record) noexcept {
+        Slot& slot = slots_[dequeue_position_ & (QUEUE_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1) {
+            return false;
+        }
+
+        record = std::move(slot.record);
+        slot.sequence.store(dequeue_position_ + QUEUE_SIZE, std::memory_order_release);
+        ++dequeue_position_;
+        return true;
+    }
+
+    bool LogManager::has_queued() const noexcept {
+        return slots_[dequeue_position_ & (QUEUE_SIZE - 1)].sequence.load(std::memory_order_acquire) == dequeue_position_ + 1;
+    }
+
+    void LogManager::write_messages() {
+        Record record;
+        while (true) {
+            uint32_t wake_signal = wake_signal_.load();
+            bool stopped = stopped_.load(std::memory_order_acquire);
+
+            {
+                std::lock_guard<std::mutex> lock(file_mutex_);
+                size_t count_dropped = count_dropped_.load(std::memory_order_relaxed);
+                if (count_dropped > count_reported_dropped_) {
+                    Record dropped_record;
+                    dropped_record.level = LogLevel::WARNING_LEVEL;
+                    dropped_record.filename = __FILE__;
+                    dropped_record.function = __func__;
+                    dropped_record.line = __LINE__;
+                    dropped_record.message = std::to_string(count_dropped - count_reported_dropped_) + " messages were dropped, the log queue is full";
+                    write_record(dropped_record);
+                    count_reported_dropped_ = count_dropped;
+                }
+                while (pop(record)) {
+                    write_record(record);
+                }
+                log_out_.flush();
+            }
+            written_position_.store(dequeue_position_, std::memory_order_release);
+            written_position_.notify_all();
+
+            if (stopped) {
+                break;
+            }
+
+            writer_idle_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (has_queued() || stopped_.load(std::memory_order_acquire)) {
+                writer_idle_.store(false);
+                continue;
+            }
+            wake_signal_.wait(wake_signal);
+            writer_idle_.store(false);
+        }
+    }
+
+    void LogManager::write_record(const Record& record) {
+        static const char* LEVEL_NAMES[] = { "INFO", "WARNING", "ERROR" };
+
+        if (!log_out_.is_open()) {
+            open_log_file();
+        }
+
+        log_out_ << LEVEL_NAMES[static_cast<int>(record.level)] << " in file: " << record.filename;
+        log_out_ << ", function: " << record.function;
+        log_out_ << ", line: " << record.line;
+        log_out_ << "\n" << record.message << "\n";
+        if (record.count_suppressed > 0) {
+            log_out_ << record.count_suppressed << " similar messages were suppressed before this one\n";
+        }
+        log_out_ << "\n";
+    }
+
+    void LogManager::open_log_file() {
+        log_out_.open(log_path_, append_ ? std::ios::app : std::ios::trunc);
+    }
+
+    // Static functions
+    void LogManager::stop_writer() {
+        LogManager* log_manager = GetInstance();
+        log_manager->stopped_.store(true, std::memory_order_release);
+        log_manager->wake_signal_.fetch_add(1);
+        log_manager->wake_signal_.notify_one();
+        log_manager->writer_.join();
+
+        // Producers which saw the writer running may have queued records after its last pass
+        std::lock_guard<std::mutex> lock(log_manager->file_mutex_);
+        Record record;
+        while (log_manager->pop(record)) {
+            log_manager->write_record(record);
+        }
+        log_manager->log_out_.flush();
+    }
+}  // namespace gre
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+// GRE main log storage, messages are queued without locks and written into the log file by a background thread
+namespace gre {
+    // Names of the levels avoid the ERROR macro of <wingdi.h>
+    enum class LogLevel {
+        INFO_LEVEL,
+        WARNING_LEVEL,
+        ERROR_LEVEL
+    };
+
+    // Rate limit of one logging call site, messages beyond the limit are counted and reported with the next written one
+    class LogSite {
+        std::atomic<int64_t> window_start_ = 0;
+        std::atomic<uint32_t> count_messages_ = 0;
+        std::atomic<uint32_t> count_suppressed_ = 0;
+
+    public:
+        inline static const uint32_t MAX_COUNT_MESSAGES = 16;
+        inline static const int64_t WINDOW_DURATION = 1000;  // In milliseconds
+
+        bool allow() noexcept;
+
+        uint32_t take_suppressed() noexcept;
+    };
+
+    class LogManager {
+    public:
+        inline static const size_t QUEUE_SIZE = 1024;  // Power of two
+
+    private:
+        struct Record {
+            LogLevel level = LogLevel::INFO_LEVEL;
+            const char* filename = "";
+            const char* function = "";
+            uint32_t line = 0;
+            uint32_t count_suppressed = 0;
+            std::string message;
+        };
+
+        // Slot of the bounded queue, the sequence tells whether it waits for a producer or for the writer
+        struct Slot {
+            std::atomic<size_t> sequence = 0;
+            Record record;
+        };
+
+        inline static std::atomic<int> level_ = static_cast<int>(LogLevel::INFO_LEVEL);
+
+        std::array<Slot, QUEUE_SIZE> slots_;
+        alignas(64) std::atomic<size_t> enqueue_position_ = 0;
+        alignas(64) std::atomic<size_t> written_position_ = 0;
+        size_t dequeue_position_ = 0;  // Used only by the writer thread
+        std::atomic<size_t> count_dropped_ = 0;
+        size_t count_reported_dropped_ = 0;  // Used only by the writer thread
+
+        std::atomic<bool> writer_idle_ = false;
+        std::atomic<uint32_t> wake_signal_ = 0;
+        std::atomic<bool> stopped_ = false;
+        std::thread writer_;
+
+        std::mutex file_mutex_;
+        std::string log_path_ = "gre_log.txt";
+        bool append_ = true;
+        std::ofstream log_out_;
+
+        LogManager();
+
+        bool pop(Record& record) noexcept;
+
+        bool has_queued() const noexcept;
+
+        void write_messages();
+
+        void write_record(const Record& record);
+
+        void open_log_file();
+
+        static void stop_writer();
+
+    public:
+        LogManager(const LogManager& other) = delete;
+
+        void operator=(const LogManager&) = delete;
+
+        static LogManager* GetInstance();
+
+        // Filtered out messages cost one relaxed load, so the check is kept inline
+        static bool is_enabled(LogLevel level) noexcept {
+            return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+        }
+
+        // Setters
+        static void set_level(LogLevel level) noexcept;
+
+        // The file is reopened, without append mode it is truncated
+        void set_log_file(const std::string& path, bool append = true);
+
+        // Getters
+        static LogLevel get_level() noexcept;
+
+        size_t get_count_dropped() const noexcept;
+
+        // Messages are dropped while the queue is full, errors wait for space and are written before returning
+        void push(LogLevel level, const char* filename, const char* function, uint32_t line, std::string&& message, uint32_t count_suppressed = 0);
+
+        // Waits until messages pushed before the call are written
+        void flush();
+    };
+}  // namespace gre
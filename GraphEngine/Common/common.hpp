@@ -1,6 +1,10 @@
 #pragma once
 
 // Math
+#include "Math/BoundingBox.hpp"
+#include "Math/BoundingSphere.hpp"
+#include "Math/Frustum.hpp"
+#include "Math/Mat4f.hpp"
 #include "Math/Matrix.hpp"
 #include "Math/Quaternion.hpp"
 #include "Math/Vec2.hpp"
@@ -8,4 +12,7 @@
 
 // Utils
 #include "Utils/AssociativeStorage.hpp"
+#include "Utils/AtlasAllocator.hpp"
+#include "Utils/FreeListAllocator.hpp"
 #include "Utils/Functions.hpp"
+#include "Utils/LogManager.hpp"
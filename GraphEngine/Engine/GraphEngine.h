@@ -1,37 +1,60 @@
 #pragma once
 
+#include <memory>
 #include "../Cameras/cameras.h"
 #include "../Light/lights.h"
 
 
 namespace gre {
+	enum class CullingMode {
+		NONE,
+		CPU,
+		GPU
+	};
+
+	// Forward shading runs the light loop per fragment, deferred shading lights the geometry buffer once per pixel
+	enum class RenderingMode {
+		FORWARD,
+		DEFERRED
+	};
+
+
 	class GraphEngine {
-		class TransparentObject {
-			double distance_;
-
-		public:
-			size_t object_id;
-			size_t model_id;
-			const GraphObject* object;
-
-			TransparentObject(const Vec3& camera_position, const GraphObject* object, size_t object_id, size_t model_id) {
-				this->object = object;
-				this->object_id = object_id;
-				this->model_id = model_id;
-				distance_ = (camera_position - object->get_center(model_id)).length();
-			}
+		// Versions of an object when a shadow layer was drawn, objects outside of the light frustum do not affect the layer
+		struct ShadowCaster {
+			size_t meshes_version;
+			size_t models_version;
+			bool inside;
+		};
 
-			bool operator<(const TransparentObject& other) const noexcept {
-				return distance_ < other.distance_;
-			}
+		struct ShadowLayer {
+			size_t shadow_version = 0;
+			std::unordered_map<size_t, ShadowCaster> casters;
 		};
 
-		inline static GLuint screen_vertex_array_ = 0;
+		inline static const UniformHandle CAMERA_ID_UNIFORM = UniformHandle("camera_id");
+		inline static const UniformHandle VIEW_UNIFORM = UniformHandle("view");
+		inline static const UniformHandle PROJECTION_UNIFORM = UniformHandle("projection");
+		inline static const UniformHandle FRUSTUM_PLANES_UNIFORM = UniformHandle("frustum_planes");
+		inline static const UniformHandle FIRST_LAYER_UNIFORM = UniformHandle("first_layer");
+		inline static const UniformHandle LIGHT_POSITION_UNIFORM = UniformHandle("light_position");
+		inline static const UniformHandle SHADOW_DISTANCE_UNIFORM = UniformHandle("shadow_distance");
+
+		inline static const GLuint GEOMETRY_BUFFER_UNIT = 4;
+		// Follows the geometry buffer attachments and the lighting texture
+		inline static const GLuint CUBE_SHADOW_MAPS_UNIT = GEOMETRY_BUFFER_UNIT + GeometryBuffer::COUNT_ATTACHMENTS + 1;
+		inline static const GLuint SHADOW_DEPTH_MAPS_UNIT = CUBE_SHADOW_MAPS_UNIT + 1;
+
+		inline static GLuint screen_vertex_buffer_ = 0;
 
 		GLuint screen_texture_id_ = 0;
 		GLuint depth_stencil_texture_id_ = 0;
 		GLuint primary_frame_buffer_ = 0;
 
+		CullingMode culling_mode_ = CullingMode::CPU;
+		RenderingMode rendering_mode_ = RenderingMode::FORWARD;
+		GlErrorMode gl_error_mode_ = DEFAULT_GL_ERROR_MODE;
+		bool depth_pre_pass_ = false;
 		bool grayscale_ = false;
 		uint32_t border_width_ = 7;
 		double gamma_ = 2.2;
@@ -41,8 +64,25 @@ namespace gre {
 
 		Shader main_shader_;
 		Shader depth_shader_;
+		Shader point_depth_shader_;
 		Shader post_shader_;
+		Shader cull_shader_;
+		Shader cluster_shader_;
+		Shader geometry_shader_;
+		Shader lighting_shader_;
+		Shader resolve_shader_;
 		sf::RenderWindow* window_;
+		mutable GlStateCache state_cache_;
+		mutable RenderQueue render_queue_;
+
+		// Shadow map layers are kept until their light space or a caster inside of them changes
+		mutable size_t shadow_maps_version_ = 0;
+		mutable std::vector<ShadowLayer> shadow_layers_;
+		mutable std::vector<ShadowLayer> cube_shadow_layers_;
+		mutable size_t count_shadow_passes_ = 0;
+
+		// Allocated by the first deferred frame, shares depth and stencil with the primary frame buffer
+		mutable std::unique_ptr<GeometryBuffer> geometry_buffer_;
 		
 		void set_active() const {
 #ifdef _DEBUG
@@ -52,6 +92,7 @@ namespace gre {
 #else
 			window_->setActive(true);
 #endif // _DEBUG
+			state_cache_.make_current();
 		}
 
 		void set_uniforms() const {
@@ -59,8 +100,29 @@ namespace gre {
 			main_shader_.set_uniform_i("specular_map", 1);
 			main_shader_.set_uniform_i("emission_map", 2);
 			main_shader_.set_uniform_i("shadow_maps", 3);
+			main_shader_.set_uniform_i("cube_shadow_maps", CUBE_SHADOW_MAPS_UNIT);
+			main_shader_.set_uniform_i("shadow_depth_maps", SHADOW_DEPTH_MAPS_UNIT);
 			main_shader_.set_uniform_f("gamma", static_cast<GLfloat>(gamma_));
 
+			geometry_shader_.set_uniform_i("diffuse_map", 0);
+			geometry_shader_.set_uniform_i("specular_map", 1);
+			geometry_shader_.set_uniform_i("emission_map", 2);
+
+			lighting_shader_.set_uniform_i("shadow_maps", 3);
+			lighting_shader_.set_uniform_i("cube_shadow_maps", CUBE_SHADOW_MAPS_UNIT);
+			lighting_shader_.set_uniform_i("shadow_depth_maps", SHADOW_DEPTH_MAPS_UNIT);
+			lighting_shader_.set_uniform_i("position_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::POSITION);
+			lighting_shader_.set_uniform_i("normal_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::NORMAL);
+			lighting_shader_.set_uniform_i("ambient_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::AMBIENT);
+			lighting_shader_.set_uniform_i("diffuse_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::DIFFUSE);
+			lighting_shader_.set_uniform_i("specular_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::SPECULAR);
+			lighting_shader_.set_uniform_i("emission_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::EMISSION);
+
+			resolve_shader_.set_uniform_i("diffuse_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::DIFFUSE);
+			resolve_shader_.set_uniform_i("emission_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::EMISSION);
+			resolve_shader_.set_uniform_i("lighting_texture", GEOMETRY_BUFFER_UNIT + GeometryBuffer::COUNT_ATTACHMENTS);
+			resolve_shader_.set_uniform_f("gamma", static_cast<GLfloat>(gamma_));
+
 			post_shader_.set_uniform_i("screen_texture", 0);
 			post_shader_.set_uniform_i("stencil_texture", 1);
 			post_shader_.set_uniform_i("grayscale", grayscale_);
@@ -69,7 +131,10 @@ namespace gre {
 			kernel_.set_uniforms(post_shader_);
 		}
 
-		void init_gl() const {
+		void init_gl() {
+			gre::set_gl_error_mode(gl_error_mode_);
+			gl_error_mode_ = gre::get_gl_error_mode();
+
 			glClearColor(static_cast<GLclampf>(clear_color_.x), static_cast<GLclampf>(clear_color_.y), static_cast<GLclampf>(clear_color_.z), static_cast<GLclampf>(1.0));
 			glEnable(GL_DEPTH_TEST);
 			glEnable(GL_STENCIL_TEST);
@@ -77,21 +142,19 @@ namespace gre {
 			glEnable(GL_BLEND);
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			glEnable(GL_CULL_FACE);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void create_primary_frame_buffer() {
 			glGenTextures(1, &screen_texture_id_);
-			glBindTexture(GL_TEXTURE_2D, screen_texture_id_);
+			state_cache_.bind_texture(0, GL_TEXTURE_2D, screen_texture_id_);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, window_->getSize().x, window_->getSize().y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glBindTexture(GL_TEXTURE_2D, 0);
 
 			glGenTextures(1, &depth_stencil_texture_id_);
-			glBindTexture(GL_TEXTURE_2D, depth_stencil_texture_id_);
+			state_cache_.bind_texture(0, GL_TEXTURE_2D, depth_stencil_texture_id_);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, window_->getSize().x, window_->getSize().y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
 			glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_STENCIL_INDEX);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -100,7 +163,7 @@ namespace gre {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 			GLfloat border_olor[] = { 0.0, 0.0, 0.0, 0.0 };
 			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_olor);
-			glBindTexture(GL_TEXTURE_2D, 0);
+			state_cache_.bind_texture(0, GL_TEXTURE_2D, 0);
 
 			glGenFramebuffers(1, &primary_frame_buffer_);
 			glBindFramebuffer(GL_FRAMEBUFFER, primary_frame_buffer_);
@@ -115,72 +178,255 @@ namespace gre {
 #endif // _DEBUG
 
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void cull_objects(const Frustum& frustum) const {
+			if (culling_mode_ == CullingMode::GPU) {
+				cull_shader_.set_uniform_4fv(FRUSTUM_PLANES_UNIFORM, 6, frustum.get_planes().data());
+			}
+
+			for (const auto& [object_id, object] : objects) {
+				if (culling_mode_ == CullingMode::CPU) {
+					object.cull_models(frustum);
+				}
+				else if (culling_mode_ == CullingMode::GPU) {
+					object.cull_models(cull_shader_);
+				}
+				else {
+					object.reset_culling();
+				}
+			}
+		}
+
+		const GeometryBuffer& get_geometry_buffer() const {
+			if (geometry_buffer_ == nullptr) {
+				geometry_buffer_ = std::make_unique<GeometryBuffer>(static_cast<GLsizei>(window_->getSize().x), static_cast<GLsizei>(window_->getSize().y), depth_stencil_texture_id_);
+			}
+			return *geometry_buffer_;
+		}
+
+		// With the depth pre-pass opaque items are shaded only where they are the nearest
+		void draw_opaque_objects(const Camera& camera, const Shader& shader) const {
+			if (!depth_pre_pass_) {
+				render_queue_.draw_opaque(shader);
+				return;
+			}
+
+			camera.set_uniforms(depth_shader_);
+			state_cache_.set_stencil_mask(0x00);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			render_queue_.draw_depth(depth_shader_);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			state_cache_.set_stencil_mask(0xFF);
+
+			glDepthFunc(GL_LEQUAL);
+			render_queue_.draw_opaque(shader);
+			glDepthFunc(GL_LESS);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Opaque objects are shaded once per covered pixel and light, transparent objects are blended by the forward path
+		void draw_deferred(const Camera& camera) const {
+			const GeometryBuffer& geometry_buffer = get_geometry_buffer();
+			camera.set_uniforms(geometry_shader_);
+			camera.set_uniforms(lighting_shader_);
+
+			// Attachments hold data rather than colors, so they are written without blending
+			geometry_buffer.bind_geometry_frame_buffer();
+			glDisable(GL_BLEND);
+			draw_opaque_objects(camera, geometry_shader_);
+
+			// Light contributions are summed, depth and stencil of the geometry pass stay untouched
+			geometry_buffer.bind_lighting_frame_buffer();
+			geometry_buffer.bind_textures(GEOMETRY_BUFFER_UNIT);
+			state_cache_.set_stencil_mask(0x00);
+			state_cache_.set_stencil_func(GL_ALWAYS, 0, 0xFF);
+			glDepthMask(GL_FALSE);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE);
+			lights.draw_deferred(lighting_shader_, get_screen_vertex_array());
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, primary_frame_buffer_);
+			glDisable(GL_DEPTH_TEST);
+			resolve_shader_.use();
+			state_cache_.bind_vertex_array(get_screen_vertex_array());
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			glEnable(GL_DEPTH_TEST);
+			glDepthMask(GL_TRUE);
+			state_cache_.set_stencil_mask(0xFF);
+			geometry_buffer.unbind_textures(GEOMETRY_BUFFER_UNIT);
+
+			render_queue_.draw_transparent(main_shader_);
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void draw_objects(const Camera& camera) const {
-			std::vector<TransparentObject> transparent_objects;
+			Frustum frustum(camera.get_projection_matrix() * camera.get_view_matrix());
+			cull_objects(frustum);
+
 			for (const auto& [object_id, object] : objects) {
 				if (object.transparent) {
 					for (const auto& [model_id, model] : object.models) {
-						transparent_objects.emplace_back(camera.position, &object, object_id, model_id);
+						if (culling_mode_ != CullingMode::NONE && !frustum.intersects(object.get_bounding_box(model_id))) {
+							continue;
+						}
+						render_queue_.insert_transparent(object_id, object, model_id, camera.position);
+					}
+					continue;
+				}
+
+				render_queue_.insert(object_id, object, camera.position);
+			}
+
+			if (rendering_mode_ == RenderingMode::DEFERRED) {
+				draw_deferred(camera);
+			}
+			else {
+				draw_opaque_objects(camera, main_shader_);
+				render_queue_.draw_transparent(main_shader_);
+			}
+			render_queue_.clear();
+		}
+
+		bool is_shadow_layer_valid(ShadowLayer& layer, size_t shadow_version, const Frustum& frustum) const {
+			if (layer.shadow_version != shadow_version) {
+				return false;
+			}
+
+			size_t count_known_objects = 0;
+			for (const auto& [object_id, object] : objects) {
+				size_t meshes_version = object.meshes.get_version();
+				size_t models_version = object.models.get_version();
+
+				auto iterator = layer.casters.find(object_id);
+				if (iterator == layer.casters.end()) {
+					if (object.intersects(frustum)) {
+						return false;
 					}
+					layer.casters.emplace(object_id, ShadowCaster{ meshes_version, models_version, false });
+					++count_known_objects;
 					continue;
 				}
 
-				main_shader_.set_uniform_i("object_id", static_cast<GLint>(object_id));
-				object.draw(main_shader_);
+				++count_known_objects;
+				ShadowCaster& caster = iterator->second;
+				if (caster.meshes_version == meshes_version && caster.models_version == models_version) {
+					continue;
+				}
+				if (caster.inside || object.intersects(frustum)) {
+					return false;
+				}
+				caster.meshes_version = meshes_version;
+				caster.models_version = models_version;
 			}
 
-			std::sort(transparent_objects.rbegin(), transparent_objects.rend());
-			for (const TransparentObject& object : transparent_objects) {
-				main_shader_.set_uniform_i("object_id", static_cast<GLint>(object.object_id));
-				object.object->draw(object.model_id, main_shader_);
+			// Some of the recorded objects were erased
+			return count_known_objects == layer.casters.size();
+		}
+
+		void update_shadow_layer(ShadowLayer& layer, size_t shadow_version, const Frustum& frustum) const {
+			layer.shadow_version = shadow_version;
+			layer.casters.clear();
+			for (const auto& [object_id, object] : objects) {
+				layer.casters.emplace(object_id, ShadowCaster{ object.meshes.get_version(), object.models.get_version(), object.intersects(frustum) });
 			}
 		}
 
+		// Static lights and casters cost no shadow passes, cascades are redrawn when their camera moves
 		void draw_depth_map() const {
-			lights.set_framebuffer();
+			lights.update_shadow_maps();
+			lights.fit_shadow_maps(cameras);
+			if (shadow_maps_version_ != lights.get_shadow_maps_version()) {
+				shadow_maps_version_ = lights.get_shadow_maps_version();
+				shadow_layers_.clear();
+				cube_shadow_layers_.clear();
+			}
 
-			for (const auto& [light_id, light] : lights) {
-				lights.set_depth_map_texture(light_id);
+			size_t count_passes = 0;
+			shadow_layers_.resize(std::max(shadow_layers_.size(), lights.get_count_used_shadow_maps()));
+			for (size_t shadow_map_id = 0; shadow_map_id < lights.get_count_used_shadow_maps(); ++shadow_map_id) {
+				const LightStorage::ShadowState& state = lights.get_shadow_state(shadow_map_id);
+				const Matrix4x4& light_space = state.light_space;
+				Frustum frustum(light_space);
+				ShadowLayer& layer = shadow_layers_[shadow_map_id];
+				if (!state.tile || is_shadow_layer_valid(layer, state.version, frustum)) {
+					continue;
+				}
 
-				depth_shader_.set_uniform_matrix("light_space", light->get_light_space_matrix());
+				if (count_passes++ == 0) {
+					lights.set_framebuffer();
+				}
+				lights.set_depth_map_texture(*state.tile);
+				update_shadow_layer(layer, state.version, frustum);
+
+				// Culling might switch the active program, depth shader is activated after it
+				cull_objects(frustum);
+				depth_shader_.set_uniform_matrix(PROJECTION_UNIFORM, light_space);
+				depth_shader_.set_uniform_matrix(VIEW_UNIFORM, Matrix4x4::one_matrix());
 				for (const auto& [object_id, object] : objects) {
 					object.draw_depth_map();
 				}
 			}
 
+			// Each cube map is drawn by one layered pass, faces of the cube map mirror the winding of triangles
+			size_t count_cube_passes = 0;
+			cube_shadow_layers_.resize(std::max(cube_shadow_layers_.size(), lights.get_count_used_cube_maps()));
+			for (size_t cube_map_id = 0; cube_map_id < lights.get_count_used_cube_maps(); ++cube_map_id) {
+				const LightStorage::CubeShadowState& state = lights.get_cube_shadow_state(cube_map_id);
+				Frustum frustum(state.light_space);
+				ShadowLayer& layer = cube_shadow_layers_[cube_map_id];
+				if (is_shadow_layer_valid(layer, state.version, frustum)) {
+					continue;
+				}
+
+				if (count_cube_passes++ == 0) {
+					lights.set_cube_map_framebuffer();
+					glFrontFace(GL_CW);
+				}
+				lights.set_cube_map_texture(cube_map_id);
+				update_shadow_layer(layer, state.version, frustum);
+
+				std::vector<GLfloat> face_spaces;
+				for (const Matrix4x4& face_space : state.light->get_cube_face_matrices()) {
+					std::vector<GLfloat> matrix(face_space);
+					face_spaces.insert(face_spaces.end(), matrix.begin(), matrix.end());
+				}
+
+				cull_objects(frustum);
+				point_depth_shader_.set_uniform_matrix("face_spaces", 6, face_spaces.data(), 4, 4);
+				point_depth_shader_.set_uniform_i(FIRST_LAYER_UNIFORM, static_cast<GLint>(6 * cube_map_id));
+				point_depth_shader_.set_uniform_f(LIGHT_POSITION_UNIFORM, state.light->position);
+				point_depth_shader_.set_uniform_f(SHADOW_DISTANCE_UNIFORM, static_cast<GLfloat>(state.light->get_shadow_distance()));
+				for (const auto& [object_id, object] : objects) {
+					object.draw_depth_map();
+				}
+			}
+			if (count_cube_passes > 0) {
+				glFrontFace(GL_CCW);
+			}
+
+			count_shadow_passes_ += count_passes + count_cube_passes;
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void draw_primary_frame_buffer(const Camera& camera) const {
 			glBindFramebuffer(GL_FRAMEBUFFER, primary_frame_buffer_);
 			camera.set_uniforms(main_shader_);
+			lights.cluster_lights(camera, cluster_shader_, main_shader_);
 			
-			glStencilMask(0xFF);
-			glStencilFunc(GL_ALWAYS, 0, 0xFF);
+			state_cache_.set_stencil_mask(0xFF);
+			state_cache_.set_stencil_func(GL_ALWAYS, 0, 0xFF);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-			glActiveTexture(GL_TEXTURE3);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, lights.depth_map_texture_id_);
-			glActiveTexture(GL_TEXTURE0);
-
+			lights.bind_shadow_maps(3, CUBE_SHADOW_MAPS_UNIT, SHADOW_DEPTH_MAPS_UNIT);
 			draw_objects(camera);
-
-			glActiveTexture(GL_TEXTURE3);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-			glActiveTexture(GL_TEXTURE0);
+			lights.unbind_shadow_maps(3, CUBE_SHADOW_MAPS_UNIT, SHADOW_DEPTH_MAPS_UNIT);
 
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void draw_mainbuffer(const Camera& camera) const {
@@ -189,52 +435,43 @@ namespace gre {
 
 			glDisable(GL_DEPTH_TEST);
 
-			glBindVertexArray(screen_vertex_array_);
+			state_cache_.bind_vertex_array(get_screen_vertex_array());
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, screen_texture_id_);
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, depth_stencil_texture_id_);
+			state_cache_.bind_texture(0, GL_TEXTURE_2D, screen_texture_id_);
+			state_cache_.bind_texture(1, GL_TEXTURE_2D, depth_stencil_texture_id_);
 
 			glDrawArrays(GL_TRIANGLES, 0, 6);
 
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, 0);
-
-			glBindVertexArray(0);
+			// Primary frame buffer attachments can not stay bound while rendering into it
+			state_cache_.bind_texture(1, GL_TEXTURE_2D, 0);
+			state_cache_.bind_texture(0, GL_TEXTURE_2D, 0);
 
 			glEnable(GL_DEPTH_TEST);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void deallocate() {
+			geometry_buffer_.reset();
 			glDeleteFramebuffers(1, &primary_frame_buffer_);
 			glDeleteTextures(1, &screen_texture_id_);
 			glDeleteTextures(1, &depth_stencil_texture_id_);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			state_cache_.on_texture_deleted(screen_texture_id_);
+			state_cache_.on_texture_deleted(depth_stencil_texture_id_);
+			GRE_CHECK_GL_ERRORS;
 
 			primary_frame_buffer_ = 0;
 			screen_texture_id_ = 0;
 			depth_stencil_texture_id_ = 0;
 		}
 
-		static void create_screen_vertex_array() {
-			if (screen_vertex_array_ != 0) {
+		// Buffer is shared between contexts, vertex arrays are created per context by get_screen_vertex_array
+		static void create_screen_vertex_buffer() {
+			if (screen_vertex_buffer_ != 0) {
 				return;
 			}
 
-			glGenVertexArrays(1, &screen_vertex_array_);
-			glBindVertexArray(screen_vertex_array_);
-
-			GLuint vertex_buffer;
-			glGenBuffers(1, &vertex_buffer);
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+			glGenBuffers(1, &screen_vertex_buffer_);
+			glBindBuffer(GL_ARRAY_BUFFER, screen_vertex_buffer_);
 
 			GLfloat vertices[] = {
 				 1.0,  1.0, 1.0, 1.0,
@@ -245,6 +482,18 @@ namespace gre {
 				 1.0,  1.0, 1.0, 1.0
 			};
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		GLuint get_screen_vertex_array() const {
+			GlStateCache::SharedVertexArray& screen_vertex_array = state_cache_.get_shared_vertex_array(&screen_vertex_buffer_);
+			if (screen_vertex_array.version != 0) {
+				return screen_vertex_array.vertex_array_id;
+			}
+
+			state_cache_.bind_vertex_array(screen_vertex_array.vertex_array_id);
+			glBindBuffer(GL_ARRAY_BUFFER, screen_vertex_buffer_);
 
 			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(0));
 			glEnableVertexAttribArray(0);
@@ -252,13 +501,11 @@ namespace gre {
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(2 * sizeof(GLfloat)));
 			glEnableVertexAttribArray(1);
 
-			glBindVertexArray(0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
 
-			glDeleteBuffers(1, &vertex_buffer);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			screen_vertex_array.version = 1;
+			return screen_vertex_array.vertex_array_id;
 		}
 
 	public:
@@ -277,12 +524,18 @@ namespace gre {
 			}
 
 			depth_shader_.load_from_file("GraphEngine/Shaders/Vertex/Depth.vert", "GraphEngine/Shaders/Fragment/Depth.frag");
+			point_depth_shader_.load_from_file("GraphEngine/Shaders/Vertex/PointDepth.vert", "GraphEngine/Shaders/Geometry/PointDepth.geom", "GraphEngine/Shaders/Fragment/PointDepth.frag");
 			post_shader_.load_from_file("GraphEngine/Shaders/Vertex/Post.vert", "GraphEngine/Shaders/Fragment/Post.frag");
 			main_shader_.load_from_file("GraphEngine/Shaders/Vertex/Main.vert", "GraphEngine/Shaders/Fragment/Main.frag");
+			cull_shader_.load_compute_from_file("GraphEngine/Shaders/Compute/Cull.comp");
+			cluster_shader_.load_compute_from_file("GraphEngine/Shaders/Compute/Cluster.comp");
+			geometry_shader_.load_from_file("GraphEngine/Shaders/Vertex/Main.vert", "GraphEngine/Shaders/Fragment/Geometry.frag");
+			lighting_shader_.load_from_file("GraphEngine/Shaders/Vertex/Lighting.vert", "GraphEngine/Shaders/Fragment/Lighting.frag");
+			resolve_shader_.load_from_file("GraphEngine/Shaders/Vertex/Post.vert", "GraphEngine/Shaders/Fragment/Resolve.frag");
 
 #ifdef _DEBUG
 			const sf::ContextSettings& settings = window->getSettings();
-			if (!depth_shader_.check_window_settings(settings) || !post_shader_.check_window_settings(settings) || !main_shader_.check_window_settings(settings)) {
+			if (!depth_shader_.check_window_settings(settings) || !point_depth_shader_.check_window_settings(settings) || !post_shader_.check_window_settings(settings) || !main_shader_.check_window_settings(settings) || !cull_shader_.check_window_settings(settings) || !cluster_shader_.check_window_settings(settings) || !geometry_shader_.check_window_settings(settings) || !lighting_shader_.check_window_settings(settings) || !resolve_shader_.check_window_settings(settings)) {
 				throw GreRuntimeError(__FILE__, __LINE__, "GraphEngine, invalid OpenGL version.\n\n");
 			}
 #endif // _DEBUG
@@ -290,15 +543,21 @@ namespace gre {
 			set_uniforms();
 
 			init_gl();
-			lights.create_depth_map_frame_buffer(std::stoi(main_shader_.get_value_frag("NR_LIGHTS")));
+			lights.create_depth_map_frame_buffer();
+			lights.create_cluster_buffer({
+				static_cast<GLuint>(std::stoi(cluster_shader_.get_value_comp("CLUSTERS_X"))),
+				static_cast<GLuint>(std::stoi(cluster_shader_.get_value_comp("CLUSTERS_Y"))),
+				static_cast<GLuint>(std::stoi(cluster_shader_.get_value_comp("CLUSTERS_Z")))
+			}, static_cast<GLuint>(std::stoi(cluster_shader_.get_value_comp("MAX_CLUSTER_LIGHTS"))));
 			cameras.create_shader_storage_buffer(std::stoi(main_shader_.get_value_frag("NR_CAMERAS")), main_shader_);
-			create_screen_vertex_array();
+			create_screen_vertex_buffer();
+			LightStorage::create_light_volume_buffers();
 			create_primary_frame_buffer();
 
 			cameras.insert(Camera(window, &default_control_system));
 
 #ifdef _DEBUG
-			if (!depth_shader_.validate_program() || !post_shader_.validate_program() || !main_shader_.validate_program()) {
+			if (!depth_shader_.validate_program() || !point_depth_shader_.validate_program() || !post_shader_.validate_program() || !main_shader_.validate_program() || !cull_shader_.validate_program() || !cluster_shader_.validate_program() || !geometry_shader_.validate_program() || !lighting_shader_.validate_program() || !resolve_shader_.validate_program()) {
 				throw GreRuntimeError(__FILE__, __LINE__, "GraphEngine, shader program validation failed.\n\n");
 			}
 #endif // _DEBUG
@@ -308,6 +567,10 @@ namespace gre {
 			window_ = other.window_;
 			set_active();
 
+			culling_mode_ = other.culling_mode_;
+			rendering_mode_ = other.rendering_mode_;
+			gl_error_mode_ = other.gl_error_mode_;
+			depth_pre_pass_ = other.depth_pre_pass_;
 			grayscale_ = other.grayscale_;
 			border_width_ = other.border_width_;
 			gamma_ = other.gamma_;
@@ -321,11 +584,17 @@ namespace gre {
 
 			main_shader_ = other.main_shader_;
 			depth_shader_ = other.depth_shader_;
+			point_depth_shader_ = other.point_depth_shader_;
 			post_shader_ = other.post_shader_;
+			cull_shader_ = other.cull_shader_;
+			cluster_shader_ = other.cluster_shader_;
+			geometry_shader_ = other.geometry_shader_;
+			lighting_shader_ = other.lighting_shader_;
+			resolve_shader_ = other.resolve_shader_;
 			set_uniforms();
 
 			init_gl();
-			create_screen_vertex_array();
+			create_screen_vertex_buffer();
 			create_primary_frame_buffer();
 		}
 
@@ -365,7 +634,8 @@ namespace gre {
 #endif // _DEBUG
 
 			set_active();
-			post_shader_.set_uniform_f("gamma", static_cast<GLfloat>(gamma));
+			main_shader_.set_uniform_f("gamma", static_cast<GLfloat>(gamma));
+			resolve_shader_.set_uniform_f("gamma", static_cast<GLfloat>(gamma));
 			gamma_ = gamma;
 		}
 
@@ -427,6 +697,57 @@ namespace gre {
 			return kernel_;
 		}
 
+		void set_culling_mode(CullingMode culling_mode) noexcept {
+			culling_mode_ = culling_mode;
+		}
+
+		CullingMode get_culling_mode() const noexcept {
+			return culling_mode_;
+		}
+
+		void set_rendering_mode(RenderingMode rendering_mode) noexcept {
+			rendering_mode_ = rendering_mode;
+		}
+
+		RenderingMode get_rendering_mode() const noexcept {
+			return rendering_mode_;
+		}
+
+		// Applied to the context of the window, without KHR_debug the debug callback modes fall back to NONE
+		void set_gl_error_mode(GlErrorMode gl_error_mode) {
+			set_active();
+			gre::set_gl_error_mode(gl_error_mode);
+			gl_error_mode_ = gre::get_gl_error_mode();
+		}
+
+		GlErrorMode get_gl_error_mode() const noexcept {
+			return gl_error_mode_;
+		}
+
+		// Opaque objects are drawn into the depth buffer before shading, so overdrawn fragments skip lighting
+		void set_depth_pre_pass(bool depth_pre_pass) noexcept {
+			depth_pre_pass_ = depth_pre_pass;
+		}
+
+		bool get_depth_pre_pass() const noexcept {
+			return depth_pre_pass_;
+		}
+
+		// Redundant state changes eliminated during the last drawn frame
+		const GlStateCache::Statistics& get_state_statistics() const noexcept {
+			return state_cache_.get_last_frame_statistics();
+		}
+
+		// Shadow map layers drawn during the last frame
+		size_t get_count_shadow_passes() const noexcept {
+			return count_shadow_passes_;
+		}
+
+		// Draw calls and state changes of the main pass and its depth pre-pass during the last drawn frame
+		const RenderQueue::Statistics& get_render_statistics() const noexcept {
+			return render_queue_.get_last_frame_statistics();
+		}
+
 		ObjectDescription get_check_object(size_t camera_id, Vec3& intersect_point) {
 #ifdef _DEBUG
 			if (!cameras.contains(camera_id)) {
@@ -456,7 +777,12 @@ namespace gre {
 		void swap(GraphEngine& other) {
 			std::swap(window_, other.window_);
 			set_active();
+			state_cache_.invalidate();
 
+			std::swap(culling_mode_, other.culling_mode_);
+			std::swap(rendering_mode_, other.rendering_mode_);
+			std::swap(gl_error_mode_, other.gl_error_mode_);
+			std::swap(depth_pre_pass_, other.depth_pre_pass_);
 			std::swap(grayscale_, other.grayscale_);
 			std::swap(border_width_, other.border_width_);
 			std::swap(gamma_, other.gamma_);
@@ -470,37 +796,58 @@ namespace gre {
 
 			main_shader_.swap(other.main_shader_);
 			depth_shader_.swap(other.depth_shader_);
+			point_depth_shader_.swap(other.point_depth_shader_);
 			post_shader_.swap(other.post_shader_);
+			cull_shader_.swap(other.cull_shader_);
+			cluster_shader_.swap(other.cluster_shader_);
+			geometry_shader_.swap(other.geometry_shader_);
+			lighting_shader_.swap(other.lighting_shader_);
+			resolve_shader_.swap(other.resolve_shader_);
 			set_uniforms();
 
 			std::swap(screen_texture_id_, other.screen_texture_id_);
 			std::swap(depth_stencil_texture_id_, other.depth_stencil_texture_id_);
 			std::swap(primary_frame_buffer_, other.primary_frame_buffer_);
+			std::swap(shadow_maps_version_, other.shadow_maps_version_);
+			shadow_layers_.swap(other.shadow_layers_);
+			cube_shadow_layers_.swap(other.cube_shadow_layers_);
+			geometry_buffer_.swap(other.geometry_buffer_);
 			init_gl();
 		}
 
 		void draw() {
 			set_active();
+			state_cache_.begin_frame();
+			render_queue_.begin_frame();
 
-			draw_depth_map();
+			lights.update_light_buffer();
+			Material::bind_storage_buffer();
+			count_shadow_passes_ = 0;
 
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 			glClear(GL_COLOR_BUFFER_BIT);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
 
 			cameras.update_storage();
-			lights.set_uniforms(main_shader_);
+			draw_depth_map();
 			for (const auto& [id, camera] : cameras) {
-				main_shader_.set_uniform_i("camera_id", static_cast<GLint>(cameras.get_memory_id(id)));
+				main_shader_.set_uniform_i(CAMERA_ID_UNIFORM, static_cast<GLint>(cameras.get_memory_id(id)));
+				geometry_shader_.set_uniform_i(CAMERA_ID_UNIFORM, static_cast<GLint>(cameras.get_memory_id(id)));
 
+				lights.set_shadow_maps(cameras.get_memory_id(id));
 				draw_primary_frame_buffer(camera);
 				draw_mainbuffer(camera);
 			}
+
+			render_queue_.end_frame();
+			state_cache_.end_frame();
 		}
 
 		~GraphEngine() {
+			// Vertex arrays of geometry arenas belong to the window context
+			if (window_->setActive(true)) {
+				state_cache_.delete_shared_vertex_arrays();
+			}
 			deallocate();
 		}
 
@@ -3,13 +3,20 @@
 #include <assimp/postprocess.h>
 #include <assimp/Importer.hpp>
 #include <unordered_map>
-#include <unordered_set>
 #include "MeshStorage.h"
 #include "ModelStorage.h"
 
 
 namespace gre {
     class GraphObject {
+        friend class RenderQueue;
+
+        // Sphere around all models, kept until models or meshes change
+        mutable BoundingSphere bounding_sphere_;
+        mutable size_t bounding_sphere_models_version_ = 0;
+        mutable size_t bounding_sphere_meshes_version_ = 0;
+
+
         Texture load_texture_by_type(const aiMaterial* material, aiTextureType type, const aiScene* scene, const std::string& directory, std::unordered_map<std::string, Texture>& uploaded_textures) {
             aiString texture_path;
             aiTextureMapping mapping;
@@ -149,7 +156,7 @@ namespace gre {
             return mesh_material;
         }
 
-        Mesh load_mesh_data(const aiMesh* mesh) {
+        Mesh load_mesh_data(const aiMesh* mesh, bool compact_vertex_format) {
 #ifdef _DEBUG
             if (mesh->mPrimitiveTypes & aiPrimitiveType_POINT) {
                 std::cout << "Mesh loading warning, unable to load point primitive type.\n\n";
@@ -162,7 +169,12 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            Mesh polygon_mesh(mesh->mNumVertices);
+            VertexFormat vertex_format;
+            if (compact_vertex_format) {
+                vertex_format = VertexFormat::compact(mesh->GetNumUVChannels() > 0, mesh->GetNumColorChannels() > 0);
+            }
+
+            Mesh polygon_mesh(mesh->mNumVertices, vertex_format);
 
             // Loading index array of mesh
             std::vector<GLuint> indices;
@@ -255,6 +267,58 @@ namespace gre {
             }
         }
 
+        // Instance buffer of the object is attached to the vertex array shared by meshes of the same format,
+        // with all models one of them is drawn by its memory id as the base instance
+        void bind_geometry(const Mesh& mesh, bool all_models = false) const {
+            models.bind_instances(mesh.get_geometry_arena(), all_models);
+        }
+
+        void set_border_stencil() const {
+            if (border_mask > 0) {
+                GlStateCache::current().set_stencil_func(GL_ALWAYS, border_mask, 0xFF);
+                GlStateCache::current().set_stencil_mask(border_mask);
+            }
+        }
+
+        void reset_border_stencil() const {
+            if (border_mask > 0) {
+                GlStateCache::current().set_stencil_mask(0x00);
+                GRE_CHECK_GL_ERRORS;
+            }
+        }
+
+        // Command buffer filled by the last GPU cull, zero if instances were not culled on GPU
+        GLuint get_indirect_buffer() const noexcept {
+            return models.instances_gpu_culled_ ? meshes.command_buffer_ : 0;
+        }
+
+        // Instance count after GPU culling is known only on GPU side
+        bool has_visible_instances() const noexcept {
+            return models.instances_gpu_culled_ || models.get_count_instances() > 0;
+        }
+
+        // Draws visible instances of the mesh, bound indirect buffer expected after GPU culling
+        void draw_instances(size_t mesh_id, const Shader& shader, bool set_material) const {
+            const Mesh& mesh = meshes[mesh_id];
+            if (models.instances_gpu_culled_) {
+                GLintptr command_offset = meshes.get_command_offset(meshes.get_memory_id(mesh_id));
+                if (set_material) {
+                    mesh.draw_indirect(command_offset, shader);
+                }
+                else {
+                    mesh.draw_geometry_indirect(command_offset);
+                }
+                return;
+            }
+
+            if (set_material) {
+                mesh.draw(models.get_count_instances(), shader);
+            }
+            else {
+                mesh.draw_geometry(models.get_count_instances());
+            }
+        }
+
         // MAIN shader expected
         void draw_meshes(size_t model_id, const Shader& shader) const {
 #ifdef _DEBUG
@@ -263,20 +327,28 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            shader.set_uniform_i("model_id", static_cast<GLint>(models.get_memory_id(model_id)));
-            shader.set_uniform_matrix("not_instance_model", models[model_id]);
-
+            size_t memory_id = models.get_memory_id(model_id);
             for (const auto& [id, mesh] : meshes) {
-                mesh.draw(1, shader);
+                bind_geometry(mesh, true);
+                mesh.draw(1, shader, memory_id);
             }
         }
 
         // MAIN shader expected
         void draw_meshes(const Shader& shader) const {
-            shader.set_uniform_i("model_id", -1);
+            if (models.instances_gpu_culled_) {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshes.command_buffer_);
+                for (const auto& [id, mesh] : meshes) {
+                    bind_geometry(mesh);
+                    mesh.draw_indirect(meshes.get_command_offset(meshes.get_memory_id(id)), shader);
+                }
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                return;
+            }
 
             for (const auto& [id, mesh] : meshes) {
-                mesh.draw(models.size(), shader);
+                bind_geometry(mesh);
+                mesh.draw(models.get_count_instances(), shader);
             }
         }
 
@@ -298,7 +370,7 @@ namespace gre {
                 throw GreRuntimeError(__FILE__, __func__, __LINE__, "GraphObject, failed to initialize GLEW.\n\n");
             }
 
-            meshes.set_matrix_buffer(models.create_matrix_buffer(max_count_models));
+            models.create_matrix_buffer(max_count_models);
         }
 
         GraphObject(const GraphObject& other) {
@@ -306,8 +378,6 @@ namespace gre {
             border_mask = other.border_mask;
             meshes = other.meshes;
             models = other.models;
-
-            meshes.set_matrix_buffer(models.matrix_buffer_);
         }
 
         GraphObject(GraphObject&& other) noexcept {
@@ -335,10 +405,12 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            const Matrix4x4& transform = models[model_id];
-            std::vector<Vec3> positions = meshes[mesh_id].get_positions();
-            for (Vec3& position : positions) {
-                position = transform * position;
+            std::vector<GLfloat> transformed = meshes[mesh_id].get_transformed_positions(Mat4f(models[model_id]));
+
+            std::vector<Vec3> positions;
+            positions.reserve(transformed.size() / 3);
+            for (size_t i = 0; i < transformed.size(); i += 3) {
+                positions.emplace_back(transformed[i], transformed[i + 1], transformed[i + 2]);
             }
             return positions;
         }
@@ -353,10 +425,12 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            const Matrix4x4& transform = Matrix4x4::normal_transform(models[model_id]);
-            std::vector<Vec3> normals = meshes[mesh_id].get_normals();
-            for (Vec3& normal : normals) {
-                normal = transform * normal;
+            std::vector<GLfloat> transformed = meshes[mesh_id].get_transformed_normals(Mat4f(models[model_id]).normal_matrix());
+
+            std::vector<Vec3> normals;
+            normals.reserve(transformed.size() / 3);
+            for (size_t i = 0; i < transformed.size(); i += 3) {
+                normals.emplace_back(transformed[i], transformed[i + 1], transformed[i + 2]);
             }
             return normals;
         }
@@ -374,6 +448,90 @@ namespace gre {
             return models[model_id] * meshes[mesh_id].get_center();
         }
 
+        // World space bounds of the model
+        const BoundingBox& get_bounding_box(size_t model_id) const {
+#ifdef _DEBUG
+            if (!models.contains(model_id)) {
+                throw GreOutOfRange(__FILE__, __LINE__, "get_bounding_box, invalid model id.\n\n");
+            }
+#endif // _DEBUG
+
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+            return models.get_model_bounds(model_id).box;
+        }
+
+        const BoundingSphere& get_bounding_sphere(size_t model_id) const {
+#ifdef _DEBUG
+            if (!models.contains(model_id)) {
+                throw GreOutOfRange(__FILE__, __LINE__, "get_bounding_sphere, invalid model id.\n\n");
+            }
+#endif // _DEBUG
+
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+            return models.get_model_bounds(model_id).sphere;
+        }
+
+        // World space sphere around all models, recomputed only after models or meshes change
+        const BoundingSphere& get_bounding_sphere() const {
+            if (bounding_sphere_models_version_ == models.get_version() && bounding_sphere_meshes_version_ == meshes.get_version()) {
+                return bounding_sphere_;
+            }
+
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+            bounding_sphere_ = BoundingSphere();
+            for (const auto& [model_id, model] : models) {
+                bounding_sphere_.extend(models.get_model_bounds(model_id).sphere);
+            }
+            bounding_sphere_models_version_ = models.get_version();
+            bounding_sphere_meshes_version_ = meshes.get_version();
+            return bounding_sphere_;
+        }
+
+        // Distance from the point to the sphere around all models, zero inside of it, cheap enough for sorting every frame
+        double get_distance(const Vec3& point) const {
+            const BoundingSphere& sphere = get_bounding_sphere();
+            if (sphere.empty()) {
+                return std::numeric_limits<double>::max();
+            }
+            return std::max((point - sphere.center).length() - sphere.radius, 0.0);
+        }
+
+        // True if bounds of any model intersect the frustum
+        bool intersects(const Frustum& frustum) const {
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+
+            for (const auto& [model_id, model] : models) {
+                const ModelStorage::ModelBounds& bounds = models.get_model_bounds(model_id);
+                if (frustum.intersects(bounds.sphere) && frustum.intersects(bounds.box)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Instanced draws submit only models intersecting the frustum until the next cull or reset
+        void cull_models(const Frustum& frustum) const {
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+            models.cull_instances(frustum);
+        }
+
+        // Cull shader expected, instanced draws use indirect commands until the next cull or reset
+        void cull_models(const Shader& cull_shader) const {
+            if (meshes.empty() || models.empty()) {
+                models.reset_instances();
+                return;
+            }
+
+            models.set_local_bounds(meshes.get_version(), meshes.get_bounding_box(), meshes.get_bounding_sphere());
+            meshes.update_commands();
+            models.cull_instances(cull_shader, meshes.command_buffer_);
+            meshes.spread_instance_count();
+        }
+
+        void reset_culling() const {
+            models.reset_instances();
+        }
+
         Vec3 get_center(size_t model_id) const {
 #ifdef _DEBUG
             if (!models.contains(model_id)) {
@@ -384,19 +542,7 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            Vec3 center(0, 0, 0);
-            std::unordered_set<Vec3> used_positions;
-            for (const auto& [id, mesh] : meshes) {
-                for (const Vec3& position : mesh.get_positions()) {
-                    if (used_positions.contains(position)) {
-                        continue;
-                    }
-
-                    used_positions.insert(position);
-                    center += position;
-                }
-            }
-            return models[model_id] * (center / static_cast<double>(used_positions.size()));
+            return get_bounding_box(model_id).get_center();
         }
 
         void swap(GraphObject& other) noexcept {
@@ -404,11 +550,10 @@ namespace gre {
             std::swap(border_mask, other.border_mask);
             meshes.swap(other.meshes);
             models.swap(other.models);
-
-            meshes.set_matrix_buffer(models.matrix_buffer_);
         }
 
-        void load_from_file(const std::string& path) {
+        // Compact format packs normals, stores texture coordinates as half floats and omits absent attributes
+        void load_from_file(const std::string& path, bool compact_vertex_format = true) {
             meshes.clear();
 
             Assimp::Importer importer;
@@ -433,7 +578,7 @@ namespace gre {
             std::vector<Mesh> scene_meshes;
             scene_meshes.reserve(scene->mNumMeshes);
             for (size_t i = 0; i < scene->mNumMeshes; ++i) {
-                scene_meshes.push_back(load_mesh_data(scene->mMeshes[i]));
+                scene_meshes.push_back(load_mesh_data(scene->mMeshes[i], compact_vertex_format));
                 scene_meshes.back().material = materials[scene->mMeshes[i]->mMaterialIndex];
                 scene_meshes.back().material.use_vertex_color = scene->mMeshes[i]->GetNumColorChannels() > 0;
             }
@@ -442,12 +587,36 @@ namespace gre {
         }
 
         void draw_depth_map() const {
+            // Meshes share the arena buffers, so the whole object is one multi draw
+            if (models.instances_gpu_culled_ && meshes.is_depth_multi_drawable()) {
+                bind_geometry(meshes.begin()->second);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshes.command_buffer_);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, static_cast<GLsizei>(meshes.size()), 0);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                GRE_CHECK_GL_ERRORS;
+                return;
+            }
+
+            if (models.instances_gpu_culled_) {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshes.command_buffer_);
+            }
+
             for (const auto& [id, mesh] : meshes) {
                 if (!mesh.material.shadow) {
                     continue;
                 }
 
-                mesh.draw(models.size(), Shader());
+                bind_geometry(mesh);
+                if (models.instances_gpu_culled_) {
+                    mesh.draw_indirect(meshes.get_command_offset(meshes.get_memory_id(id)), Shader());
+                }
+                else {
+                    mesh.draw(models.get_count_instances(), Shader());
+                }
+            }
+
+            if (models.instances_gpu_culled_) {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
             }
         }
 
@@ -462,22 +631,12 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            shader.set_uniform_i("model_id", static_cast<GLint>(models.get_memory_id(model_id)));
-            shader.set_uniform_matrix("not_instance_model", models[model_id]);
+            set_border_stencil();
 
-            if (border_mask > 0) {
-                glStencilFunc(GL_ALWAYS, border_mask, 0xFF);
-                glStencilMask(border_mask);
-            }
-
-            meshes[mesh_id].draw(1, shader);
+            bind_geometry(meshes[mesh_id], true);
+            meshes[mesh_id].draw(1, shader, models.get_memory_id(model_id));
 
-            if (border_mask > 0) {
-                glStencilMask(0x00);
-#ifdef _DEBUG
-                check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-            }
+            reset_border_stencil();
         }
 
         // MAIN shader expected
@@ -488,36 +647,20 @@ namespace gre {
             }
 #endif // _DEBUG
 
-            if (border_mask > 0) {
-                glStencilFunc(GL_ALWAYS, border_mask, 0xFF);
-                glStencilMask(border_mask);
-            }
+            set_border_stencil();
 
             draw_meshes(model_id, shader);
 
-            if (border_mask > 0) {
-                glStencilMask(0x00);
-#ifdef _DEBUG
-                check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-            }
+            reset_border_stencil();
         }
 
         // MAIN shader expected
         void draw(const Shader& shader) const {
-            if (border_mask > 0) {
-                glStencilFunc(GL_ALWAYS, border_mask, 0xFF);
-                glStencilMask(border_mask);
-            }
+            set_border_stencil();
 
             draw_meshes(shader);
 
-            if (border_mask > 0) {
-                glStencilMask(0x00);
-#ifdef _DEBUG
-                check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-            }
+            reset_border_stencil();
         }
 
         static GraphObject cube(size_t max_count_models) {
@@ -1,46 +1,74 @@
 #include "Material.hpp"
 
 
+namespace {
+    const gre::UniformHandle MATERIAL_ID_UNIFORM("material_id");
+
+    void copy_vec3(const gre::Vec3& source, GLfloat* destination) noexcept {
+        destination[0] = static_cast<GLfloat>(source.x);
+        destination[1] = static_cast<GLfloat>(source.y);
+        destination[2] = static_cast<GLfloat>(source.z);
+    }
+}  // anonymous namespace
+
+
 // Material
 namespace gre {
+    // Record is trivially copyable and fully initialized, padding included
+    bool Material::Record::operator==(const Record& other) const noexcept {
+        return std::memcmp(this, &other, sizeof(Record)) == 0;
+    }
+
+    size_t Material::RecordHash::operator()(const Record& record) const noexcept {
+        return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&record), sizeof(Record)));
+    }
+
     // MAIN shader expected
     void Material::set_uniforms(const Shader& shader) const {
-        shader.set_uniform_i("use_diffuse_map", diffuse_map.get_id() != 0);
-        shader.set_uniform_i("use_specular_map", specular_map.get_id() != 0);
-        shader.set_uniform_i("use_emission_map", emission_map.get_id() != 0);
+        shader.set_uniform_i(MATERIAL_ID_UNIFORM, get_record_id());
 
-        if (diffuse_map.get_id() == 0) {
-            shader.set_uniform_f("object_material.ambient", ambient_);
-            shader.set_uniform_f("object_material.diffuse", diffuse_);
-            shader.set_uniform_f("object_material.alpha", static_cast<GLfloat>(alpha_));
-        }
+        diffuse_map.activate(0);
+        specular_map.activate(1);
+        emission_map.activate(2);
+    }
 
-        if (specular_map.get_id() == 0) {
-            shader.set_uniform_f("object_material.specular", specular_);
-        }
-        shader.set_uniform_f("object_material.shininess", static_cast<GLfloat>(shininess_));
+    // Constructors
+    Material::Material() {
+    }
 
-        if (emission_map.get_id() == 0) {
-            shader.set_uniform_f("object_material.emission", emission_);
+    Material::Material(const Material& other)
+        : shininess_(other.shininess_)
+        , alpha_(other.alpha_)
+        , ambient_(other.ambient_)
+        , diffuse_(other.diffuse_)
+        , specular_(other.specular_)
+        , emission_(other.emission_)
+        , record_id_(other.record_id_)
+        , shadow(other.shadow)
+        , use_vertex_color(other.use_vertex_color)
+        , diffuse_map(other.diffuse_map)
+        , specular_map(other.specular_map)
+        , emission_map(other.emission_map)
+    {
+        if (record_id_ >= 0) {
+            ++records_references_[record_id_];
         }
+    }
 
-        shader.set_uniform_i("object_material.use_vertex_color", use_vertex_color);
-        shader.set_uniform_i("object_material.shadow", shadow);
-
-        diffuse_map.activate(0);
-        specular_map.activate(1);
-        emission_map.activate(2);
+    Material::Material(Material&& other) noexcept {
+        swap(other);
     }
 
-    // MAIN shader expected
-    void Material::delete_uniforms(const Shader& shader) const {
-        shader.use();
-        diffuse_map.deactive(0);
-        specular_map.deactive(1);
-        emission_map.deactive(2);
+    Material& Material::operator=(const Material& other)& {
+        Material object(other);
+        swap(object);
+        return *this;
     }
 
-    Material::Material() {
+    Material& Material::operator=(Material&& other)& noexcept {
+        Material object(std::move(other));
+        swap(object);
+        return *this;
     }
 
     bool Material::operator==(const Material& other) const noexcept {
@@ -60,6 +88,10 @@ namespace gre {
         return !(*this == other);
     }
 
+    bool Material::is_opaque() const noexcept {
+        return alpha_ >= 1.0 && diffuse_map.get_id() == 0;
+    }
+
     void Material::set_shininess(double shininess) {
         GRE_ENSURE(shininess >= 0.0, GreInvalidArgument, "invalid shininess value");
 
@@ -103,4 +135,133 @@ namespace gre {
     void Material::set_emission(const Vec3& emission) {
         emission_ = emission;
     }
+
+    void Material::swap(Material& other) noexcept {
+        std::swap(shininess_, other.shininess_);
+        std::swap(alpha_, other.alpha_);
+        std::swap(ambient_, other.ambient_);
+        std::swap(diffuse_, other.diffuse_);
+        std::swap(specular_, other.specular_);
+        std::swap(emission_, other.emission_);
+        std::swap(record_id_, other.record_id_);
+        std::swap(shadow, other.shadow);
+        std::swap(use_vertex_color, other.use_vertex_color);
+        diffuse_map.swap(other.diffuse_map);
+        specular_map.swap(other.specular_map);
+        emission_map.swap(other.emission_map);
+    }
+
+    Material::~Material() {
+        if (record_id_ >= 0) {
+            release_record(record_id_);
+        }
+    }
+
+    // Static functions
+    void Material::bind_storage_buffer() {
+        if (storage_buffer_ == 0) {
+            return;
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, storage_buffer_);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Returns referenced record with the given values, a new one takes a released slot before the storage is extended
+    GLint Material::insert_record(const Record& record) {
+        auto iterator = records_index_.find(record);
+        if (iterator != records_index_.end()) {
+            ++records_references_[iterator->second];
+            return iterator->second;
+        }
+
+        GLint record_id = static_cast<GLint>(records_.size());
+        if (!free_records_.empty()) {
+            record_id = free_records_.back();
+            free_records_.pop_back();
+            records_[record_id] = record;
+            records_references_[record_id] = 1;
+        }
+        else {
+            records_.push_back(record);
+            records_references_.push_back(1);
+        }
+        records_index_.emplace(record, record_id);
+
+        upload_record(record_id);
+        return record_id;
+    }
+
+    // Storage buffer grows geometrically, the first allocation is bound to MATERIALS_BINDING of the current context at once
+    void Material::upload_record(GLint record_id) {
+        if (storage_buffer_ == 0) {
+            glGenBuffers(1, &storage_buffer_);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, storage_buffer_);
+        if (records_.size() > storage_capacity_) {
+            storage_capacity_ = std::max(2 * storage_capacity_, static_cast<size_t>(16));
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Record) * storage_capacity_, NULL, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Record) * records_.size(), records_.data());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, storage_buffer_);
+        }
+        else {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(Record) * record_id, sizeof(Record), &records_[record_id]);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Slot of the last reference is kept in the buffer until a new record takes it
+    void Material::release_record(GLint record_id) noexcept {
+        if (--records_references_[record_id] > 0) {
+            return;
+        }
+
+        records_index_.erase(records_[record_id]);
+        free_records_.push_back(record_id);
+    }
+
+    // Private functions
+    Material::Record Material::get_record() const noexcept {
+        Record record;
+        std::memset(&record, 0, sizeof(Record));
+
+        copy_vec3(ambient_, record.ambient);
+        record.alpha = static_cast<GLfloat>(alpha_);
+        copy_vec3(diffuse_, record.diffuse);
+        record.shininess = static_cast<GLfloat>(shininess_);
+        copy_vec3(specular_, record.specular);
+        record.shadow = shadow;
+        copy_vec3(emission_, record.emission);
+        record.use_vertex_color = use_vertex_color;
+        record.use_diffuse_map = diffuse_map.get_id() != 0;
+        record.use_specular_map = specular_map.get_id() != 0;
+        record.use_emission_map = emission_map.get_id() != 0;
+        return record;
+    }
+
+    // Materials with equal values share one record, texture ids are not part of it
+    GLint Material::get_record_id() const {
+        Record record = get_record();
+        if (record_id_ >= 0 && records_[record_id_] == record) {
+            return record_id_;
+        }
+
+        // Record referenced only by this material is rewritten in place, so animated values do not take new slots
+        if (record_id_ >= 0 && records_references_[record_id_] == 1 && !records_index_.contains(record)) {
+            records_index_.erase(records_[record_id_]);
+            records_[record_id_] = record;
+            records_index_.emplace(record, record_id_);
+            upload_record(record_id_);
+            return record_id_;
+        }
+
+        GLint record_id = insert_record(record);
+        if (record_id_ >= 0) {
+            release_record(record_id_);
+        }
+        record_id_ = record_id;
+        return record_id_;
+    }
 }  // namespace gre
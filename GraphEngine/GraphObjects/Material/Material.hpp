@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+#include <unordered_map>
 #include "../../GraphicClasses/graphic_classes.h"
 
 
@@ -7,6 +9,39 @@
 namespace gre {
     class Material {
         friend class Mesh;
+        friend struct std::hash<Material>;
+
+        // Material struct of the MAIN shader in std430 layout
+        struct Record {
+            GLfloat ambient[3];
+            GLfloat alpha;
+            GLfloat diffuse[3];
+            GLfloat shininess;
+            GLfloat specular[3];
+            GLint shadow;
+            GLfloat emission[3];
+            GLint use_vertex_color;
+            GLint use_diffuse_map;
+            GLint use_specular_map;
+            GLint use_emission_map;
+            GLint padding;
+
+            bool operator==(const Record& other) const noexcept;
+        };
+
+        struct RecordHash {
+            size_t operator()(const Record& record) const noexcept;
+        };
+
+        inline static const GLuint MATERIALS_BINDING = 4;
+
+        // Records of drawn materials, shared by materials with equal values, slots of released records are reused
+        inline static GLuint storage_buffer_ = 0;
+        inline static size_t storage_capacity_ = 0;
+        inline static std::vector<Record> records_;
+        inline static std::vector<size_t> records_references_;
+        inline static std::vector<GLint> free_records_;
+        inline static std::unordered_map<Record, GLint, RecordHash> records_index_;
 
         double shininess_ = 1.0;
         double alpha_ = 1.0;
@@ -15,11 +50,21 @@ namespace gre {
         Vec3 specular_ = Vec3(0.0);
         Vec3 emission_ = Vec3(0.0);
 
+        // Last used record, referenced by the material and checked against the current values before use
+        mutable GLint record_id_ = -1;
+
         // MAIN shader expected
         void set_uniforms(const Shader& shader) const;
 
-        // MAIN shader expected
-        void delete_uniforms(const Shader& shader) const;
+        Record get_record() const noexcept;
+
+        GLint get_record_id() const;
+
+        static GLint insert_record(const Record& record);
+
+        static void upload_record(GLint record_id);
+
+        static void release_record(GLint record_id) noexcept;
 
     public:
         bool shadow = true;
@@ -31,10 +76,21 @@ namespace gre {
 
         Material();
 
+        Material(const Material& other);
+
+        Material(Material&& other) noexcept;
+
+        Material& operator=(const Material& other)&;
+
+        Material& operator=(Material&& other)& noexcept;
+
         bool operator==(const Material& other) const noexcept;
 
         bool operator!=(const Material& other) const noexcept;
 
+        // Fragments are neither discarded nor blended, alpha of the diffuse map is unknown on CPU side
+        bool is_opaque() const noexcept;
+
         void set_shininess(double shininess);
 
         void set_alpha(double alpha);
@@ -54,5 +110,31 @@ namespace gre {
         void set_emission(double red, double green, double blue);
 
         void set_emission(const Vec3& emission);
+
+        void swap(Material& other) noexcept;
+
+        // Buffer binding is a state of the context, so every drawing engine binds the records once per frame
+        static void bind_storage_buffer();
+
+        ~Material();
     };
 }  // namespace gre
+
+template <>
+struct std::hash<gre::Material> {
+    size_t operator()(const gre::Material& material) const noexcept {
+        size_t result = 0;
+        gre::hash_combine(result, material.shadow);
+        gre::hash_combine(result, material.use_vertex_color);
+        gre::hash_combine(result, material.shininess_);
+        gre::hash_combine(result, material.alpha_);
+        gre::hash_combine(result, material.ambient_);
+        gre::hash_combine(result, material.diffuse_);
+        gre::hash_combine(result, material.specular_);
+        gre::hash_combine(result, material.emission_);
+        gre::hash_combine(result, material.diffuse_map.get_id());
+        gre::hash_combine(result, material.specular_map.get_id());
+        gre::hash_combine(result, material.emission_map.get_id());
+        return result;
+    }
+};
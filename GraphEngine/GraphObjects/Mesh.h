@@ -7,80 +7,159 @@ namespace gre {
 	class Mesh {
 		inline static const std::vector<GLint> MEMORY_CONFIGURATION = { 3, 3, 2, 3 };
 
-		GLuint vertex_array_ = 0;
-		GLuint vertex_buffer_ = 0;
-		GLuint index_buffer_ = 0;
+		// Geometry arena ranges are shared between copies until modification
+		size_t* count_links_ = nullptr;
+		size_t first_vertex_ = 0;
+		size_t first_index_ = 0;
 
+		VertexFormat vertex_format_;
 		GLfloat border_width_ = 1.0;
 
 		size_t count_points_;
 		size_t count_indices_;
 
+		// CPU mirror of the arena ranges, attributes are stored one after another
+		bool keep_cpu_cache_ = true;
+		std::vector<GLfloat> vertex_cache_;
+		std::vector<GLuint> index_cache_;
+
+		// Object space bounds, updated by set_positions
+		BoundingBox bounding_box_;
+		BoundingSphere bounding_sphere_;
+
+		// Positions are packed by three floats as in the vertex cache
+		void update_bounds(const std::vector<GLfloat>& positions) noexcept {
+			bounding_box_ = BoundingBox();
+			for (size_t i = 0; i < count_points_; ++i) {
+				bounding_box_.extend(Vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]));
+			}
+
+			bounding_sphere_ = BoundingSphere();
+			if (bounding_box_.empty()) {
+				return;
+			}
+
+			bounding_sphere_ = BoundingSphere(bounding_box_.get_center(), 0.0);
+			for (size_t i = 0; i < count_points_; ++i) {
+				Vec3 position(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+				bounding_sphere_.radius = std::max(bounding_sphere_.radius, (position - bounding_sphere_.center).length());
+			}
+		}
+
 		// MAIN or not initialized shader expected
 		void set_uniforms(const Shader& shader) const {
 			if (shader.get_program_id() != 0) {
 				material.set_uniforms(shader);
 			}
+		}
 
-			glLineWidth(border_width_);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+		void allocate_ranges() {
+			GeometryArena& geometry_arena = get_geometry_arena();
+			first_vertex_ = geometry_arena.allocate_vertices(count_points_);
+			first_index_ = geometry_arena.allocate_indices(count_indices_);
+			count_links_ = new size_t(1);
 		}
 
-		// MAIN or not initialized shader expected
-		void delete_uniforms(const Shader& shader) const {
-			if (shader.get_program_id() != 0) {
-				material.delete_uniforms(shader);
+		// Copy on write, should be called before modification of the arena ranges
+		void detach() {
+			if (count_links_ == nullptr) {
+				allocate_ranges();
+				return;
+			}
+			if (*count_links_ == 1) {
+				return;
 			}
 
-			glLineWidth(1.0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			size_t first_vertex = first_vertex_;
+			size_t first_index = first_index_;
+			--(*count_links_);
+			allocate_ranges();
+
+			GeometryArena& geometry_arena = get_geometry_arena();
+			geometry_arena.copy_vertices(first_vertex, first_vertex_, count_points_);
+			geometry_arena.copy_indices(first_index, first_index_, count_indices_);
 		}
 
-		void create_vertex_array() {
-			glGenVertexArrays(1, &vertex_array_);
-			glBindVertexArray(vertex_array_);
+		// Interleaved copy of the arena range
+		std::vector<GLubyte> read_vertices() const {
+			std::vector<GLubyte> vertices(vertex_format_.get_vertex_size() * count_points_);
+			if (count_links_ != nullptr) {
+				get_geometry_arena().get_vertices(first_vertex_, count_points_, vertices.data());
+			}
+			return vertices;
+		}
 
-			glGenBuffers(1, &vertex_buffer_);
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+		// Offset of the attribute in the vertex cache in floats
+		size_t get_attribute_offset(size_t attribute_id) const noexcept {
+			size_t offset = 0;
+			for (size_t i = 0; i < attribute_id; ++i) {
+				offset += MEMORY_CONFIGURATION[i] * count_points_;
+			}
+			return offset;
+		}
 
-			size_t memory_size = 0;
-			for (size_t element : MEMORY_CONFIGURATION) {
-				memory_size += element;
+		void set_attribute(size_t attribute_id, const std::vector<GLfloat>& data) {
+			if (keep_cpu_cache_) {
+				std::copy(data.begin(), data.end(), vertex_cache_.begin() + get_attribute_offset(attribute_id));
 			}
-			glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * memory_size * count_points_, NULL, GL_STATIC_DRAW);
+			if (count_points_ == 0 || !vertex_format_.contains(attribute_id)) {
+				return;
+			}
+
+			detach();
 
-			memory_size = 0;
-			for (GLuint i = 0; i < MEMORY_CONFIGURATION.size(); memory_size += MEMORY_CONFIGURATION[i], ++i) {
-				glVertexAttribPointer(i, MEMORY_CONFIGURATION[i], GL_FLOAT, GL_FALSE, sizeof(GLfloat) * MEMORY_CONFIGURATION[i], reinterpret_cast<GLvoid*>(sizeof(GLfloat) * memory_size * count_points_));
-				glEnableVertexAttribArray(i);
+			// Whole vertices are uploaded, other attributes are taken from the CPU cache or read back
+			std::vector<GLubyte> vertices;
+			if (keep_cpu_cache_) {
+				vertices.resize(vertex_format_.get_vertex_size() * count_points_);
+				for (size_t i = 0; i < MEMORY_CONFIGURATION.size(); ++i) {
+					vertex_format_.encode(i, &vertex_cache_[get_attribute_offset(i)], count_points_, vertices.data());
+				}
 			}
+			else {
+				vertices = read_vertices();
+				vertex_format_.encode(attribute_id, data.data(), count_points_, vertices.data());
+			}
+			get_geometry_arena().set_vertices(first_vertex_, count_points_, vertices.data());
+		}
 
-			glGenBuffers(1, &index_buffer_);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+		// Returns pointer to the attribute data, buffer is used if CPU cache disabled
+		const GLfloat* get_attribute(size_t attribute_id, std::vector<GLfloat>& buffer) const {
+			if (keep_cpu_cache_) {
+				return &vertex_cache_[get_attribute_offset(attribute_id)];
+			}
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			buffer.assign(MEMORY_CONFIGURATION[attribute_id] * count_points_, 0.0);
+			vertex_format_.decode(attribute_id, read_vertices().data(), count_points_, buffer.data());
+			return buffer.data();
+		}
+
+		std::vector<Vec3> get_vec3_attribute(size_t attribute_id) const {
+			std::vector<GLfloat> buffer;
+			const GLfloat* data = get_attribute(attribute_id, buffer);
+
+			std::vector<Vec3> result;
+			result.reserve(count_points_);
+			for (size_t i = 0; i < count_points_; ++i) {
+				result.emplace_back(static_cast<double>(data[3 * i]), static_cast<double>(data[3 * i + 1]), static_cast<double>(data[3 * i + 2]));
+			}
+			return result;
 		}
 
 		void deallocate() {
-			glDeleteVertexArrays(1, &vertex_array_);
-			glDeleteBuffers(1, &vertex_buffer_);
-			glDeleteBuffers(1, &index_buffer_);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			if (count_links_ != nullptr && --(*count_links_) == 0) {
+				GeometryArena& geometry_arena = get_geometry_arena();
+				geometry_arena.deallocate_vertices(first_vertex_, count_points_);
+				geometry_arena.deallocate_indices(first_index_, count_indices_);
+				delete count_links_;
+			}
 
-			vertex_array_ = 0;
-			vertex_buffer_ = 0;
-			index_buffer_ = 0;
+			count_links_ = nullptr;
+			first_vertex_ = 0;
+			first_index_ = 0;
+
+			vertex_cache_.clear();
+			index_cache_.clear();
 		}
 
 	public:
@@ -98,7 +177,7 @@ namespace gre {
 		}
 
 		// Default polygon shape
-		explicit Mesh(size_t count_points) {
+		explicit Mesh(size_t count_points, const VertexFormat& vertex_format = VertexFormat()) {
 			if (!glew_is_ok()) {
 				throw GreRuntimeError(__FILE__, __func__, __LINE__, "Mesh, failed to initialize GLEW.\n\n");
 			}
@@ -108,10 +187,12 @@ namespace gre {
 			}
 #endif // _DEBUG
 
+			vertex_format_ = vertex_format;
 			count_points_ = count_points;
 			count_indices_ = (count_points - 2) * 3;
 
-			create_vertex_array();
+			allocate_ranges();
+			vertex_cache_.resize(get_attribute_offset(MEMORY_CONFIGURATION.size()), 0.0);
 
 			std::vector<GLuint> indices(count_indices_);
 			for (size_t i = 0; i < count_points - 2; ++i) {
@@ -123,37 +204,24 @@ namespace gre {
 		}
 
 		Mesh(const Mesh& other) {
+			vertex_format_ = other.vertex_format_;
 			border_width_ = other.border_width_;
 			count_points_ = other.count_points_;
 			count_indices_ = other.count_indices_;
 			frame = other.frame;
 			material = other.material;
-
-			create_vertex_array();
-
-			glBindVertexArray(vertex_array_);
-			glBindBuffer(GL_COPY_READ_BUFFER, other.vertex_buffer_);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, vertex_buffer_);
-
-			size_t memory_size = 0;
-			for (size_t element : MEMORY_CONFIGURATION) {
-				memory_size += element;
+			keep_cpu_cache_ = other.keep_cpu_cache_;
+			vertex_cache_ = other.vertex_cache_;
+			index_cache_ = other.index_cache_;
+			bounding_box_ = other.bounding_box_;
+			bounding_sphere_ = other.bounding_sphere_;
+
+			count_links_ = other.count_links_;
+			first_vertex_ = other.first_vertex_;
+			first_index_ = other.first_index_;
+			if (count_links_ != nullptr) {
+				++(*count_links_);
 			}
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLfloat) * memory_size * count_points_);
-
-			glBindBuffer(GL_COPY_READ_BUFFER, other.index_buffer_);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, index_buffer_);
-
-			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * count_indices_, NULL, GL_STATIC_DRAW);
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint) * count_indices_);
-
-			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-			glBindBuffer(GL_COPY_READ_BUFFER, 0);
-			glBindVertexArray(0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
 		}
 
 		Mesh(Mesh&& other) noexcept {
@@ -173,7 +241,7 @@ namespace gre {
 		}
 
 		bool operator==(const Mesh& other) const noexcept {
-			return frame == other.frame && material == other.material;
+			return frame == other.frame && material == other.material && vertex_format_ == other.vertex_format_;
 		}
 
 		bool operator!=(const Mesh& other) const noexcept {
@@ -190,7 +258,32 @@ namespace gre {
 			border_width_ = border_width;
 		}
 
-		void set_positions(const std::vector<Vec3>& positions, bool update_normals = false) const {
+		// Disabled cache is freed, getters read data back from GPU
+		void set_keep_cpu_cache(bool keep_cpu_cache) {
+			if (keep_cpu_cache_ == keep_cpu_cache) {
+				return;
+			}
+
+			if (keep_cpu_cache) {
+				std::vector<GLfloat> vertex_cache(get_attribute_offset(MEMORY_CONFIGURATION.size()));
+				std::vector<GLubyte> vertices = read_vertices();
+				for (size_t i = 0; i < MEMORY_CONFIGURATION.size(); ++i) {
+					vertex_format_.decode(i, vertices.data(), count_points_, vertex_cache.data() + get_attribute_offset(i));
+				}
+
+				index_cache_ = get_indices();
+				vertex_cache_.swap(vertex_cache);
+			}
+			else {
+				vertex_cache_.clear();
+				vertex_cache_.shrink_to_fit();
+				index_cache_.clear();
+				index_cache_.shrink_to_fit();
+			}
+			keep_cpu_cache_ = keep_cpu_cache;
+		}
+
+		void set_positions(const std::vector<Vec3>& positions, bool update_normals = false) {
 #ifdef _DEBUG
 			if (positions.size() != count_points_) {
 				throw GreInvalidArgument(__FILE__, __LINE__, "set_positions, invalid number of points.\n\n");
@@ -199,18 +292,14 @@ namespace gre {
 
 			std::vector<GLfloat> converted_positions(count_points_ * 3);
 			for (size_t i = 0; i < count_points_; ++i) {
-				for (size_t j = 0; j < 3; ++j) {
-					converted_positions[3 * i + j] = static_cast<GLfloat>(positions[i][j]);
-				}
+				Vec3f position(positions[i]);
+				converted_positions[3 * i] = position.x;
+				converted_positions[3 * i + 1] = position.y;
+				converted_positions[3 * i + 2] = position.z;
 			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<const GLvoid*>(&converted_positions[0]));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			set_attribute(0, converted_positions);
+			update_bounds(converted_positions);
 
 			if (update_normals) {
 				std::vector<Vec3> normals(count_points_, Vec3(0.0));
@@ -230,7 +319,7 @@ namespace gre {
 			}
 		}
 
-		void set_normals(const std::vector<Vec3>& normals) const {
+		void set_normals(const std::vector<Vec3>& normals) {
 #ifdef _DEBUG
 			if (normals.size() != count_points_) {
 				throw GreInvalidArgument(__FILE__, __LINE__, "set_normals, invalid number of points.\n\n");
@@ -239,21 +328,16 @@ namespace gre {
 
 			std::vector<GLfloat> converted_normals(count_points_ * 3);
 			for (size_t i = 0; i < count_points_; ++i) {
-				for (size_t j = 0; j < 3; ++j) {
-					converted_normals[3 * i + j] = static_cast<GLfloat>(normals[i][j]);
-				}
+				Vec3f normal(normals[i]);
+				converted_normals[3 * i] = normal.x;
+				converted_normals[3 * i + 1] = normal.y;
+				converted_normals[3 * i + 2] = normal.z;
 			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * count_points_, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<const GLvoid*>(&converted_normals[0]));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			set_attribute(1, converted_normals);
 		}
 
-		void set_tex_coords(const std::vector<Vec2>& tex_coords) const {
+		void set_tex_coords(const std::vector<Vec2>& tex_coords) {
 #ifdef _DEBUG
 			if (tex_coords.size() != count_points_) {
 				throw GreInvalidArgument(__FILE__, __LINE__, "set_tex_coords, invalid number of points.\n\n");
@@ -267,16 +351,10 @@ namespace gre {
 				}
 			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * count_points_, sizeof(GLfloat) * 2 * count_points_, reinterpret_cast<const GLvoid*>(&converted_tex_coords[0]));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			set_attribute(2, converted_tex_coords);
 		}
 
-		void set_colors(const std::vector<Vec3>& colors) const {
+		void set_colors(const std::vector<Vec3>& colors) {
 #ifdef _DEBUG
 			if (colors.size() != count_points_) {
 				throw GreInvalidArgument(__FILE__, __LINE__, "set_colors, invalid number of points.\n\n");
@@ -285,46 +363,51 @@ namespace gre {
 
 			std::vector<GLfloat> converted_colors(count_points_ * 3);
 			for (size_t i = 0; i < count_points_; ++i) {
-				for (size_t j = 0; j < 3; ++j) {
-					converted_colors[3 * i + j] = static_cast<GLfloat>(colors[i][j]);
-				}
+				Vec3f color(colors[i]);
+				converted_colors[3 * i] = color.x;
+				converted_colors[3 * i + 1] = color.y;
+				converted_colors[3 * i + 2] = color.z;
 			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 8 * count_points_, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<const GLvoid*>(&converted_colors[0]));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			set_attribute(3, converted_colors);
 		}
 
 		void set_indices(const std::vector<GLuint>& indices) {
-			count_indices_ = indices.size();
 #ifdef _DEBUG
-			if (count_indices_ % 3 != 0) {
+			if (indices.size() % 3 != 0) {
 				throw GreInvalidArgument(__FILE__, __LINE__, "set_indices, invalid number of indices.\n\n");
 			}
 #endif // _DEBUG
 
-			glBindVertexArray(vertex_array_);
+			detach();
 
-			glDeleteBuffers(1, &index_buffer_);
-			glGenBuffers(1, &index_buffer_);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+			GeometryArena& geometry_arena = get_geometry_arena();
+			if (count_indices_ != indices.size()) {
+				geometry_arena.deallocate_indices(first_index_, count_indices_);
+				count_indices_ = indices.size();
+				first_index_ = geometry_arena.allocate_indices(count_indices_);
+			}
+			geometry_arena.set_indices(first_index_, count_indices_, indices.data());
 
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), reinterpret_cast<const GLvoid*>(&indices[0]), GL_STATIC_DRAW);
+			if (keep_cpu_cache_) {
+				index_cache_ = indices;
+			}
+		}
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		GLuint get_vertex_array() const {
+			return get_geometry_arena().get_vertex_array();
+		}
 
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+		const VertexFormat& get_vertex_format() const noexcept {
+			return vertex_format_;
 		}
 
-		GLuint get_vertex_array() const noexcept {
-			return vertex_array_;
+		size_t get_first_vertex() const noexcept {
+			return first_vertex_;
+		}
+
+		size_t get_first_index() const noexcept {
+			return first_index_;
 		}
 
 		size_t get_count_points() const noexcept {
@@ -336,135 +419,106 @@ namespace gre {
 		}
 
 		std::vector<Vec3> get_positions() const {
-			GLfloat* buffer = new GLfloat[3 * count_points_];
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<GLvoid*>(buffer));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-
-			std::vector<Vec3> result;
-			result.reserve(count_points_);
-			for (size_t i = 0; i < count_points_; ++i) {
-				result.emplace_back(static_cast<double>(buffer[3 * i]), static_cast<double>(buffer[3 * i + 1]), static_cast<double>(buffer[3 * i + 2]));
-			}
-			delete[] buffer;
-
-			return result;
+			return get_vec3_attribute(0);
 		}
 
 		std::vector<Vec3> get_normals() const {
-			GLfloat* buffer = new GLfloat[3 * count_points_];
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glGetBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * count_points_, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<GLvoid*>(buffer));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-
-			std::vector<Vec3> result;
-			result.reserve(count_points_);
-			for (size_t i = 0; i < count_points_; ++i) {
-				result.emplace_back(static_cast<double>(buffer[3 * i]), static_cast<double>(buffer[3 * i + 1]), static_cast<double>(buffer[3 * i + 2]));
-			}
-			delete[] buffer;
-
-			return result;
+			return get_vec3_attribute(1);
 		}
 
 		std::vector<Vec2> get_tex_coords() const {
-			GLfloat* buffer = new GLfloat[2 * count_points_];
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glGetBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * count_points_, sizeof(GLfloat) * 2 * count_points_, reinterpret_cast<GLvoid*>(buffer));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			std::vector<GLfloat> buffer;
+			const GLfloat* data = get_attribute(2, buffer);
 
 			std::vector<Vec2> result;
 			result.reserve(count_points_);
 			for (size_t i = 0; i < count_points_; ++i) {
-				result.emplace_back(static_cast<double>(buffer[2 * i]), static_cast<double>(buffer[2 * i + 1]));
+				result.emplace_back(static_cast<double>(data[2 * i]), static_cast<double>(data[2 * i + 1]));
 			}
-			delete[] buffer;
-
 			return result;
 		}
 
 		std::vector<Vec3> get_colors() const {
-			GLfloat* buffer = new GLfloat[3 * count_points_];
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glGetBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 8 * count_points_, sizeof(GLfloat) * 3 * count_points_, reinterpret_cast<GLvoid*>(buffer));
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			return get_vec3_attribute(3);
+		}
 
-			std::vector<Vec3> result;
-			result.reserve(count_points_);
-			for (size_t i = 0; i < count_points_; ++i) {
-				result.emplace_back(static_cast<double>(buffer[3 * i]), static_cast<double>(buffer[3 * i + 1]), static_cast<double>(buffer[3 * i + 2]));
-			}
-			delete[] buffer;
+		// Positions multiplied by the matrix in single precision, packed by three floats
+		std::vector<GLfloat> get_transformed_positions(const Mat4f& transform) const {
+			std::vector<GLfloat> buffer;
+			std::vector<GLfloat> result(count_points_ * 3);
+			Mat4f::transform_points(transform, get_attribute(0, buffer), result.data(), count_points_);
+			return result;
+		}
 
+		// Normals multiplied by the normal matrix in single precision, packed by three floats
+		std::vector<GLfloat> get_transformed_normals(const Mat4f& normal_matrix) const {
+			std::vector<GLfloat> buffer;
+			std::vector<GLfloat> result(count_points_ * 3);
+			Mat4f::transform_directions(normal_matrix, get_attribute(1, buffer), result.data(), count_points_);
 			return result;
 		}
 
 		std::vector<GLuint> get_indices() const {
-			GLuint* buffer = new GLuint[count_indices_];
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
-			glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint) * count_indices_, reinterpret_cast<GLvoid*>(buffer));
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			if (keep_cpu_cache_) {
+				return index_cache_;
+			}
 
 			std::vector<GLuint> result(count_indices_);
-			for (size_t i = 0; i < count_indices_; ++i) {
-				result[i] = buffer[i];
+			if (count_links_ != nullptr) {
+				get_geometry_arena().get_indices(first_index_, count_indices_, result.data());
 			}
-			delete[] buffer;
-
 			return result;
 		}
 
+		const BoundingBox& get_bounding_box() const noexcept {
+			return bounding_box_;
+		}
+
+		const BoundingSphere& get_bounding_sphere() const noexcept {
+			return bounding_sphere_;
+		}
+
+		bool get_keep_cpu_cache() const noexcept {
+			return keep_cpu_cache_;
+		}
+
 		Vec3 get_center() const {
-			const std::vector<Vec3>& positions = get_positions();
+			std::vector<GLfloat> buffer;
+			const GLfloat* positions = get_attribute(0, buffer);
+
 			Vec3 center(0.0);
-			for (const Vec3& position : positions) {
-				center += position;
+			for (size_t i = 0; i < count_points_; ++i) {
+				center += Vec3(static_cast<double>(positions[3 * i]), static_cast<double>(positions[3 * i + 1]), static_cast<double>(positions[3 * i + 2]));
 			}
 
-			return center / static_cast<double>(positions.size());
+			return center / static_cast<double>(count_points_);
 		}
 
 		void swap(Mesh& other) noexcept {
-			std::swap(vertex_array_, other.vertex_array_);
-			std::swap(vertex_buffer_, other.vertex_buffer_);
-			std::swap(index_buffer_, other.index_buffer_);
+			std::swap(count_links_, other.count_links_);
+			std::swap(first_vertex_, other.first_vertex_);
+			std::swap(first_index_, other.first_index_);
+			std::swap(vertex_format_, other.vertex_format_);
 			std::swap(border_width_, other.border_width_);
 			std::swap(count_points_, other.count_points_);
 			std::swap(count_indices_, other.count_indices_);
 			std::swap(frame, other.frame);
 			std::swap(material, other.material);
+			std::swap(keep_cpu_cache_, other.keep_cpu_cache_);
+			vertex_cache_.swap(other.vertex_cache_);
+			index_cache_.swap(other.index_cache_);
+			std::swap(bounding_box_, other.bounding_box_);
+			std::swap(bounding_sphere_, other.bounding_sphere_);
 		}
 
 		void apply_matrix(const Matrix4x4& transform) {
-			const Matrix4x4& normal_transform = Matrix4x4::normal_transform(transform);
-			std::vector<Vec3> positions = get_positions();
-			std::vector<Vec3> normals = get_normals();
-			for (size_t i = 0; i < count_points_; ++i) {
-				positions[i] = transform * positions[i];
-				normals[i] = normal_transform * normals[i];
-			}
-			set_positions(positions);
-			set_normals(normals);
+			Mat4f matrix(transform);
+			std::vector<GLfloat> positions = get_transformed_positions(matrix);
+			std::vector<GLfloat> normals = get_transformed_normals(matrix.normal_matrix());
+
+			set_attribute(0, positions);
+			update_bounds(positions);
+			set_attribute(1, normals);
 		}
 
 		void invert_points_order(bool update_normals = false) {
@@ -473,28 +527,53 @@ namespace gre {
 			set_positions(positions, update_normals);
 		}
 
-		// MAIN or not initialized shader expected
-		void draw(size_t count, const Shader& shader) const {
+		// MAIN or not initialized shader expected, geometry arena should be bound with the instance buffer
+		void draw(size_t count, const Shader& shader, size_t base_instance = 0) const {
 			if (count == 0) {
 				return;
 			}
 
 			set_uniforms(shader);
+			draw_geometry(count, base_instance);
+		}
 
-			glBindVertexArray(vertex_array_);
+		// MAIN or not initialized shader expected, command is read from the bound draw indirect buffer
+		void draw_indirect(GLintptr command_offset, const Shader& shader) const {
+			set_uniforms(shader);
+			draw_geometry_indirect(command_offset);
+		}
+
+		// Material uniforms set by the previous draw are reused, instances are read starting from the base one
+		void draw_geometry(size_t count, size_t base_instance = 0) const {
+			if (count == 0) {
+				return;
+			}
+
+			const GLvoid* indices_offset = reinterpret_cast<const GLvoid*>(sizeof(GLuint) * first_index_);
 			if (!frame) {
-				glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(count_indices_), GL_UNSIGNED_INT, NULL, static_cast<GLsizei>(count));
+				glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(count_indices_), GL_UNSIGNED_INT, indices_offset, static_cast<GLsizei>(count), static_cast<GLint>(first_vertex_), static_cast<GLuint>(base_instance));
 			}
 			else {
-				glDrawElementsInstanced(GL_LINE_LOOP, static_cast<GLsizei>(count_indices_), GL_UNSIGNED_INT, NULL, static_cast<GLsizei>(count));
+				glLineWidth(border_width_);
+				glDrawElementsInstancedBaseVertexBaseInstance(GL_LINE_LOOP, static_cast<GLsizei>(count_indices_), GL_UNSIGNED_INT, indices_offset, static_cast<GLsizei>(count), static_cast<GLint>(first_vertex_), static_cast<GLuint>(base_instance));
+				glLineWidth(1.0);
 			}
-			glBindVertexArray(0);
 
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Material uniforms set by the previous draw are reused
+		void draw_geometry_indirect(GLintptr command_offset) const {
+			if (!frame) {
+				glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(command_offset));
+			}
+			else {
+				glLineWidth(border_width_);
+				glDrawElementsIndirect(GL_LINE_LOOP, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(command_offset));
+				glLineWidth(1.0);
+			}
 
-			delete_uniforms(shader);
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		~Mesh() {
@@ -504,5 +583,21 @@ namespace gre {
 		static size_t get_count_params() noexcept {
 			return MEMORY_CONFIGURATION.size();
 		}
+
+		GeometryArena& get_geometry_arena() const {
+			return get_geometry_arena(vertex_format_);
+		}
+
+		// Arena per vertex format, never destroyed, so no openGL calls are made after the context is closed,
+		// buffers are shared by all contexts and each state cache keeps its own vertex array of the arena
+		static GeometryArena& get_geometry_arena(const VertexFormat& vertex_format) {
+			static std::unordered_map<size_t, GeometryArena*> geometry_arenas;
+
+			GeometryArena*& geometry_arena = geometry_arenas[vertex_format.get_id()];
+			if (geometry_arena == nullptr) {
+				geometry_arena = new GeometryArena(vertex_format);
+			}
+			return *geometry_arena;
+		}
 	};
 }
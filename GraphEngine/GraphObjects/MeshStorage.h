@@ -7,12 +7,31 @@ namespace gre {
 	class MeshStorage {
 		friend class GraphObject;
 
-		GLuint matrix_buffer_ = 0;
+		// Arguments of glDrawElementsIndirect
+		struct DrawCommand {
+			GLuint count;
+			GLuint instance_count;
+			GLuint first_index;
+			GLint base_vertex;
+			GLuint base_instance;
+		};
 
 		std::vector<size_t> meshes_index_;
 		std::vector<size_t> free_mesh_id_;
 		std::vector<std::pair<size_t, Mesh>> meshes_;
 
+		// Version changes on each modification, unique among all storages
+		inline static size_t last_version_ = 0;
+		size_t version_ = ++last_version_;
+
+		mutable size_t bounds_version_ = 0;
+		mutable BoundingBox bounding_box_;
+		mutable BoundingSphere bounding_sphere_;
+
+		// Draw command per mesh in memory order, instance counts are filled by the cull shader
+		mutable GLuint command_buffer_ = 0;
+		mutable size_t commands_version_ = 0;
+
 		MeshStorage() noexcept {
 		}
 
@@ -20,8 +39,6 @@ namespace gre {
 			meshes_index_ = other.meshes_index_;
 			free_mesh_id_ = other.free_mesh_id_;
 			meshes_ = other.meshes_;
-
-			set_matrix_buffer(other.matrix_buffer_);
 		}
 
 		MeshStorage(MeshStorage&& other) noexcept {
@@ -39,46 +56,103 @@ namespace gre {
 			return *this;
 		}
 
-		void set_mesh_matrix_buffer(Mesh& mesh) const {
-			if (matrix_buffer_ == 0) {
+		// Rebuilds commands after modifications, resets instance count before culling
+		void update_commands() const {
+			if (commands_version_ == version_) {
+				const GLuint instance_count = 0;
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+				glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(DrawCommand, instance_count), sizeof(GLuint), &instance_count);
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+				GRE_CHECK_GL_ERRORS;
 				return;
 			}
 
-			glBindVertexArray(mesh.get_vertex_array());
-			glBindBuffer(GL_ARRAY_BUFFER, matrix_buffer_);
+			std::vector<DrawCommand> commands;
+			commands.reserve(meshes_.size());
+			for (const auto& [id, mesh] : meshes_) {
+				commands.push_back({ static_cast<GLuint>(mesh.get_count_indices()), 0, static_cast<GLuint>(mesh.get_first_index()), static_cast<GLint>(mesh.get_first_vertex()), 0 });
+			}
 
-			GLuint attrib_offset = static_cast<GLuint>(Mesh::get_count_params());
-			for (GLuint i = 0; i < 4; ++i) {
-				glVertexAttribPointer(attrib_offset + i, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, reinterpret_cast<GLvoid*>(sizeof(GLfloat) * 4 * i));
-				glEnableVertexAttribArray(attrib_offset + i);
-				glVertexAttribDivisor(attrib_offset + i, 1);
+			if (command_buffer_ == 0) {
+				glGenBuffers(1, &command_buffer_);
 			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand) * commands.size(), commands.data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
 
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			commands_version_ = version_;
 		}
 
-		void set_matrix_buffer(GLuint matrix_buffer) {
-			if (matrix_buffer_ == matrix_buffer) {
-				return;
+		// Copies instance count of the first command into the others on GPU side
+		void spread_instance_count() const {
+			glBindBuffer(GL_COPY_READ_BUFFER, command_buffer_);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, command_buffer_);
+			for (size_t i = 1; i < meshes_.size(); ++i) {
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(DrawCommand, instance_count), sizeof(DrawCommand) * i + offsetof(DrawCommand, instance_count), sizeof(GLuint));
 			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+			GRE_CHECK_GL_ERRORS;
+		}
 
-			matrix_buffer_ = matrix_buffer;
+		GLintptr get_command_offset(size_t memory_id) const noexcept {
+			return static_cast<GLintptr>(sizeof(DrawCommand) * memory_id);
+		}
 
-			for (auto& [id, mesh] : meshes_) {
-				set_mesh_matrix_buffer(mesh);
+		// All commands can be submitted by one multi draw call if every mesh has the same vertex format and is drawn by the depth pass as triangles
+		bool is_depth_multi_drawable() const noexcept {
+			if (meshes_.empty()) {
+				return false;
 			}
+
+			for (const auto& [id, mesh] : meshes_) {
+				if (!mesh.material.shadow || mesh.frame || mesh.get_vertex_format() != meshes_[0].second.get_vertex_format()) {
+					return false;
+				}
+			}
+			return true;
 		}
 
 		void swap(MeshStorage& other) noexcept {
-			std::swap(matrix_buffer_, other.matrix_buffer_);
 			meshes_index_.swap(other.meshes_index_);
 			free_mesh_id_.swap(other.free_mesh_id_);
 			meshes_.swap(other.meshes_);
+			std::swap(version_, other.version_);
+			std::swap(bounds_version_, other.bounds_version_);
+			std::swap(bounding_box_, other.bounding_box_);
+			std::swap(bounding_sphere_, other.bounding_sphere_);
+			std::swap(command_buffer_, other.command_buffer_);
+			std::swap(commands_version_, other.commands_version_);
+		}
+
+		void update_version() noexcept {
+			version_ = ++last_version_;
+		}
+
+		void update_bounds() const noexcept {
+			if (bounds_version_ == version_) {
+				return;
+			}
+
+			bounding_box_ = BoundingBox();
+			for (const auto& [id, mesh] : meshes_) {
+				bounding_box_.extend(mesh.get_bounding_box());
+			}
+
+			bounding_sphere_ = BoundingSphere();
+			if (!bounding_box_.empty()) {
+				bounding_sphere_ = BoundingSphere(bounding_box_.get_center(), 0.0);
+				for (const auto& [id, mesh] : meshes_) {
+					const BoundingSphere& sphere = mesh.get_bounding_sphere();
+					if (!sphere.empty()) {
+						bounding_sphere_.radius = std::max(bounding_sphere_.radius, (sphere.center - bounding_sphere_.center).length() + sphere.radius);
+					}
+				}
+			}
+			bounds_version_ = version_;
 		}
 
 	public:
@@ -124,6 +198,21 @@ namespace gre {
 			return meshes_[memory_id].first;
 		}
 
+		size_t get_version() const noexcept {
+			return version_;
+		}
+
+		// Union of the mesh bounds in object space
+		const BoundingBox& get_bounding_box() const noexcept {
+			update_bounds();
+			return bounding_box_;
+		}
+
+		const BoundingSphere& get_bounding_sphere() const noexcept {
+			update_bounds();
+			return bounding_sphere_;
+		}
+
 		bool contains(size_t id) const noexcept {
 			return id < meshes_index_.size() && meshes_index_[id] < std::numeric_limits<size_t>::max();
 		}
@@ -162,12 +251,14 @@ namespace gre {
 
 			meshes_.pop_back();
 			meshes_index_[id] = std::numeric_limits<size_t>::max();
+			update_version();
 		}
 
 		void clear() noexcept {
 			meshes_index_.clear();
 			free_mesh_id_.clear();
 			meshes_.clear();
+			update_version();
 		}
 
 		size_t insert(const Mesh& mesh) {
@@ -182,7 +273,7 @@ namespace gre {
 			}
 
 			meshes_.push_back({ free_mesh_id, mesh });
-			set_mesh_matrix_buffer(meshes_.back().second);
+			update_version();
 			return free_mesh_id;
 		}
 
@@ -193,7 +284,8 @@ namespace gre {
 			}
 #endif // _DEBUG
 
-			set_mesh_matrix_buffer(meshes_[meshes_index_[id]].second = mesh);
+			meshes_[meshes_index_[id]].second = mesh;
+			update_version();
 		}
 
 		void apply_func(size_t id, std::function<void(Mesh&)> func) {
@@ -205,15 +297,17 @@ namespace gre {
 
 			Mesh object(meshes_[meshes_index_[id]].second);
 			func(object);
-			set_mesh_matrix_buffer(meshes_[meshes_index_[id]].second = object);
+			meshes_[meshes_index_[id]].second = object;
+			update_version();
 		}
 
 		void apply_func(std::function<void(Mesh&)> func) {
 			for (auto& [id, mesh] : meshes_) {
 				Mesh object(mesh);
 				func(object);
-				set_mesh_matrix_buffer(mesh = object);
+				mesh = object;
 			}
+			update_version();
 		}
 
 		void compress() {
@@ -250,7 +344,7 @@ namespace gre {
 					--i;
 				}
 
-				new_meshes.push_back(Mesh(positions.size()));
+				new_meshes.push_back(Mesh(positions.size(), current_mesh.get_vertex_format()));
 				new_meshes.back().set_positions(positions);
 				new_meshes.back().set_normals(normals);
 				new_meshes.back().set_tex_coords(tex_coords);
@@ -263,5 +357,10 @@ namespace gre {
 				insert(mesh);
 			}
 		}
+
+		~MeshStorage() {
+			glDeleteBuffers(1, &command_buffer_);
+			GRE_CHECK_GL_ERRORS;
+		}
 	};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include "Material/Material.hpp"
 
 
@@ -7,6 +8,24 @@ namespace gre {
 	class ModelStorage {
 		friend class GraphObject;
 
+		inline static const UniformHandle NUMBER_INSTANCES_UNIFORM = UniformHandle("number_instances");
+		inline static const UniformHandle BOUNDING_SPHERE_UNIFORM = UniformHandle("bounding_sphere");
+		inline static const UniformHandle BOX_MIN_UNIFORM = UniformHandle("box_min");
+		inline static const UniformHandle BOX_MAX_UNIFORM = UniformHandle("box_max");
+
+		inline static const size_t MIN_COUNT_MODELS = 8;
+
+	public:
+		// Per instance vertex attributes: model matrix, normal matrix columns padded to four floats and model memory id
+		struct InstanceRecord {
+			GLfloat model[16];
+			GLfloat normal[12];
+			GLuint model_id;
+			GLuint padding[3];
+		};
+
+	private:
+		// Visible instances written by the last cull, all instances are read from the stream buffer
 		GLuint matrix_buffer_ = 0;
 
 		size_t max_count_models_;
@@ -14,6 +33,35 @@ namespace gre {
 		std::vector<size_t> free_model_id_;
 		std::vector<std::pair<size_t, Matrix4x4>> models_;
 
+		// Number of instance buffer reallocations caused by insertions in all storages
+		inline static size_t count_growths_ = 0;
+
+		// Version changes on each modification, unique among all storages
+		inline static size_t last_version_ = 0;
+		size_t version_ = ++last_version_;
+
+		// World space bounds of the models, recalculated lazily
+		struct ModelBounds {
+			bool valid = false;
+			BoundingBox box;
+			BoundingSphere sphere;
+		};
+
+		mutable size_t local_bounds_version_ = 0;
+		mutable BoundingBox local_box_;
+		mutable BoundingSphere local_sphere_;
+		mutable std::vector<ModelBounds> models_bounds_;
+
+		// Instances of all models in memory order, changed records reach the GPU on the next bind or cull
+		std::vector<InstanceRecord> instance_records_;
+		std::unique_ptr<StreamBuffer> stream_buffer_;
+		mutable std::vector<InstanceRecord> visible_records_;
+		mutable bool instances_compacted_ = false;
+		mutable size_t count_instances_ = 0;
+
+		// Instance count is known only to the draw commands written by the cull shader
+		mutable bool instances_gpu_culled_ = false;
+
 		ModelStorage() noexcept {
 			max_count_models_ = 0;
 		}
@@ -23,20 +71,18 @@ namespace gre {
 			models_index_ = other.models_index_;
 			free_model_id_ = other.free_model_id_;
 			models_ = other.models_;
-
-			create_matrix_buffer(max_count_models_);
-
-			glBindBuffer(GL_COPY_READ_BUFFER, other.matrix_buffer_);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, matrix_buffer_);
-
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLfloat) * 16 * max_count_models_);
-
-			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-			glBindBuffer(GL_COPY_READ_BUFFER, 0);
-
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			local_bounds_version_ = other.local_bounds_version_;
+			local_box_ = other.local_box_;
+			local_sphere_ = other.local_sphere_;
+			models_bounds_ = other.models_bounds_;
+			instance_records_ = other.instance_records_;
+
+			if (other.stream_buffer_ != nullptr) {
+				create_matrix_buffer(max_count_models_);
+				if (!instance_records_.empty()) {
+					stream_buffer_->invalidate(0, sizeof(InstanceRecord) * instance_records_.size());
+				}
+			}
 		}
 
 		ModelStorage(ModelStorage&& other) noexcept {
@@ -56,36 +102,152 @@ namespace gre {
 		}
 
 		GLuint create_matrix_buffer(size_t max_count_models) {
+			resize_matrix_buffer(max_count_models);
+			return matrix_buffer_;
+		}
+
+		// Buffers are reallocated with the new capacity, instances are migrated on GPU
+		void resize_matrix_buffer(size_t max_count_models) {
+			GLuint matrix_buffer = 0;
+			glGenBuffers(1, &matrix_buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, matrix_buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(InstanceRecord) * max_count_models, NULL, GL_DYNAMIC_DRAW);
+
+			// Visible instances written by the cull shader exist only on GPU
+			if (matrix_buffer_ != 0 && instances_compacted_) {
+				glBindBuffer(GL_COPY_READ_BUFFER, matrix_buffer_);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(InstanceRecord) * std::min(max_count_models_, max_count_models));
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			glDeleteBuffers(1, &matrix_buffer_);
+			matrix_buffer_ = matrix_buffer;
+
+			if (stream_buffer_ == nullptr) {
+				stream_buffer_ = std::make_unique<StreamBuffer>(sizeof(InstanceRecord) * max_count_models);
+			}
+			else {
+				stream_buffer_->resize(sizeof(InstanceRecord) * max_count_models);
+			}
 			max_count_models_ = max_count_models;
 
-			glGenBuffers(1, &matrix_buffer_);
-			glBindBuffer(GL_ARRAY_BUFFER, matrix_buffer_);
+			GRE_CHECK_GL_ERRORS;
+		}
 
-			glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 16 * max_count_models, NULL, GL_DYNAMIC_DRAW);
+		void update_matrix(size_t memory_id) {
+			if (instance_records_.size() <= memory_id) {
+				instance_records_.resize(memory_id + 1);
+			}
 
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			// Normal matrix is calculated once per change instead of once per vertex
+			InstanceRecord& record = instance_records_[memory_id];
+			Mat4f matrix(models_[memory_id].second);
+			matrix.store(record.model);
+			matrix.normal_matrix().store(record.normal, 3);
+			record.model_id = static_cast<GLuint>(memory_id);
 
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-			return matrix_buffer_;
+			if (stream_buffer_ != nullptr) {
+				stream_buffer_->invalidate(sizeof(InstanceRecord) * memory_id, sizeof(InstanceRecord));
+			}
+		}
+
+		// Writes changed records into the next region of the stream buffer
+		void flush_instances() const {
+			if (stream_buffer_ == nullptr || !stream_buffer_->is_dirty()) {
+				return;
+			}
+
+			stream_buffer_->flush(reinterpret_cast<const GLubyte*>(instance_records_.data()), sizeof(InstanceRecord) * instance_records_.size());
 		}
 
-		void update_matrix(size_t memory_id) const {
+		// Visible instances after culling, all models in memory order otherwise or if requested
+		void bind_instances(const GeometryArena& geometry_arena, bool all_models) const {
+			if (instances_compacted_ && !all_models) {
+				geometry_arena.bind(matrix_buffer_, sizeof(InstanceRecord));
+				return;
+			}
+
+			flush_instances();
+			if (stream_buffer_ == nullptr) {
+				geometry_arena.bind(0, sizeof(InstanceRecord));
+				return;
+			}
+			geometry_arena.bind(stream_buffer_->get_id(), sizeof(InstanceRecord), static_cast<GLintptr>(stream_buffer_->get_offset()));
+		}
+
+		// Replaces visible instances, previous storage is orphaned to avoid synchronization with pending draws
+		void upload_instances(const std::vector<InstanceRecord>& records) const {
 			glBindBuffer(GL_ARRAY_BUFFER, matrix_buffer_);
-			glBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 16 * memory_id, sizeof(GLfloat) * 16, &std::vector<GLfloat>(models_[memory_id].second)[0]);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceRecord) * max_count_models_, NULL, GL_DYNAMIC_DRAW);
+			if (!records.empty()) {
+				glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(InstanceRecord) * records.size(), records.data());
+			}
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GRE_CHECK_GL_ERRORS;
+
+			count_instances_ = records.size();
+			instances_gpu_culled_ = false;
+		}
+
+		// Cull shader writes visible instances into the instance buffer and their count into the first draw command
+		void cull_instances(const Shader& cull_shader, GLuint command_buffer) const {
+			flush_instances();
+
+			const Vec3& center = local_sphere_.center;
+			cull_shader.set_uniform_ui(NUMBER_INSTANCES_UNIFORM, static_cast<GLuint>(models_.size()));
+			cull_shader.set_uniform_f(BOUNDING_SPHERE_UNIFORM, static_cast<GLfloat>(center.x), static_cast<GLfloat>(center.y), static_cast<GLfloat>(center.z), static_cast<GLfloat>(local_sphere_.radius));
+			cull_shader.set_uniform_f(BOX_MIN_UNIFORM, local_box_.min_point);
+			cull_shader.set_uniform_f(BOX_MAX_UNIFORM, local_box_.max_point);
+
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, stream_buffer_->get_id(), static_cast<GLintptr>(stream_buffer_->get_offset()), sizeof(InstanceRecord) * models_.size());
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, matrix_buffer_);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, command_buffer);
+
+			size_t group_size = static_cast<size_t>(cull_shader.get_work_group_size()[0]);
+			cull_shader.dispatch(static_cast<GLuint>((models_.size() + group_size - 1) / group_size));
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+			GRE_CHECK_GL_ERRORS;
+
+			instances_compacted_ = true;
+			instances_gpu_culled_ = true;
+		}
+
+		// Leaves in the instance buffer only models intersecting the frustum
+		void cull_instances(const Frustum& frustum) const {
+			visible_records_.clear();
+			for (size_t memory_id = 0; memory_id < models_.size(); ++memory_id) {
+				const ModelBounds& bounds = get_model_bounds(models_[memory_id].first);
+				if (frustum.intersects(bounds.sphere) && frustum.intersects(bounds.box)) {
+					visible_records_.push_back(instance_records_[memory_id]);
+				}
+			}
+
+			if (visible_records_.size() == models_.size()) {
+				reset_instances();
+				return;
+			}
+
+			upload_instances(visible_records_);
+			instances_compacted_ = true;
+		}
+
+		// Instanced draws read all models from the stream buffer again
+		void reset_instances() const {
+			instances_compacted_ = false;
+			instances_gpu_culled_ = false;
+		}
+
+		// Number of instances in the instance buffer
+		size_t get_count_instances() const noexcept {
+			return instances_compacted_ ? count_instances_ : models_.size();
 		}
 
 		void deallocate() {
 			glDeleteBuffers(1, &matrix_buffer_);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			stream_buffer_.reset();
+			GRE_CHECK_GL_ERRORS;
 
 			matrix_buffer_ = 0;
 		}
@@ -96,6 +258,52 @@ namespace gre {
 			models_index_.swap(other.models_index_);
 			free_model_id_.swap(other.free_model_id_);
 			models_.swap(other.models_);
+			std::swap(local_bounds_version_, other.local_bounds_version_);
+			std::swap(local_box_, other.local_box_);
+			std::swap(local_sphere_, other.local_sphere_);
+			models_bounds_.swap(other.models_bounds_);
+			instance_records_.swap(other.instance_records_);
+			stream_buffer_.swap(other.stream_buffer_);
+			visible_records_.swap(other.visible_records_);
+			std::swap(instances_compacted_, other.instances_compacted_);
+			std::swap(count_instances_, other.count_instances_);
+			std::swap(instances_gpu_culled_, other.instances_gpu_culled_);
+			std::swap(version_, other.version_);
+		}
+
+		void update_version() noexcept {
+			version_ = ++last_version_;
+		}
+
+		// Object space bounds of the meshes, version is used to skip repeated updates
+		void set_local_bounds(size_t version, const BoundingBox& box, const BoundingSphere& sphere) const {
+			if (local_bounds_version_ == version) {
+				return;
+			}
+
+			local_bounds_version_ = version;
+			local_box_ = box;
+			local_sphere_ = sphere;
+			for (ModelBounds& bounds : models_bounds_) {
+				bounds.valid = false;
+			}
+		}
+
+		const ModelBounds& get_model_bounds(size_t id) const {
+#ifdef _DEBUG
+			if (!contains(id)) {
+				throw GreOutOfRange(__FILE__, __LINE__, "get_model_bounds, invalid model id.\n\n");
+			}
+#endif // _DEBUG
+
+			ModelBounds& bounds = models_bounds_[models_index_[id]];
+			if (!bounds.valid) {
+				const Matrix4x4& matrix = models_[models_index_[id]].second;
+				bounds.box = local_box_.transform(matrix);
+				bounds.sphere = local_sphere_.transform(matrix);
+				bounds.valid = true;
+			}
+			return bounds;
 		}
 
 	public:
@@ -119,7 +327,32 @@ namespace gre {
 #endif // _DEBUG
 
 			models_[models_index_[id]].second = matrix;
+			models_bounds_[models_index_[id]].valid = false;
 			update_matrix(models_index_[id]);
+			update_version();
+		}
+
+		// Changes of many models are written into the same stream buffer region
+		void set_many(std::span<const size_t> ids, std::span<const Matrix4x4> matrices) {
+#ifdef _DEBUG
+			if (ids.size() != matrices.size()) {
+				throw GreInvalidArgument(__FILE__, __LINE__, "set_many, number of ids and matrices are not equal.\n\n");
+			}
+#endif // _DEBUG
+
+			for (size_t i = 0; i < ids.size(); ++i) {
+#ifdef _DEBUG
+				if (!contains(ids[i])) {
+					throw GreOutOfRange(__FILE__, __LINE__, "set_many, invalid model id.\n\n");
+				}
+#endif // _DEBUG
+
+				size_t memory_id = models_index_[ids[i]];
+				models_[memory_id].second = matrices[i];
+				models_bounds_[memory_id].valid = false;
+				update_matrix(memory_id);
+			}
+			update_version();
 		}
 
 		Matrix4x4 get(size_t id) const {
@@ -152,10 +385,32 @@ namespace gre {
 			return models_[memory_id].first;
 		}
 
+		size_t get_version() const noexcept {
+			return version_;
+		}
+
+		// Capacity of the instance buffers, doubled when an insertion does not fit
 		size_t get_max_count_models() const noexcept {
 			return max_count_models_;
 		}
 
+		static size_t get_count_growths() noexcept {
+			return count_growths_;
+		}
+
+		void reserve(size_t max_count_models) {
+			if (max_count_models > max_count_models_ || stream_buffer_ == nullptr) {
+				resize_matrix_buffer(std::max(max_count_models, max_count_models_));
+			}
+		}
+
+		// Capacity is reduced to the number of models, at least one instance is kept
+		void shrink_to_fit() {
+			if (stream_buffer_ != nullptr && max_count_models_ > std::max(models_.size(), static_cast<size_t>(1))) {
+				resize_matrix_buffer(std::max(models_.size(), static_cast<size_t>(1)));
+			}
+		}
+
 		bool contains(size_t id) const noexcept {
 			return id < models_index_.size() && models_index_[id] < std::numeric_limits<size_t>::max();
 		}
@@ -191,25 +446,34 @@ namespace gre {
 
 			models_index_[models_.back().first] = models_index_[id];
 			models_[models_index_[id]] = models_.back();
+			models_bounds_[models_index_[id]] = models_bounds_.back();
 
 			update_matrix(models_index_[id]);
 
 			models_.pop_back();
+			models_bounds_.pop_back();
+			instance_records_.pop_back();
 			models_index_[id] = std::numeric_limits<size_t>::max();
+			update_version();
 		}
 
 		void clear() noexcept {
 			models_index_.clear();
 			free_model_id_.clear();
 			models_.clear();
+			models_bounds_.clear();
+			instance_records_.clear();
+			instances_compacted_ = false;
+			instances_gpu_culled_ = false;
+			update_version();
 		}
 
 		size_t insert(const Matrix4x4& matrix) {
-#ifdef _DEBUG
-			if (models_.size() == max_count_models_) {
-				throw GreRuntimeError(__FILE__, __LINE__, "insert, too many instances created.\n\n");
+			// Geometric growth keeps the amortized cost of insertion constant
+			if (stream_buffer_ == nullptr || models_.size() == max_count_models_) {
+				resize_matrix_buffer(std::max(2 * max_count_models_, MIN_COUNT_MODELS));
+				++count_growths_;
 			}
-#endif // _DEBUG
 
 			size_t free_model_id = models_index_.size();
 			if (free_model_id_.empty()) {
@@ -222,7 +486,9 @@ namespace gre {
 			}
 
 			models_.push_back({ free_model_id, matrix });
+			models_bounds_.emplace_back();
 			update_matrix(models_.size() - 1);
+			update_version();
 			return free_model_id;
 		}
 
@@ -234,7 +500,9 @@ namespace gre {
 #endif // _DEBUG
 
 			models_[models_index_[id]].second = matrix * models_[models_index_[id]].second;
+			models_bounds_[models_index_[id]].valid = false;
 			update_matrix(models_index_[id]);
+			update_version();
 		}
 
 		void change_right(size_t id, const Matrix4x4& matrix) {
@@ -245,7 +513,9 @@ namespace gre {
 #endif // _DEBUG
 
 			models_[models_index_[id]].second *= matrix;
+			models_bounds_[models_index_[id]].valid = false;
 			update_matrix(models_index_[id]);
+			update_version();
 		}
 
 		~ModelStorage() {
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <chrono>
+#include "GraphObject.h"
+
+
+namespace gre {
+	// Per frame list of draws, opaque meshes are sorted to minimize state changes
+	class RenderQueue {
+	public:
+		struct Statistics {
+			size_t draw_calls = 0;
+			size_t material_changes = 0;
+			size_t geometry_changes = 0;
+			size_t object_changes = 0;
+			size_t depth_draw_calls = 0;  // Drawn by the depth pre-pass
+			size_t instance_buffer_growths = 0;  // Since the end of the previous frame
+			double sort_time = 0.0;  // In milliseconds
+
+			size_t get_state_changes() const noexcept {
+				return material_changes + geometry_changes + object_changes;
+			}
+		};
+
+	private:
+		inline static const UniformHandle OBJECT_ID_UNIFORM = UniformHandle("object_id");
+
+		struct OpaqueItem {
+			uint64_t key;
+			double distance;
+			size_t object_id;
+			size_t mesh_id;
+			const GraphObject* object;
+			const Mesh* mesh;
+			bool depth_pre_pass;
+
+			bool operator<(const OpaqueItem& other) const noexcept {
+				return key != other.key ? key < other.key : object_id < other.object_id;
+			}
+		};
+
+		struct TransparentItem {
+			double distance;
+			size_t object_id;
+			size_t model_id;
+			const GraphObject* object;
+
+			bool operator<(const TransparentItem& other) const noexcept {
+				return distance < other.distance;
+			}
+		};
+
+		std::vector<OpaqueItem> opaque_items_;
+		std::vector<TransparentItem> transparent_items_;
+
+		// Depth of the items drawn by the pre-pass is already written, the shaded pass only tests it
+		bool depth_pre_pass_drawn_ = false;
+
+		Statistics frame_statistics_;
+		Statistics last_frame_statistics_;
+		size_t count_growths_ = ModelStorage::get_count_growths();
+
+		// Textures change the most state, then material uniforms and vertex array, objects with equal state go roughly from front to back
+		static uint64_t get_key(double distance, const Mesh& mesh) noexcept {
+			const Material& material = mesh.material;
+			uint64_t key = static_cast<uint64_t>(material.diffuse_map.get_id() & 0xFFFF) << 48;
+			key |= static_cast<uint64_t>(material.specular_map.get_id() & 0xFF) << 40;
+			key |= static_cast<uint64_t>(material.emission_map.get_id() & 0xFF) << 32;
+			key |= static_cast<uint64_t>(std::hash<Material>()(material) & 0xFFFF) << 16;
+			key |= static_cast<uint64_t>(mesh.get_vertex_format().get_id() & 0xFF) << 8;
+			key |= static_cast<uint64_t>(std::min(16.0 * std::log2(1.0 + distance), 255.0));
+			return key;
+		}
+
+		// State is compared exactly, key collisions only affect order of the items
+		void draw_opaque_items(const Shader& shader) {
+			if (opaque_items_.empty()) {
+				return;
+			}
+
+			const GraphObject* current_object = nullptr;
+			const Material* current_material = nullptr;
+			const VertexFormat* current_vertex_format = nullptr;
+			bool depth_mask = true;
+			for (const OpaqueItem& item : opaque_items_) {
+				if (depth_pre_pass_drawn_ && depth_mask == item.depth_pre_pass) {
+					depth_mask = !item.depth_pre_pass;
+					glDepthMask(depth_mask ? GL_TRUE : GL_FALSE);
+				}
+
+				if (item.object != current_object) {
+					if (current_object != nullptr) {
+						current_object->reset_border_stencil();
+					}
+
+					shader.set_uniform_i(OBJECT_ID_UNIFORM, static_cast<GLint>(item.object_id));
+					item.object->set_border_stencil();
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, item.object->get_indirect_buffer());
+
+					current_object = item.object;
+					current_vertex_format = nullptr;
+					++frame_statistics_.object_changes;
+				}
+
+				if (current_vertex_format == nullptr || *current_vertex_format != item.mesh->get_vertex_format()) {
+					item.object->bind_geometry(*item.mesh);
+					current_vertex_format = &item.mesh->get_vertex_format();
+					++frame_statistics_.geometry_changes;
+				}
+
+				bool set_material = current_material == nullptr || *current_material != item.mesh->material;
+				if (set_material) {
+					current_material = &item.mesh->material;
+					++frame_statistics_.material_changes;
+				}
+
+				item.object->draw_instances(item.mesh_id, shader, set_material);
+				++frame_statistics_.draw_calls;
+			}
+
+			current_object->reset_border_stencil();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			if (!depth_mask) {
+				glDepthMask(GL_TRUE);
+			}
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void draw_transparent_items(const Shader& shader) {
+			for (const TransparentItem& item : transparent_items_) {
+				shader.set_uniform_i(OBJECT_ID_UNIFORM, static_cast<GLint>(item.object_id));
+				item.object->draw(item.model_id, shader);
+
+				frame_statistics_.draw_calls += item.object->meshes.size();
+				frame_statistics_.material_changes += item.object->meshes.size();
+				++frame_statistics_.object_changes;
+			}
+		}
+
+	public:
+		RenderQueue() noexcept {
+		}
+
+		const Statistics& get_frame_statistics() const noexcept {
+			return frame_statistics_;
+		}
+
+		const Statistics& get_last_frame_statistics() const noexcept {
+			return last_frame_statistics_;
+		}
+
+		void begin_frame() noexcept {
+			frame_statistics_ = Statistics();
+		}
+
+		void end_frame() noexcept {
+			frame_statistics_.instance_buffer_growths = ModelStorage::get_count_growths() - count_growths_;
+			count_growths_ = ModelStorage::get_count_growths();
+			last_frame_statistics_ = frame_statistics_;
+		}
+
+		// Capacity is kept between frames
+		void clear() noexcept {
+			opaque_items_.clear();
+			transparent_items_.clear();
+			depth_pre_pass_drawn_ = false;
+		}
+
+		// All visible instances of the object are drawn by one call per mesh
+		void insert(size_t object_id, const GraphObject& object, const Vec3& camera_position) {
+			if (!object.has_visible_instances()) {
+				return;
+			}
+
+			double distance = object.get_distance(camera_position);
+			for (const auto& [mesh_id, mesh] : object.meshes) {
+				opaque_items_.push_back({ get_key(distance, mesh), distance, object_id, mesh_id, &object, &mesh, mesh.material.is_opaque() });
+			}
+		}
+
+		void insert_transparent(size_t object_id, const GraphObject& object, size_t model_id, const Vec3& camera_position) {
+			transparent_items_.push_back({ (camera_position - object.get_center(model_id)).length(), object_id, model_id, &object });
+		}
+
+		// DEPTH shader expected, opaque items are drawn from front to back, meshes which may discard or blend fragments are left to the shaded pass
+		void draw_depth(const Shader& depth_shader) {
+			auto sort_start = std::chrono::steady_clock::now();
+			std::sort(opaque_items_.begin(), opaque_items_.end(), [](const OpaqueItem& left, const OpaqueItem& right) {
+				return left.distance < right.distance;
+			});
+			frame_statistics_.sort_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sort_start).count();
+
+			depth_shader.use();
+
+			const GraphObject* current_object = nullptr;
+			const VertexFormat* current_vertex_format = nullptr;
+			for (const OpaqueItem& item : opaque_items_) {
+				if (!item.depth_pre_pass) {
+					continue;
+				}
+
+				if (item.object != current_object) {
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, item.object->get_indirect_buffer());
+					current_object = item.object;
+					current_vertex_format = nullptr;
+				}
+
+				if (current_vertex_format == nullptr || *current_vertex_format != item.mesh->get_vertex_format()) {
+					item.object->bind_geometry(*item.mesh);
+					current_vertex_format = &item.mesh->get_vertex_format();
+				}
+
+				item.object->draw_instances(item.mesh_id, depth_shader, false);
+				++frame_statistics_.depth_draw_calls;
+			}
+
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
+
+			depth_pre_pass_drawn_ = true;
+		}
+
+		// Shader with the MAIN vertex stage expected, the deferred renderer draws opaque items into the geometry buffer
+		void draw_opaque(const Shader& shader) {
+			auto sort_start = std::chrono::steady_clock::now();
+			std::sort(opaque_items_.begin(), opaque_items_.end());
+			frame_statistics_.sort_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sort_start).count();
+
+			draw_opaque_items(shader);
+		}
+
+		// Transparent items are drawn from back to front
+		void draw_transparent(const Shader& shader) {
+			auto sort_start = std::chrono::steady_clock::now();
+			std::sort(transparent_items_.rbegin(), transparent_items_.rend());
+			frame_statistics_.sort_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sort_start).count();
+
+			draw_transparent_items(shader);
+		}
+
+		// MAIN shader expected, opaque items are drawn first
+		void draw(const Shader& shader) {
+			draw_opaque(shader);
+			draw_transparent(shader);
+		}
+	};
+}
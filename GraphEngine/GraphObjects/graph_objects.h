@@ -1,3 +1,4 @@
 #pragma once
 
 #include "GraphObjectStorage.h"
+#include "RenderQueue.h"
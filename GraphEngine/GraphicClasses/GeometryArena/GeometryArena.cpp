@@ -0,0 +1,250 @@
+#include "GeometryArena.hpp"
+
+
+// GeometryArena
+namespace gre {
+    // Static functions
+    // Ranges of the arena are rewritten by mesh setters, copy on write and re-encoding, so usage is dynamic
+    GLuint GeometryArena::create_buffer(size_t size) {
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+        return buffer;
+    }
+
+    GLuint GeometryArena::resize_buffer(GLuint buffer, size_t size, size_t new_size) {
+        GLuint new_buffer = create_buffer(new_size);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, std::min(size, new_size));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        glDeleteBuffers(1, &buffer);
+
+        GRE_CHECK_GL_ERRORS;
+        return new_buffer;
+    }
+
+    // Constructors
+    GeometryArena::GeometryArena(const VertexFormat& vertex_format)
+        : vertex_format_(vertex_format)
+        , vertex_allocator_(INITIAL_VERTEX_CAPACITY)
+        , index_allocator_(INITIAL_INDEX_CAPACITY)
+    {
+        GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
+
+        vertex_buffer_ = create_buffer(vertex_format_.get_vertex_size() * INITIAL_VERTEX_CAPACITY);
+        index_buffer_ = create_buffer(sizeof(GLuint) * INITIAL_INDEX_CAPACITY);
+
+        std::vector<GLubyte> empty_instance(INSTANCE_SIZE, 0);
+        empty_instance_buffer_ = create_buffer(empty_instance.size());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, empty_instance_buffer_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, empty_instance.size(), empty_instance.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        buffers_version_ = ++last_buffers_version_;
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Getters
+    GLuint GeometryArena::get_vertex_array() const {
+        GlStateCache::SharedVertexArray& shared_vertex_array = GlStateCache::current().get_shared_vertex_array(this);
+        if (shared_vertex_array.version != buffers_version_) {
+            attach_buffers(shared_vertex_array.vertex_array_id);
+            shared_vertex_array.version = buffers_version_;
+        }
+        return shared_vertex_array.vertex_array_id;
+    }
+
+    const VertexFormat& GeometryArena::get_vertex_format() const noexcept {
+        return vertex_format_;
+    }
+
+    const FreeListAllocator& GeometryArena::get_vertex_allocator() const noexcept {
+        return vertex_allocator_;
+    }
+
+    const FreeListAllocator& GeometryArena::get_index_allocator() const noexcept {
+        return index_allocator_;
+    }
+
+    // Allocation
+    size_t GeometryArena::allocate_vertices(size_t count_vertices) {
+        std::optional<size_t> first_vertex = vertex_allocator_.allocate(count_vertices);
+        if (!first_vertex) {
+            grow_vertices(std::max(2 * vertex_allocator_.get_capacity(), vertex_allocator_.get_capacity() + count_vertices));
+            first_vertex = vertex_allocator_.allocate(count_vertices);
+        }
+        return *first_vertex;
+    }
+
+    void GeometryArena::deallocate_vertices(size_t first_vertex, size_t count_vertices) {
+        vertex_allocator_.deallocate(first_vertex, count_vertices);
+    }
+
+    size_t GeometryArena::allocate_indices(size_t count_indices) {
+        std::optional<size_t> first_index = index_allocator_.allocate(count_indices);
+        if (!first_index) {
+            grow_indices(std::max(2 * index_allocator_.get_capacity(), index_allocator_.get_capacity() + count_indices));
+            first_index = index_allocator_.allocate(count_indices);
+        }
+        return *first_index;
+    }
+
+    void GeometryArena::deallocate_indices(size_t first_index, size_t count_indices) {
+        index_allocator_.deallocate(first_index, count_indices);
+    }
+
+    // Data transfer
+    void GeometryArena::set_vertices(size_t first_vertex, size_t count_vertices, const GLubyte* data) {
+        if (count_vertices == 0) {
+            return;
+        }
+
+        size_t vertex_size = vertex_format_.get_vertex_size();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertex_buffer_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_size * first_vertex, vertex_size * count_vertices, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::get_vertices(size_t first_vertex, size_t count_vertices, GLubyte* data) const {
+        if (count_vertices == 0) {
+            return;
+        }
+
+        size_t vertex_size = vertex_format_.get_vertex_size();
+        glBindBuffer(GL_COPY_READ_BUFFER, vertex_buffer_);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, vertex_size * first_vertex, vertex_size * count_vertices, data);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::set_indices(size_t first_index, size_t count_indices, const GLuint* data) {
+        if (count_indices == 0) {
+            return;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, index_buffer_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * first_index, sizeof(GLuint) * count_indices, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::get_indices(size_t first_index, size_t count_indices, GLuint* data) const {
+        if (count_indices == 0) {
+            return;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, index_buffer_);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, sizeof(GLuint) * first_index, sizeof(GLuint) * count_indices, data);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::copy_vertices(size_t source_first_vertex, size_t destination_first_vertex, size_t count_vertices) {
+        if (count_vertices == 0) {
+            return;
+        }
+
+        size_t vertex_size = vertex_format_.get_vertex_size();
+        glBindBuffer(GL_COPY_READ_BUFFER, vertex_buffer_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertex_buffer_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertex_size * source_first_vertex, vertex_size * destination_first_vertex, vertex_size * count_vertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::copy_indices(size_t source_first_index, size_t destination_first_index, size_t count_indices) {
+        if (count_indices == 0) {
+            return;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, index_buffer_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, index_buffer_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(GLuint) * source_first_index, sizeof(GLuint) * destination_first_index, sizeof(GLuint) * count_indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::bind(GLuint instance_buffer, GLsizei instance_stride, GLintptr instance_offset) const {
+        GlStateCache::current().bind_vertex_array(get_vertex_array());
+        if (instance_buffer != 0) {
+            glBindVertexBuffer(INSTANCE_BINDING, instance_buffer, instance_offset, instance_stride);
+        }
+        else {
+            glBindVertexBuffer(INSTANCE_BINDING, empty_instance_buffer_, 0, instance_stride);
+        }
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    GeometryArena::~GeometryArena() {
+        GlStateCache::current().delete_shared_vertex_array(this);
+        glDeleteBuffers(1, &vertex_buffer_);
+        glDeleteBuffers(1, &index_buffer_);
+        glDeleteBuffers(1, &empty_instance_buffer_);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Private functions
+    void GeometryArena::attach_buffers(GLuint vertex_array_id) const {
+        GlStateCache::current().bind_vertex_array(vertex_array_id);
+
+        vertex_format_.set_attribute_formats(VERTEX_BINDING);
+        glBindVertexBuffer(VERTEX_BINDING, vertex_buffer_, 0, static_cast<GLsizei>(vertex_format_.get_vertex_size()));
+
+        // Per instance model matrix columns, model id and normal matrix columns
+        GLuint instance_location = static_cast<GLuint>(VertexFormat::COUNT_ATTRIBUTES);
+        for (GLuint i = 0; i < 4; ++i) {
+            glVertexAttribFormat(instance_location + i, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4 * i);
+            glVertexAttribBinding(instance_location + i, INSTANCE_BINDING);
+            glEnableVertexAttribArray(instance_location + i);
+        }
+        glVertexAttribIFormat(instance_location + 4, 1, GL_UNSIGNED_INT, sizeof(GLfloat) * 28);
+        glVertexAttribBinding(instance_location + 4, INSTANCE_BINDING);
+        glEnableVertexAttribArray(instance_location + 4);
+        for (GLuint i = 0; i < 3; ++i) {
+            glVertexAttribFormat(instance_location + 5 + i, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * (16 + 4 * i));
+            glVertexAttribBinding(instance_location + 5 + i, INSTANCE_BINDING);
+            glEnableVertexAttribArray(instance_location + 5 + i);
+        }
+        glVertexBindingDivisor(INSTANCE_BINDING, 1);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryArena::grow_vertices(size_t capacity) {
+        size_t vertex_size = vertex_format_.get_vertex_size();
+        vertex_buffer_ = resize_buffer(vertex_buffer_, vertex_size * vertex_allocator_.get_capacity(), vertex_size * capacity);
+        vertex_allocator_.grow(capacity);
+
+        // Vertex arrays of all contexts are updated on their next use
+        buffers_version_ = ++last_buffers_version_;
+    }
+
+    void GeometryArena::grow_indices(size_t capacity) {
+        index_buffer_ = resize_buffer(index_buffer_, sizeof(GLuint) * index_allocator_.get_capacity(), sizeof(GLuint) * capacity);
+        index_allocator_.grow(capacity);
+
+        // Element buffer binding is a part of the vertex array state, so it is attached again as well
+        buffers_version_ = ++last_buffers_version_;
+    }
+}  // namespace gre
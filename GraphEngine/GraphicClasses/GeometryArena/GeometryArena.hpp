@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../GlStateCache/GlStateCache.hpp"
+#include "../VertexFormat/VertexFormat.hpp"
+
+
+// Shared storage of mesh vertices and indices with one interleaved vertex format
+namespace gre {
+    class GeometryArena {
+        inline static const size_t INITIAL_VERTEX_CAPACITY = 1 << 14;
+        inline static const size_t INITIAL_INDEX_CAPACITY = 1 << 16;
+
+        inline static const GLuint VERTEX_BINDING = 0;
+        inline static const GLuint INSTANCE_BINDING = 1;
+        inline static const size_t INSTANCE_SIZE = sizeof(GLfloat) * 28 + sizeof(GLuint);
+
+        // Unique over all arenas, so a vertex array left from a destroyed arena at the same address is set up again
+        inline static size_t last_buffers_version_ = 0;
+
+        VertexFormat vertex_format_;
+        GLuint vertex_buffer_ = 0;
+        GLuint index_buffer_ = 0;
+        GLuint empty_instance_buffer_ = 0;
+        size_t buffers_version_ = 0;
+
+        FreeListAllocator vertex_allocator_;
+        FreeListAllocator index_allocator_;
+
+        static GLuint create_buffer(size_t size);
+
+        // Copies content into a new buffer of the given size, old buffer is deleted
+        static GLuint resize_buffer(GLuint buffer, size_t size, size_t new_size);
+
+        void attach_buffers(GLuint vertex_array_id) const;
+
+        void grow_vertices(size_t capacity);
+
+        void grow_indices(size_t capacity);
+
+    public:
+        // Constructors
+        explicit GeometryArena(const VertexFormat& vertex_format);
+
+        GeometryArena(const GeometryArena& other) = delete;
+
+        GeometryArena(GeometryArena&& other) = delete;
+
+        GeometryArena& operator=(const GeometryArena& other) = delete;
+
+        GeometryArena& operator=(GeometryArena&& other) = delete;
+
+        // Getters
+        // Vertex array of the context of the current state cache, buffers are attached to it after they change
+        GLuint get_vertex_array() const;
+
+        const VertexFormat& get_vertex_format() const noexcept;
+
+        const FreeListAllocator& get_vertex_allocator() const noexcept;
+
+        const FreeListAllocator& get_index_allocator() const noexcept;
+
+        // Allocation, storage grows if there is no fitting free range
+        size_t allocate_vertices(size_t count_vertices);
+
+        void deallocate_vertices(size_t first_vertex, size_t count_vertices);
+
+        size_t allocate_indices(size_t count_indices);
+
+        void deallocate_indices(size_t first_index, size_t count_indices);
+
+        // Data transfer, vertices are interleaved in the arena format, indices are relative to the first vertex of the mesh
+        void set_vertices(size_t first_vertex, size_t count_vertices, const GLubyte* data);
+
+        void get_vertices(size_t first_vertex, size_t count_vertices, GLubyte* data) const;
+
+        void set_indices(size_t first_index, size_t count_indices, const GLuint* data);
+
+        void get_indices(size_t first_index, size_t count_indices, GLuint* data) const;
+
+        void copy_vertices(size_t source_first_vertex, size_t destination_first_vertex, size_t count_vertices);
+
+        void copy_indices(size_t source_first_index, size_t destination_first_index, size_t count_indices);
+
+        // Instance record starts with column major model matrix, then normal matrix columns padded to four floats and model id,
+        // zero buffer is replaced by one empty record
+        void bind(GLuint instance_buffer, GLsizei instance_stride, GLintptr instance_offset = 0) const;
+
+        ~GeometryArena();
+    };
+}  // namespace gre
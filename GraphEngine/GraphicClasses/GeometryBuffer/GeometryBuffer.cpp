@@ -0,0 +1,126 @@
+#include "GeometryBuffer.hpp"
+
+
+// GeometryBuffer
+namespace gre {
+    // Static functions
+    GLuint GeometryBuffer::create_frame_buffer(const GLuint* texture_ids, GLsizei count_textures, GLuint depth_stencil_texture_id) {
+        GLuint frame_buffer = 0;
+        glGenFramebuffers(1, &frame_buffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+
+        std::vector<GLenum> draw_buffers;
+        for (GLsizei i = 0; i < count_textures; ++i) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texture_ids[i], 0);
+            draw_buffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+        }
+        glDrawBuffers(count_textures, draw_buffers.data());
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth_stencil_texture_id, 0);
+
+        GRE_ENSURE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, GreRuntimeError, "frame buffer is not complete");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+        return frame_buffer;
+    }
+
+    // Constructors
+    GeometryBuffer::GeometryBuffer(GLsizei width, GLsizei height, GLuint depth_stencil_texture_id)
+        : width_(width)
+        , height_(height)
+    {
+        GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
+        GRE_ENSURE(width > 0 && height > 0, GreInvalidArgument, "invalid frame buffer size");
+
+        // Positions need full precision far from the origin
+        texture_ids_[POSITION] = create_texture(GL_RGBA32F);
+        for (size_t attachment_id = NORMAL; attachment_id < COUNT_ATTACHMENTS; ++attachment_id) {
+            texture_ids_[attachment_id] = create_texture(GL_RGBA16F);
+        }
+        lighting_texture_id_ = create_texture(GL_RGBA16F);
+
+        geometry_frame_buffer_ = create_frame_buffer(texture_ids_.data(), static_cast<GLsizei>(COUNT_ATTACHMENTS), depth_stencil_texture_id);
+        lighting_frame_buffer_ = create_frame_buffer(&lighting_texture_id_, 1, depth_stencil_texture_id);
+    }
+
+    // Getters
+    GLsizei GeometryBuffer::get_width() const noexcept {
+        return width_;
+    }
+
+    GLsizei GeometryBuffer::get_height() const noexcept {
+        return height_;
+    }
+
+    GLuint GeometryBuffer::get_texture_id(size_t attachment_id) const {
+        GRE_ENSURE(attachment_id < COUNT_ATTACHMENTS, GreOutOfRange, "invalid attachment id");
+
+        return texture_ids_[attachment_id];
+    }
+
+    GLuint GeometryBuffer::get_lighting_texture_id() const noexcept {
+        return lighting_texture_id_;
+    }
+
+    // Binding
+    void GeometryBuffer::bind_geometry_frame_buffer() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, geometry_frame_buffer_);
+
+        const GLfloat zero[] = { 0.0, 0.0, 0.0, 0.0 };
+        for (GLint i = 0; i < static_cast<GLint>(COUNT_ATTACHMENTS); ++i) {
+            glClearBufferfv(GL_COLOR, i, zero);
+        }
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryBuffer::bind_lighting_frame_buffer() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, lighting_frame_buffer_);
+
+        const GLfloat zero[] = { 0.0, 0.0, 0.0, 0.0 };
+        glClearBufferfv(GL_COLOR, 0, zero);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void GeometryBuffer::bind_textures(GLuint first_unit_id) const {
+        for (size_t attachment_id = 0; attachment_id < COUNT_ATTACHMENTS; ++attachment_id) {
+            GlStateCache::current().bind_texture(first_unit_id + static_cast<GLuint>(attachment_id), GL_TEXTURE_2D, texture_ids_[attachment_id]);
+        }
+        GlStateCache::current().bind_texture(first_unit_id + static_cast<GLuint>(COUNT_ATTACHMENTS), GL_TEXTURE_2D, lighting_texture_id_);
+    }
+
+    void GeometryBuffer::unbind_textures(GLuint first_unit_id) const {
+        for (size_t unit_offset = 0; unit_offset <= COUNT_ATTACHMENTS; ++unit_offset) {
+            GlStateCache::current().bind_texture(first_unit_id + static_cast<GLuint>(unit_offset), GL_TEXTURE_2D, 0);
+        }
+    }
+
+    GeometryBuffer::~GeometryBuffer() {
+        glDeleteFramebuffers(1, &geometry_frame_buffer_);
+        glDeleteFramebuffers(1, &lighting_frame_buffer_);
+        for (GLuint texture_id : texture_ids_) {
+            glDeleteTextures(1, &texture_id);
+            GlStateCache::current().on_texture_deleted(texture_id);
+        }
+        glDeleteTextures(1, &lighting_texture_id_);
+        GlStateCache::current().on_texture_deleted(lighting_texture_id_);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Private functions
+    GLuint GeometryBuffer::create_texture(GLint internal_format) const {
+        GLuint texture_id = 0;
+        glGenTextures(1, &texture_id);
+        GlStateCache::current().bind_texture(0, GL_TEXTURE_2D, texture_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width_, height_, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GlStateCache::current().bind_texture(0, GL_TEXTURE_2D, 0);
+
+        GRE_CHECK_GL_ERRORS;
+        return texture_id;
+    }
+}  // namespace gre
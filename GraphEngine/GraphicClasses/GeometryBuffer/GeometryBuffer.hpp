@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include "../GlStateCache/GlStateCache.hpp"
+
+
+// Render targets of the deferred renderer, depth and stencil are shared with the primary frame buffer
+namespace gre {
+    class GeometryBuffer {
+    public:
+        // Attachment ids match Geometry.frag outputs
+        inline static const size_t POSITION = 0;  // World position and shininess
+        inline static const size_t NORMAL = 1;    // Normal and material shadow flag
+        inline static const size_t AMBIENT = 2;
+        inline static const size_t DIFFUSE = 3;   // Diffuse color and alpha
+        inline static const size_t SPECULAR = 4;
+        inline static const size_t EMISSION = 5;  // Emission and coverage, zero where nothing was drawn
+        inline static const size_t COUNT_ATTACHMENTS = 6;
+
+    private:
+        GLsizei width_;
+        GLsizei height_;
+
+        std::array<GLuint, COUNT_ATTACHMENTS> texture_ids_ = {};
+        GLuint lighting_texture_id_ = 0;
+        GLuint geometry_frame_buffer_ = 0;
+        GLuint lighting_frame_buffer_ = 0;
+
+        GLuint create_texture(GLint internal_format) const;
+
+        static GLuint create_frame_buffer(const GLuint* texture_ids, GLsizei count_textures, GLuint depth_stencil_texture_id);
+
+    public:
+        // Constructors
+        GeometryBuffer(GLsizei width, GLsizei height, GLuint depth_stencil_texture_id);
+
+        GeometryBuffer(const GeometryBuffer& other) = delete;
+
+        GeometryBuffer(GeometryBuffer&& other) = delete;
+
+        GeometryBuffer& operator=(const GeometryBuffer& other) = delete;
+
+        GeometryBuffer& operator=(GeometryBuffer&& other) = delete;
+
+        // Getters
+        GLsizei get_width() const noexcept;
+
+        GLsizei get_height() const noexcept;
+
+        GLuint get_texture_id(size_t attachment_id) const;
+
+        GLuint get_lighting_texture_id() const noexcept;
+
+        // Frame buffers are bound with cleared color attachments, depth and stencil are kept
+        void bind_geometry_frame_buffer() const;
+
+        void bind_lighting_frame_buffer() const;
+
+        // Attachments occupy consecutive units starting from the first one, lighting texture follows them
+        void bind_textures(GLuint first_unit_id) const;
+
+        void unbind_textures(GLuint first_unit_id) const;
+
+        ~GeometryBuffer();
+    };
+}  // namespace gre
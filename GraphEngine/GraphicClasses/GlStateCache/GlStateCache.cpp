@@ -0,0 +1,220 @@
+#include "GlStateCache.hpp"
+
+
+// GlStateCache
+namespace gre {
+    size_t GlStateCache::CallCounter::get_eliminated() const noexcept {
+        return requested - issued;
+    }
+
+    size_t GlStateCache::Statistics::get_requested() const noexcept {
+        return programs.requested + vertex_arrays.requested + active_textures.requested + textures.requested + stencil.requested;
+    }
+
+    size_t GlStateCache::Statistics::get_issued() const noexcept {
+        return programs.issued + vertex_arrays.issued + active_textures.issued + textures.issued + stencil.issued;
+    }
+
+    size_t GlStateCache::Statistics::get_eliminated() const noexcept {
+        return get_requested() - get_issued();
+    }
+
+    // Static functions
+    GlStateCache& GlStateCache::current() {
+        if (current_ == nullptr) {
+            static GlStateCache fallback_cache;
+            fallback_cache.make_current();
+        }
+        return *current_;
+    }
+
+    void GlStateCache::make_current() {
+        if (current_ == this) {
+            return;
+        }
+
+        current_ = this;
+        invalidate();
+    }
+
+    void GlStateCache::invalidate() noexcept {
+        program_.reset();
+        vertex_array_.reset();
+        active_texture_.reset();
+        texture_bindings_.clear();
+        stencil_func_.reset();
+        stencil_mask_.reset();
+    }
+
+    void GlStateCache::begin_frame() noexcept {
+        frame_statistics_ = Statistics();
+
+        // State might be changed outside of the engine between frames
+        invalidate();
+    }
+
+    void GlStateCache::end_frame() noexcept {
+        last_frame_statistics_ = frame_statistics_;
+    }
+
+    // Getters
+    const GlStateCache::Statistics& GlStateCache::get_frame_statistics() const noexcept {
+        return frame_statistics_;
+    }
+
+    const GlStateCache::Statistics& GlStateCache::get_last_frame_statistics() const noexcept {
+        return last_frame_statistics_;
+    }
+
+    // Bindings
+    void GlStateCache::use_program(GLuint program_id) {
+        ++frame_statistics_.programs.requested;
+        if (program_ == program_id) {
+            return;
+        }
+
+        ++frame_statistics_.programs.issued;
+        glUseProgram(program_id);
+        GRE_CHECK_GL_ERRORS;
+
+        program_ = program_id;
+    }
+
+    void GlStateCache::bind_vertex_array(GLuint vertex_array_id) {
+        ++frame_statistics_.vertex_arrays.requested;
+        if (vertex_array_ == vertex_array_id) {
+            return;
+        }
+
+        ++frame_statistics_.vertex_arrays.issued;
+        glBindVertexArray(vertex_array_id);
+        GRE_CHECK_GL_ERRORS;
+
+        vertex_array_ = vertex_array_id;
+    }
+
+    void GlStateCache::bind_texture(GLuint unit_id, GLenum target, GLuint texture_id) {
+        ++frame_statistics_.textures.requested;
+        if (unit_id < texture_bindings_.size()) {
+            auto iterator = texture_bindings_[unit_id].find(target);
+            if (iterator != texture_bindings_[unit_id].end() && iterator->second == texture_id) {
+                return;
+            }
+        }
+
+        set_active_texture(unit_id);
+
+        ++frame_statistics_.textures.issued;
+        glBindTexture(target, texture_id);
+        GRE_CHECK_GL_ERRORS;
+
+        if (unit_id >= texture_bindings_.size()) {
+            texture_bindings_.resize(unit_id + 1);
+        }
+        texture_bindings_[unit_id][target] = texture_id;
+    }
+
+    void GlStateCache::set_stencil_func(GLenum func, GLint ref, GLuint mask) {
+        ++frame_statistics_.stencil.requested;
+        if (stencil_func_ == std::make_tuple(func, ref, mask)) {
+            return;
+        }
+
+        ++frame_statistics_.stencil.issued;
+        glStencilFunc(func, ref, mask);
+        GRE_CHECK_GL_ERRORS;
+
+        stencil_func_ = std::make_tuple(func, ref, mask);
+    }
+
+    void GlStateCache::set_stencil_mask(GLuint mask) {
+        ++frame_statistics_.stencil.requested;
+        if (stencil_mask_ == mask) {
+            return;
+        }
+
+        ++frame_statistics_.stencil.issued;
+        glStencilMask(mask);
+        GRE_CHECK_GL_ERRORS;
+
+        stencil_mask_ = mask;
+    }
+
+    // Shared vertex arrays
+    GlStateCache::SharedVertexArray& GlStateCache::get_shared_vertex_array(const void* owner) {
+        SharedVertexArray& shared_vertex_array = shared_vertex_arrays_[owner];
+        if (shared_vertex_array.vertex_array_id == 0) {
+            glGenVertexArrays(1, &shared_vertex_array.vertex_array_id);
+            GRE_CHECK_GL_ERRORS;
+        }
+        return shared_vertex_array;
+    }
+
+    void GlStateCache::delete_shared_vertex_array(const void* owner) {
+        auto iterator = shared_vertex_arrays_.find(owner);
+        if (iterator == shared_vertex_arrays_.end()) {
+            return;
+        }
+
+        glDeleteVertexArrays(1, &iterator->second.vertex_array_id);
+        GRE_CHECK_GL_ERRORS;
+
+        on_vertex_array_deleted(iterator->second.vertex_array_id);
+        shared_vertex_arrays_.erase(iterator);
+    }
+
+    void GlStateCache::delete_shared_vertex_arrays() {
+        for (const auto& [owner, shared_vertex_array] : shared_vertex_arrays_) {
+            glDeleteVertexArrays(1, &shared_vertex_array.vertex_array_id);
+            on_vertex_array_deleted(shared_vertex_array.vertex_array_id);
+        }
+        shared_vertex_arrays_.clear();
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Deletion notifications
+    void GlStateCache::on_program_deleted(GLuint program_id) noexcept {
+        if (program_ == program_id) {
+            program_.reset();
+        }
+    }
+
+    void GlStateCache::on_vertex_array_deleted(GLuint vertex_array_id) noexcept {
+        // Driver binds zero vertex array instead of the deleted one
+        if (vertex_array_ == vertex_array_id) {
+            vertex_array_ = 0;
+        }
+    }
+
+    void GlStateCache::on_texture_deleted(GLuint texture_id) noexcept {
+        // Driver binds zero texture instead of the deleted one
+        for (auto& unit_bindings : texture_bindings_) {
+            for (auto& [target, bound_texture_id] : unit_bindings) {
+                if (bound_texture_id == texture_id) {
+                    bound_texture_id = 0;
+                }
+            }
+        }
+    }
+
+    GlStateCache::~GlStateCache() {
+        if (current_ == this) {
+            current_ = nullptr;
+        }
+    }
+
+    // Private functions
+    void GlStateCache::set_active_texture(GLuint unit_id) {
+        ++frame_statistics_.active_textures.requested;
+        if (active_texture_ == unit_id) {
+            return;
+        }
+
+        ++frame_statistics_.active_textures.issued;
+        glActiveTexture(GL_TEXTURE0 + unit_id);
+        GRE_CHECK_GL_ERRORS;
+
+        active_texture_ = unit_id;
+    }
+}  // namespace gre
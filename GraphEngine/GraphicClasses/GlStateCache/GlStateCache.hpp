@@ -0,0 +1,116 @@
+#pragma once
+
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include "../../Common/common.hpp"
+
+
+// Shadow copy of openGL binding state, drops redundant driver calls
+namespace gre {
+    class GlStateCache {
+    public:
+        struct CallCounter {
+            size_t requested = 0;
+            size_t issued = 0;
+
+            size_t get_eliminated() const noexcept;
+        };
+
+        struct Statistics {
+            CallCounter programs;
+            CallCounter vertex_arrays;
+            CallCounter active_textures;
+            CallCounter textures;
+            CallCounter stencil;
+
+            size_t get_requested() const noexcept;
+
+            size_t get_issued() const noexcept;
+
+            size_t get_eliminated() const noexcept;
+        };
+
+        // Vertex array of this context for buffers shared between contexts, version tells which buffers are attached to it
+        struct SharedVertexArray {
+            GLuint vertex_array_id = 0;
+            size_t version = 0;
+        };
+
+    private:
+        inline static GlStateCache* current_ = nullptr;
+
+        std::optional<GLuint> program_;
+        std::optional<GLuint> vertex_array_;
+        std::optional<GLuint> active_texture_;
+        std::vector<std::unordered_map<GLenum, GLuint>> texture_bindings_;
+        std::optional<std::tuple<GLenum, GLint, GLuint>> stencil_func_;
+        std::optional<GLuint> stencil_mask_;
+        std::unordered_map<const void*, SharedVertexArray> shared_vertex_arrays_;
+
+        Statistics frame_statistics_;
+        Statistics last_frame_statistics_;
+
+        void set_active_texture(GLuint unit_id);
+
+    public:
+        // Constructors
+        GlStateCache() = default;
+
+        GlStateCache(const GlStateCache& other) = delete;
+
+        GlStateCache(GlStateCache&& other) = delete;
+
+        GlStateCache& operator=(const GlStateCache& other) = delete;
+
+        GlStateCache& operator=(GlStateCache&& other) = delete;
+
+        // Cache of the active context, fallback cache used if no one was activated
+        static GlStateCache& current();
+
+        // Should be called after context switch
+        void make_current();
+
+        // Forget all tracked state, required after openGL calls bypassing the cache
+        void invalidate() noexcept;
+
+        // Resets frame statistics and invalidates state
+        void begin_frame() noexcept;
+
+        // Saves frame statistics into the last frame statistics
+        void end_frame() noexcept;
+
+        // Getters
+        const Statistics& get_frame_statistics() const noexcept;
+
+        const Statistics& get_last_frame_statistics() const noexcept;
+
+        // Bindings
+        void use_program(GLuint program_id);
+
+        void bind_vertex_array(GLuint vertex_array_id);
+
+        void bind_texture(GLuint unit_id, GLenum target, GLuint texture_id);
+
+        void set_stencil_func(GLenum func, GLint ref, GLuint mask);
+
+        void set_stencil_mask(GLuint mask);
+
+        // Vertex arrays are not shared between contexts, so each cache creates its own one for the owner with zero version
+        SharedVertexArray& get_shared_vertex_array(const void* owner);
+
+        void delete_shared_vertex_array(const void* owner);
+
+        // Should be called while the context of the cache is active
+        void delete_shared_vertex_arrays();
+
+        // Deletion notifications, deleted object might be reused by the driver
+        void on_program_deleted(GLuint program_id) noexcept;
+
+        void on_vertex_array_deleted(GLuint vertex_array_id) noexcept;
+
+        void on_texture_deleted(GLuint texture_id) noexcept;
+
+        ~GlStateCache();
+    };
+}  // namespace gre
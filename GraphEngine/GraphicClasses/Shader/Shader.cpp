@@ -1,8 +1,50 @@
 #include "Shader.hpp"
 
 
+namespace {
+    constexpr GLint UNRESOLVED_UNIFORM_LOCATION = -2;
+
+    // Global storage of uniform names used by handles
+    struct UniformNamesRegistry {
+        std::deque<std::string> names;
+        std::unordered_map<std::string, size_t> ids;
+    };
+
+    UniformNamesRegistry& get_uniform_names_registry() {
+        static UniformNamesRegistry registry;
+        return registry;
+    }
+}  // anonymous namespace
+
+
+// UniformHandle
+namespace gre {
+    UniformHandle::UniformHandle(const std::string& uniform_name) {
+        UniformNamesRegistry& registry = get_uniform_names_registry();
+
+        auto [iterator, inserted] = registry.ids.insert({ uniform_name, registry.names.size() });
+        if (inserted) {
+            registry.names.push_back(uniform_name);
+        }
+        id_ = iterator->second;
+    }
+
+    size_t UniformHandle::get_id() const noexcept {
+        return id_;
+    }
+
+    const std::string& UniformHandle::get_name() const noexcept {
+        return get_uniform_names_registry().names[id_];
+    }
+}  // namespace gre
+
+
 // Shader
 namespace gre {
+    size_t Shader::UniformNameHash::operator()(std::string_view uniform_name) const noexcept {
+        return std::hash<std::string_view>()(uniform_name);
+    }
+
     std::string Shader::load_shader(const std::string& shader_path) {
         std::ifstream shader_file(shader_path);
         GRE_ENSURE(!shader_file.fail(), GreRuntimeError, "the shader file does not exist");
@@ -28,6 +70,20 @@ namespace gre {
         return vertex_shader;
     }
 
+    GLuint Shader::create_geometry_shader(const std::string& code) {
+        const char* geometry_shader_code_c = code.c_str();
+        GLuint geometry_shader = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(geometry_shader, 1, &geometry_shader_code_c, NULL);
+        glCompileShader(geometry_shader);
+
+        GLint success;
+        glGetShaderiv(geometry_shader, GL_COMPILE_STATUS, &success);
+        GRE_ENSURE(success == GL_TRUE, GreRuntimeError, "compilation failed, description --/\n" << load_shader_info_log(geometry_shader));
+
+        GRE_CHECK_GL_ERRORS;
+        return geometry_shader;
+    }
+
     GLuint Shader::create_fragment_shader(const std::string& code) {
         const char* fragment_shader_code_c = code.c_str();
         GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -42,6 +98,20 @@ namespace gre {
         return fragment_shader;
     }
 
+    GLuint Shader::create_compute_shader(const std::string& code) {
+        const char* compute_shader_code_c = code.c_str();
+        GLuint compute_shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute_shader, 1, &compute_shader_code_c, NULL);
+        glCompileShader(compute_shader);
+
+        GLint success;
+        glGetShaderiv(compute_shader, GL_COMPILE_STATUS, &success);
+        GRE_ENSURE(success == GL_TRUE, GreRuntimeError, "compilation failed, description --/\n" << load_shader_info_log(compute_shader));
+
+        GRE_CHECK_GL_ERRORS;
+        return compute_shader;
+    }
+
     GLuint Shader::link_shaders(const std::string& vertex_shader_code, const std::string& fragment_shader_code) {
         GLuint vertex_shader = create_vertex_shader(vertex_shader_code);
         GLuint fragment_shader = create_fragment_shader(fragment_shader_code);
@@ -61,6 +131,61 @@ namespace gre {
         return program;
     }
 
+    GLuint Shader::link_shaders(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code) {
+        GLuint vertex_shader = create_vertex_shader(vertex_shader_code);
+        GLuint geometry_shader = create_geometry_shader(geometry_shader_code);
+        GLuint fragment_shader = create_fragment_shader(fragment_shader_code);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, geometry_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        GRE_ENSURE(success == GL_TRUE, GreRuntimeError, "linking failed, description --/\n" << load_program_info_log(program));
+
+        glDeleteShader(vertex_shader);
+        glDeleteShader(geometry_shader);
+        glDeleteShader(fragment_shader);
+        GRE_CHECK_GL_ERRORS;
+        return program;
+    }
+
+    GLuint Shader::link_compute_shader(const std::string& compute_shader_code) {
+        GLuint compute_shader = create_compute_shader(compute_shader_code);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, compute_shader);
+        glLinkProgram(program);
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        GRE_ENSURE(success == GL_TRUE, GreRuntimeError, "linking failed, description --/\n" << load_program_info_log(program));
+
+        glDeleteShader(compute_shader);
+        GRE_CHECK_GL_ERRORS;
+        return program;
+    }
+
+    void Shader::link_program() {
+        if (compute_shader_code_ != nullptr) {
+            program_id_ = link_compute_shader(*compute_shader_code_);
+            glGetProgramiv(program_id_, GL_COMPUTE_WORK_GROUP_SIZE, work_group_size_.data());
+        }
+        else if (geometry_shader_code_ != nullptr) {
+            program_id_ = link_shaders(*vertex_shader_code_, *geometry_shader_code_, *fragment_shader_code_);
+        }
+        else if (vertex_shader_code_ != nullptr) {
+            program_id_ = link_shaders(*vertex_shader_code_, *fragment_shader_code_);
+        }
+        else {
+            return;
+        }
+        load_uniform_locations();
+    }
+
     std::string Shader::find_value(const std::string& code, const std::string& variable_name) {
         std::vector<std::string> split_code = split(code, [](const char c) { return c == ' ' || c == '\n'; });
         GRE_ENSURE(split_code.size() >= 3, GreInvalidArgument, "variable not found");
@@ -114,6 +239,46 @@ namespace gre {
         return result;
     }
 
+    void Shader::load_uniform_locations() {
+        uniform_locations_.clear();
+        handle_locations_.clear();
+
+        GLint count_uniforms = 0;
+        GLint max_name_length = 0;
+        glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count_uniforms);
+        glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+        std::vector<GLchar> name_buffer(std::max(max_name_length, 1));
+        for (GLint i = 0; i < count_uniforms; ++i) {
+            GLint size = 0;
+            GLenum type = 0;
+            GLsizei length = 0;
+            glGetActiveUniform(program_id_, static_cast<GLuint>(i), static_cast<GLsizei>(name_buffer.size()), &length, &size, &type, name_buffer.data());
+
+            std::string name(name_buffer.data(), length);
+            GLint location = glGetUniformLocation(program_id_, name.c_str());
+            if (location < 0) {
+                // Member of uniform block
+                continue;
+            }
+            uniform_locations_[name] = location;
+
+            // Arrays are reported by the first element, register each element and the base name
+            if (name.size() < 3 || name.compare(name.size() - 3, 3, "[0]") != 0) {
+                continue;
+            }
+
+            std::string base_name = name.substr(0, name.size() - 3);
+            uniform_locations_[base_name] = location;
+            for (GLint j = 1; j < size; ++j) {
+                std::string element_name = base_name + "[" + std::to_string(j) + "]";
+                uniform_locations_[element_name] = glGetUniformLocation(program_id_, element_name.c_str());
+            }
+        }
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
     Shader::Shader() {
         GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
     }
@@ -124,15 +289,23 @@ namespace gre {
         set_shader_code(vertex_shader_code, fragment_shader_code);
     }
 
+    Shader::Shader(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code) {
+        GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
+
+        set_shader_code(vertex_shader_code, geometry_shader_code, fragment_shader_code);
+    }
+
     Shader::Shader(const Shader& other) noexcept {
         vertex_shader_code_ = other.vertex_shader_code_;
+        geometry_shader_code_ = other.geometry_shader_code_;
         fragment_shader_code_ = other.fragment_shader_code_;
+        compute_shader_code_ = other.compute_shader_code_;
         count_links_ = other.count_links_;
         if (count_links_ != nullptr) {
             ++(*count_links_);
         }
 
-        program_id_ = link_shaders(*vertex_shader_code_, *fragment_shader_code_);
+        link_program();
     }
 
     Shader::Shader(Shader&& other) noexcept {
@@ -157,7 +330,25 @@ namespace gre {
         count_links_ = new size_t(1);
         vertex_shader_code_ = new std::string(vertex_shader_code);
         fragment_shader_code_ = new std::string(fragment_shader_code);
-        program_id_ = link_shaders(*vertex_shader_code_, *fragment_shader_code_);
+        link_program();
+    }
+
+    void Shader::set_shader_code(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code) {
+        clear();
+
+        count_links_ = new size_t(1);
+        vertex_shader_code_ = new std::string(vertex_shader_code);
+        geometry_shader_code_ = new std::string(geometry_shader_code);
+        fragment_shader_code_ = new std::string(fragment_shader_code);
+        link_program();
+    }
+
+    void Shader::set_compute_shader_code(const std::string& compute_shader_code) {
+        clear();
+
+        count_links_ = new size_t(1);
+        compute_shader_code_ = new std::string(compute_shader_code);
+        link_program();
     }
 
     void Shader::set_uniform_f(const GLchar* uniform_name, GLfloat v0) const {
@@ -376,7 +567,103 @@ namespace gre {
 
     void Shader::set_uniform_matrix(const GLchar* uniform_name, const Matrix4x4& matrix, GLboolean transpose) const {
         use();
-        glUniformMatrix4fv(get_uniform_location(uniform_name), 1, transpose, &std::vector<GLfloat>(matrix)[0]);
+        glUniformMatrix4fv(get_uniform_location(uniform_name), 1, transpose, Mat4f(matrix).data());
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, GLfloat v0) const {
+        use();
+        glUniform1f(get_uniform_location(uniform), v0);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1) const {
+        use();
+        glUniform2f(get_uniform_location(uniform), v0, v1);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, const Vec2& v) const {
+        use();
+        glUniform2f(get_uniform_location(uniform), static_cast<GLfloat>(v.x), static_cast<GLfloat>(v.y));
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1, GLfloat v2) const {
+        use();
+        glUniform3f(get_uniform_location(uniform), v0, v1, v2);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, const Vec3& v) const {
+        use();
+        glUniform3f(get_uniform_location(uniform), static_cast<GLfloat>(v.x), static_cast<GLfloat>(v.y), static_cast<GLfloat>(v.z));
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) const {
+        use();
+        glUniform4f(get_uniform_location(uniform), v0, v1, v2, v3);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_i(const UniformHandle& uniform, GLint v0) const {
+        use();
+        glUniform1i(get_uniform_location(uniform), v0);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1) const {
+        use();
+        glUniform2i(get_uniform_location(uniform), v0, v1);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1, GLint v2) const {
+        use();
+        glUniform3i(get_uniform_location(uniform), v0, v1, v2);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1, GLint v2, GLint v3) const {
+        use();
+        glUniform4i(get_uniform_location(uniform), v0, v1, v2, v3);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_ui(const UniformHandle& uniform, GLuint v0) const {
+        use();
+        glUniform1ui(get_uniform_location(uniform), v0);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1) const {
+        use();
+        glUniform2ui(get_uniform_location(uniform), v0, v1);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1, GLuint v2) const {
+        use();
+        glUniform3ui(get_uniform_location(uniform), v0, v1, v2);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1, GLuint v2, GLuint v3) const {
+        use();
+        glUniform4ui(get_uniform_location(uniform), v0, v1, v2, v3);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_4fv(const UniformHandle& uniform, GLsizei count, const GLfloat* value) const {
+        use();
+        glUniform4fv(get_uniform_location(uniform), count, value);
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void Shader::set_uniform_matrix(const UniformHandle& uniform, const Matrix4x4& matrix, GLboolean transpose) const {
+        use();
+        glUniformMatrix4fv(get_uniform_location(uniform), 1, transpose, Mat4f(matrix).data());
         GRE_CHECK_GL_ERRORS;
     }
 
@@ -384,31 +671,68 @@ namespace gre {
         return find_value(*vertex_shader_code_, variable_name);
     }
 
+    std::string Shader::get_value_geom(const std::string& variable_name) const {
+        return find_value(*geometry_shader_code_, variable_name);
+    }
+
     std::string Shader::get_value_frag(const std::string& variable_name) const {
         return find_value(*fragment_shader_code_, variable_name);
     }
 
+    std::string Shader::get_value_comp(const std::string& variable_name) const {
+        return find_value(*compute_shader_code_, variable_name);
+    }
+
     GLint Shader::get_uniform_location(const GLchar* uniform_name) const {
-        GLint uniform_location = glGetUniformLocation(program_id_, uniform_name);
-        GRE_CHECK_GL_ERRORS;
-        return uniform_location;
+        auto iterator = uniform_locations_.find(std::string_view(uniform_name));
+        if (iterator == uniform_locations_.end()) {
+            // Same as driver result for inactive uniform
+            return -1;
+        }
+        return iterator->second;
+    }
+
+    GLint Shader::get_uniform_location(const UniformHandle& uniform) const {
+        size_t id = uniform.get_id();
+        if (id >= handle_locations_.size()) {
+            handle_locations_.resize(id + 1, UNRESOLVED_UNIFORM_LOCATION);
+        }
+
+        if (handle_locations_[id] == UNRESOLVED_UNIFORM_LOCATION) {
+            handle_locations_[id] = get_uniform_location(uniform.get_name().c_str());
+        }
+        return handle_locations_[id];
     }
 
     GLuint Shader::get_program_id() const noexcept {
         return program_id_;
     }
 
+    const std::array<GLint, 3>& Shader::get_work_group_size() const noexcept {
+        return work_group_size_;
+    }
+
+    bool Shader::is_compute() const noexcept {
+        return compute_shader_code_ != nullptr;
+    }
+
     bool Shader::check_window_settings(const sf::ContextSettings& settings) const {
-        uint64_t vert_version = find_version(*vertex_shader_code_);
-        uint64_t frag_version = find_version(*fragment_shader_code_);
-        if (vert_version / 100 > settings.majorVersion || (vert_version / 100 == settings.majorVersion && (vert_version % 100) / 10 > settings.minorVersion)) {
+        uint64_t version = find_version(is_compute() ? *compute_shader_code_ : *vertex_shader_code_);
+        if (version / 100 > settings.majorVersion || (version / 100 == settings.majorVersion && (version % 100) / 10 > settings.minorVersion)) {
             return false;
         }
-        return vert_version / 100 < settings.majorVersion || (vert_version / 100 == settings.majorVersion && (vert_version % 100) / 10 <= settings.minorVersion);
+        return version / 100 < settings.majorVersion || (version / 100 == settings.majorVersion && (version % 100) / 10 <= settings.minorVersion);
     }
 
     void Shader::use() const {
-        glUseProgram(program_id_);
+        GlStateCache::current().use_program(program_id_);
+    }
+
+    void Shader::dispatch(GLuint count_groups_x, GLuint count_groups_y, GLuint count_groups_z) const {
+        GRE_CHECK(is_compute(), "shader is not compute");
+
+        use();
+        glDispatchCompute(count_groups_x, count_groups_y, count_groups_z);
         GRE_CHECK_GL_ERRORS;
     }
 
@@ -446,11 +770,27 @@ namespace gre {
         set_shader_code(vertex_shader_code, fragment_shader_code);
     }
 
+    void Shader::load_from_file(const std::string& vertex_shader_path, const std::string& geometry_shader_path, const std::string& fragment_shader_path) {
+        const std::string& vertex_shader_code = load_shader(vertex_shader_path);
+        const std::string& geometry_shader_code = load_shader(geometry_shader_path);
+        const std::string& fragment_shader_code = load_shader(fragment_shader_path);
+        set_shader_code(vertex_shader_code, geometry_shader_code, fragment_shader_code);
+    }
+
+    void Shader::load_compute_from_file(const std::string& compute_shader_path) {
+        set_compute_shader_code(load_shader(compute_shader_path));
+    }
+
     void Shader::swap(Shader& other) noexcept {
         std::swap(count_links_, other.count_links_);
         std::swap(program_id_, other.program_id_);
+        std::swap(work_group_size_, other.work_group_size_);
         std::swap(vertex_shader_code_, other.vertex_shader_code_);
+        std::swap(geometry_shader_code_, other.geometry_shader_code_);
         std::swap(fragment_shader_code_, other.fragment_shader_code_);
+        std::swap(compute_shader_code_, other.compute_shader_code_);
+        uniform_locations_.swap(other.uniform_locations_);
+        handle_locations_.swap(other.handle_locations_);
     }
 
     void Shader::clear() {
@@ -459,17 +799,28 @@ namespace gre {
             if (*count_links_ == 0) {
                 delete count_links_;
                 delete vertex_shader_code_;
+                delete geometry_shader_code_;
                 delete fragment_shader_code_;
+                delete compute_shader_code_;
             }
         }
         count_links_ = nullptr;
         vertex_shader_code_ = nullptr;
+        geometry_shader_code_ = nullptr;
         fragment_shader_code_ = nullptr;
+        compute_shader_code_ = nullptr;
 
-        glDeleteProgram(program_id_);
-        GRE_CHECK_GL_ERRORS;
+        if (program_id_ != 0) {
+            glDeleteProgram(program_id_);
+            GRE_CHECK_GL_ERRORS;
+
+            GlStateCache::current().on_program_deleted(program_id_);
+        }
 
         program_id_ = 0;
+        work_group_size_ = { 0, 0, 0 };
+        uniform_locations_.clear();
+        handle_locations_.clear();
     }
 
     Shader::~Shader() {
@@ -1,24 +1,66 @@
 #pragma once
 
-#include "../../Common/common.hpp"
+#include <array>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include "../GlStateCache/GlStateCache.hpp"
+
+
+// Typed uniform handle, name is resolved into location once per shader program
+namespace gre {
+    class UniformHandle {
+        size_t id_;
+
+    public:
+        explicit UniformHandle(const std::string& uniform_name);
+
+        size_t get_id() const noexcept;
+
+        const std::string& get_name() const noexcept;
+    };
+}  // namespace gre
 
 
 // Proxy class for openGL shaders
 namespace gre {
     class Shader {
+        struct UniformNameHash {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view uniform_name) const noexcept;
+        };
+
         size_t* count_links_ = nullptr;
         std::string* vertex_shader_code_ = nullptr;
+        std::string* geometry_shader_code_ = nullptr;
         std::string* fragment_shader_code_ = nullptr;
+        std::string* compute_shader_code_ = nullptr;
         GLuint program_id_ = 0;
+        std::array<GLint, 3> work_group_size_ = { 0, 0, 0 };
+
+        // Locations of all active uniforms, reflected at link time
+        std::unordered_map<std::string, GLint, UniformNameHash, std::equal_to<>> uniform_locations_;
+        mutable std::vector<GLint> handle_locations_;
 
         static std::string load_shader(const std::string& shader_path);
 
         static GLuint create_vertex_shader(const std::string& code);
 
+        static GLuint create_geometry_shader(const std::string& code);
+
         static GLuint create_fragment_shader(const std::string& code);
 
+        static GLuint create_compute_shader(const std::string& code);
+
         static GLuint link_shaders(const std::string& vertex_shader_code, const std::string& fragment_shader_code);
 
+        static GLuint link_shaders(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code);
+
+        static GLuint link_compute_shader(const std::string& compute_shader_code);
+
+        void link_program();
+
         static std::string find_value(const std::string& code, const std::string& variable_name);
 
         static uint64_t find_version(const std::string& code);
@@ -27,11 +69,15 @@ namespace gre {
 
         static std::string load_program_info_log(GLuint program);
 
+        void load_uniform_locations();
+
     public:
         Shader();
 
         Shader(const std::string& vertex_shader_code, const std::string& fragment_shader_code);
 
+        Shader(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code);
+
         Shader(const Shader& other) noexcept;
 
         Shader(Shader&& other) noexcept;
@@ -42,6 +88,10 @@ namespace gre {
 
         void set_shader_code(const std::string& vertex_shader_code, const std::string& fragment_shader_code);
 
+        void set_shader_code(const std::string& vertex_shader_code, const std::string& geometry_shader_code, const std::string& fragment_shader_code);
+
+        void set_compute_shader_code(const std::string& compute_shader_code);
+
         void set_uniform_f(const GLchar* uniform_name, GLfloat v0) const;
 
         void set_uniform_f(const GLchar* uniform_name, GLfloat v0, GLfloat v1) const;
@@ -98,24 +148,74 @@ namespace gre {
 
         void set_uniform_matrix(const GLchar* uniform_name, const Matrix4x4& matrix, GLboolean transpose = GL_FALSE) const;
 
+        void set_uniform_f(const UniformHandle& uniform, GLfloat v0) const;
+
+        void set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1) const;
+
+        void set_uniform_f(const UniformHandle& uniform, const Vec2& v) const;
+
+        void set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1, GLfloat v2) const;
+
+        void set_uniform_f(const UniformHandle& uniform, const Vec3& v) const;
+
+        void set_uniform_f(const UniformHandle& uniform, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) const;
+
+        void set_uniform_i(const UniformHandle& uniform, GLint v0) const;
+
+        void set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1) const;
+
+        void set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1, GLint v2) const;
+
+        void set_uniform_i(const UniformHandle& uniform, GLint v0, GLint v1, GLint v2, GLint v3) const;
+
+        void set_uniform_ui(const UniformHandle& uniform, GLuint v0) const;
+
+        void set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1) const;
+
+        void set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1, GLuint v2) const;
+
+        void set_uniform_ui(const UniformHandle& uniform, GLuint v0, GLuint v1, GLuint v2, GLuint v3) const;
+
+        void set_uniform_4fv(const UniformHandle& uniform, GLsizei count, const GLfloat* value) const;
+
+        void set_uniform_matrix(const UniformHandle& uniform, const Matrix4x4& matrix, GLboolean transpose = GL_FALSE) const;
+
         std::string get_value_vert(const std::string& variable_name) const;
 
+        std::string get_value_geom(const std::string& variable_name) const;
+
         std::string get_value_frag(const std::string& variable_name) const;
 
+        std::string get_value_comp(const std::string& variable_name) const;
+
         GLint get_uniform_location(const GLchar* uniform_name) const;
 
+        GLint get_uniform_location(const UniformHandle& uniform) const;
+
         GLuint get_program_id() const noexcept;
 
+        // Local size of compute shader, declared in shader code
+        const std::array<GLint, 3>& get_work_group_size() const noexcept;
+
+        bool is_compute() const noexcept;
+
         bool check_window_settings(const sf::ContextSettings& settings) const;
 
         void use() const;
 
+        // Compute shader expected
+        void dispatch(GLuint count_groups_x, GLuint count_groups_y = 1, GLuint count_groups_z = 1) const;
+
         bool validate_program(std::string& validate_status_description) const;
 
         bool validate_program() const;
 
         void load_from_file(const std::string& vertex_shader_path, const std::string& fragment_shader_path);
 
+        void load_from_file(const std::string& vertex_shader_path, const std::string& geometry_shader_path, const std::string& fragment_shader_path);
+
+        void load_compute_from_file(const std::string& compute_shader_path);
+
         void swap(Shader& other) noexcept;
 
         void clear();
@@ -0,0 +1,182 @@
+#include "StreamBuffer.hpp"
+
+
+// StreamBuffer
+namespace gre {
+    // Constructors
+    StreamBuffer::StreamBuffer(size_t region_size) {
+        GRE_ENSURE(glew_is_ok(), GreRuntimeError, "failed to initialize GLEW");
+
+        create_storage(region_size);
+    }
+
+    // Getters
+    GLuint StreamBuffer::get_id() const noexcept {
+        return buffer_;
+    }
+
+    size_t StreamBuffer::get_region_size() const noexcept {
+        return region_size_;
+    }
+
+    size_t StreamBuffer::get_offset() const noexcept {
+        return region_size_ * region_id_;
+    }
+
+    bool StreamBuffer::is_persistent() const noexcept {
+        return mapped_data_ != nullptr;
+    }
+
+    bool StreamBuffer::is_dirty() const noexcept {
+        return dirty_ranges_[region_id_].begin < dirty_ranges_[region_id_].end;
+    }
+
+    // Data transfer
+    void StreamBuffer::invalidate(size_t offset, size_t size) {
+        GRE_ENSURE(offset + size <= region_size_, GreOutOfRange, "invalid range for invalidation");
+
+        for (size_t region_id = 0; region_id < count_regions_; ++region_id) {
+            dirty_ranges_[region_id].begin = std::min(dirty_ranges_[region_id].begin, offset);
+            dirty_ranges_[region_id].end = std::max(dirty_ranges_[region_id].end, offset + size);
+        }
+    }
+
+    void StreamBuffer::flush(const GLubyte* data, size_t size) {
+        if (!is_dirty()) {
+            return;
+        }
+
+        if (mapped_data_ == nullptr) {
+            DirtyRange& range = dirty_ranges_[0];
+            range.end = std::min(range.end, size);
+            if (range.begin < range.end) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+                glBufferSubData(GL_COPY_WRITE_BUFFER, range.begin, range.end - range.begin, data + range.begin);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            }
+            range = DirtyRange();
+
+            GRE_CHECK_GL_ERRORS;
+            return;
+        }
+
+        // Draws submitted since the previous flush read the current region
+        if (fences_[region_id_] != nullptr) {
+            glDeleteSync(fences_[region_id_]);
+        }
+        fences_[region_id_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        region_id_ = (region_id_ + 1) % count_regions_;
+        wait_fence(region_id_);
+
+        DirtyRange& range = dirty_ranges_[region_id_];
+        range.end = std::min(range.end, size);
+        if (range.begin < range.end) {
+            std::memcpy(mapped_data_ + get_offset() + range.begin, data + range.begin, range.end - range.begin);
+        }
+        range = DirtyRange();
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void StreamBuffer::resize(size_t region_size) {
+        GLuint buffer = buffer_;
+        GLubyte* mapped_data = mapped_data_;
+        size_t copy_offset = get_offset();
+        size_t copy_size = region_size_;
+        DirtyRange current_range = dirty_ranges_[region_id_];
+
+        // Old storage is deleted after the copy, so pending draws do not need fences anymore
+        release_fences();
+        create_storage(region_size);
+        copy_size = std::min(copy_size, region_size_);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy_offset, 0, copy_size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (mapped_data != nullptr) {
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+
+        region_id_ = 0;
+        dirty_ranges_[0] = current_range;
+        for (size_t region_id = 1; region_id < count_regions_; ++region_id) {
+            dirty_ranges_[region_id].begin = 0;
+            dirty_ranges_[region_id].end = std::max(copy_size, current_range.end);
+        }
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        release_fences();
+        if (mapped_data_ != nullptr) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer_);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    // Private functions
+    void StreamBuffer::create_storage(size_t region_size) {
+        // Regions are bound as storage buffer ranges, so their offsets keep the binding alignment
+        GLint alignment = 1;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        size_t region_alignment = static_cast<size_t>(std::max(alignment, 1));
+        region_size_ = std::max((region_size + region_alignment - 1) / region_alignment, static_cast<size_t>(1)) * region_alignment;
+
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        if (GLEW_ARB_buffer_storage) {
+            count_regions_ = COUNT_REGIONS;
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, region_size_ * count_regions_, NULL, flags);
+            mapped_data_ = static_cast<GLubyte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, region_size_ * count_regions_, flags));
+
+            GRE_ENSURE(mapped_data_ != nullptr, GreRuntimeError, "failed to map stream buffer");
+        }
+        else {
+            glBufferData(GL_COPY_WRITE_BUFFER, region_size_, NULL, GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void StreamBuffer::release_fences() {
+        for (GLsync& fence : fences_) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+    }
+
+    void StreamBuffer::wait_fence(size_t region_id) {
+        GLsync& fence = fences_[region_id];
+        if (fence == nullptr) {
+            return;
+        }
+
+        GLbitfield flags = 0;
+        while (true) {
+            GLenum status = glClientWaitSync(fence, flags, 1000000);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                break;
+            }
+            GRE_ENSURE(status != GL_WAIT_FAILED, GreRuntimeError, "failed to wait for stream buffer region");
+
+            // Commands before the fence may be still queued on the client side
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}  // namespace gre
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include "../GlStateCache/GlStateCache.hpp"
+
+
+// Buffer rewritten by CPU between frames, regions are used in turn so writes do not wait for draws reading the previous ones
+namespace gre {
+    class StreamBuffer {
+    public:
+        inline static const size_t COUNT_REGIONS = 3;
+
+    private:
+        // Changed bytes not yet written into a region
+        struct DirtyRange {
+            size_t begin = std::numeric_limits<size_t>::max();
+            size_t end = 0;
+        };
+
+        size_t region_size_;
+        size_t count_regions_ = 1;
+        size_t region_id_ = 0;
+
+        GLuint buffer_ = 0;
+        GLubyte* mapped_data_ = nullptr;  // Persistent mapping of all regions, null without GL_ARB_buffer_storage
+        std::array<GLsync, COUNT_REGIONS> fences_ = {};
+        std::array<DirtyRange, COUNT_REGIONS> dirty_ranges_;
+
+        void create_storage(size_t region_size);
+
+        void release_fences();
+
+        void wait_fence(size_t region_id);
+
+    public:
+        // Constructors
+        explicit StreamBuffer(size_t region_size);
+
+        StreamBuffer(const StreamBuffer& other) = delete;
+
+        StreamBuffer(StreamBuffer&& other) = delete;
+
+        StreamBuffer& operator=(const StreamBuffer& other) = delete;
+
+        StreamBuffer& operator=(StreamBuffer&& other) = delete;
+
+        // Getters
+        GLuint get_id() const noexcept;
+
+        size_t get_region_size() const noexcept;
+
+        // Offset in bytes of the region with the latest data
+        size_t get_offset() const noexcept;
+
+        bool is_persistent() const noexcept;
+
+        bool is_dirty() const noexcept;
+
+        // Data transfer, changes reach every region before its next use
+        void invalidate(size_t offset, size_t size);
+
+        // Fences the current region and writes the changed part of the data into the next one, changes beyond the size are dropped
+        void flush(const GLubyte* data, size_t size);
+
+        // Content of the current region is copied into the new storage on GPU, other regions are rewritten by the next flushes
+        void resize(size_t region_size);
+
+        ~StreamBuffer();
+    };
+}  // namespace gre
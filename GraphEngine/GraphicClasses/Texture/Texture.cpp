@@ -60,7 +60,7 @@ namespace gre {
         count_links_ = new size_t(1);
 
         glGenTextures(1, &texture_id_);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        GlStateCache::current().bind_texture(0, GL_TEXTURE_2D, texture_id_);
 
         if (gamma) {
             glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB_ALPHA, static_cast<GLsizei>(width_), static_cast<GLsizei>(height_), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getPixelsPtr());
@@ -73,17 +73,15 @@ namespace gre {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        glBindTexture(GL_TEXTURE_2D, 0);
-
         GRE_CHECK_GL_ERRORS;
     }
 
     void Texture::set_wrapping(GLint wrapping) const {
         GRE_ENSURE(wrapping == GL_REPEAT || wrapping == GL_MIRRORED_REPEAT || wrapping == GL_CLAMP_TO_EDGE || wrapping == GL_CLAMP_TO_BORDER, GreInvalidArgument, "invalid wrapping type");
 
+        GlStateCache::current().bind_texture(0, GL_TEXTURE_2D, texture_id_);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapping);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapping);
-        glBindTexture(GL_TEXTURE_2D, 0);
 
         GRE_CHECK_GL_ERRORS;
     }
@@ -107,11 +105,7 @@ namespace gre {
             return;
         }
 
-        glActiveTexture(GL_TEXTURE0 + unit_id);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
-        glActiveTexture(GL_TEXTURE0);
-
-        GRE_CHECK_GL_ERRORS;
+        GlStateCache::current().bind_texture(unit_id, GL_TEXTURE_2D, texture_id_);
     }
 
     void Texture::deactive(GLenum unit_id) const {
@@ -121,11 +115,7 @@ namespace gre {
             return;
         }
 
-        glActiveTexture(GL_TEXTURE0 + unit_id);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glActiveTexture(GL_TEXTURE0);
-
-        GRE_CHECK_GL_ERRORS;
+        GlStateCache::current().bind_texture(unit_id, GL_TEXTURE_2D, 0);
     }
 
     void Texture::load_from_file(const std::string& texture_path, bool gamma) {
@@ -157,6 +147,8 @@ namespace gre {
 
                 glDeleteTextures(1, &texture_id_);
                 GRE_CHECK_GL_ERRORS;
+
+                GlStateCache::current().on_texture_deleted(texture_id_);
             }
         }
         count_links_ = nullptr;
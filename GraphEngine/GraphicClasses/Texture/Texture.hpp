@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../../Common/common.hpp"
+#include "../GlStateCache/GlStateCache.hpp"
 
 
 // Proxy class for openGL textures
@@ -0,0 +1,268 @@
+#include "VertexFormat.hpp"
+
+
+namespace {
+    GLushort float_to_half(GLfloat value) noexcept {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t float_exponent = (bits >> 23) & 0xFF;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        if (float_exponent == 0xFF) {
+            return static_cast<GLushort>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+        }
+
+        int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+        if (exponent >= 31) {
+            return static_cast<GLushort>(sign | 0x7C00);
+        }
+
+        // Subnormal half values, mantissa gets the implicit leading bit
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return static_cast<GLushort>(sign);
+            }
+
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half_mantissa = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1) {
+                ++half_mantissa;
+            }
+            return static_cast<GLushort>(sign | half_mantissa);
+        }
+
+        // Rounding carry moves into the exponent correctly
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000) {
+            ++half;
+        }
+        return static_cast<GLushort>(half);
+    }
+
+    GLfloat half_to_float(GLushort value) noexcept {
+        uint32_t sign = (static_cast<uint32_t>(value) & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+
+        if (exponent == 0) {
+            GLfloat result = std::ldexp(static_cast<GLfloat>(mantissa), -24);
+            return sign != 0 ? -result : result;
+        }
+
+        uint32_t bits = sign | (mantissa << 13);
+        if (exponent == 31) {
+            bits |= 0x7F800000;
+        }
+        else {
+            bits |= (exponent + 127 - 15) << 23;
+        }
+
+        GLfloat result = 0.0;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // Signed normalized 10 bit components, normal is normalized before packing
+    GLuint pack_normal(const GLfloat* normal) noexcept {
+        GLfloat length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length < static_cast<GLfloat>(gre::EPS)) {
+            return 0;
+        }
+
+        GLuint result = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            GLfloat component = std::max(std::min(normal[i] / length, 1.0f), -1.0f);
+            GLint packed = static_cast<GLint>(std::round(component * 511.0f));
+            result |= (static_cast<GLuint>(packed) & 0x3FF) << (10 * i);
+        }
+        return result;
+    }
+
+    void unpack_normal(GLuint packed, GLfloat* normal) noexcept {
+        for (size_t i = 0; i < 3; ++i) {
+            GLint component = static_cast<GLint>((packed >> (10 * i)) & 0x3FF);
+            if (component & 0x200) {
+                component -= 0x400;
+            }
+            normal[i] = std::max(static_cast<GLfloat>(component) / 511.0f, -1.0f);
+        }
+    }
+}  // anonymous namespace
+
+
+// VertexFormat
+namespace gre {
+    // Constructors
+    VertexFormat::VertexFormat(NormalType normal_type, TexCoordType tex_coord_type, ColorType color_type) noexcept
+        : normal_type_(normal_type)
+        , tex_coord_type_(tex_coord_type)
+        , color_type_(color_type)
+    {
+        sizes_[POSITION] = sizeof(GLfloat) * COUNT_COMPONENTS[POSITION];
+
+        sizes_[NORMAL] = sizeof(GLfloat) * COUNT_COMPONENTS[NORMAL];
+        if (normal_type_ == NormalType::INT_2_10_10_10) {
+            sizes_[NORMAL] = sizeof(GLuint);
+        }
+
+        if (tex_coord_type_ == TexCoordType::FLOAT) {
+            sizes_[TEX_COORD] = sizeof(GLfloat) * COUNT_COMPONENTS[TEX_COORD];
+        }
+        else if (tex_coord_type_ == TexCoordType::HALF_FLOAT) {
+            sizes_[TEX_COORD] = sizeof(GLushort) * COUNT_COMPONENTS[TEX_COORD];
+        }
+
+        // Byte colors are padded to four components to keep vertex aligned
+        if (color_type_ == ColorType::FLOAT) {
+            sizes_[COLOR] = sizeof(GLfloat) * COUNT_COMPONENTS[COLOR];
+        }
+        else if (color_type_ == ColorType::UNSIGNED_BYTE) {
+            sizes_[COLOR] = 4 * sizeof(GLubyte);
+        }
+
+        for (size_t i = 0; i < COUNT_ATTRIBUTES; ++i) {
+            offsets_[i] = vertex_size_;
+            vertex_size_ += sizes_[i];
+        }
+    }
+
+    bool VertexFormat::operator==(const VertexFormat& other) const noexcept {
+        return get_id() == other.get_id();
+    }
+
+    bool VertexFormat::operator!=(const VertexFormat& other) const noexcept {
+        return !(*this == other);
+    }
+
+    // Getters
+    VertexFormat::NormalType VertexFormat::get_normal_type() const noexcept {
+        return normal_type_;
+    }
+
+    VertexFormat::TexCoordType VertexFormat::get_tex_coord_type() const noexcept {
+        return tex_coord_type_;
+    }
+
+    VertexFormat::ColorType VertexFormat::get_color_type() const noexcept {
+        return color_type_;
+    }
+
+    size_t VertexFormat::get_vertex_size() const noexcept {
+        return vertex_size_;
+    }
+
+    size_t VertexFormat::get_offset(size_t attribute_id) const {
+        GRE_ENSURE(attribute_id < COUNT_ATTRIBUTES, GreOutOfRange, "invalid attribute id");
+
+        return offsets_[attribute_id];
+    }
+
+    size_t VertexFormat::get_id() const noexcept {
+        return static_cast<size_t>(normal_type_) | (static_cast<size_t>(tex_coord_type_) << 2) | (static_cast<size_t>(color_type_) << 4);
+    }
+
+    bool VertexFormat::contains(size_t attribute_id) const noexcept {
+        return attribute_id < COUNT_ATTRIBUTES && sizes_[attribute_id] > 0;
+    }
+
+    void VertexFormat::set_attribute_formats(GLuint binding_id) const {
+        for (size_t i = 0; i < COUNT_ATTRIBUTES; ++i) {
+            GLuint location = static_cast<GLuint>(i);
+            if (!contains(i)) {
+                glDisableVertexAttribArray(location);
+                continue;
+            }
+
+            GLuint offset = static_cast<GLuint>(offsets_[i]);
+            if (i == NORMAL && normal_type_ == NormalType::INT_2_10_10_10) {
+                glVertexAttribFormat(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offset);
+            }
+            else if (i == TEX_COORD && tex_coord_type_ == TexCoordType::HALF_FLOAT) {
+                glVertexAttribFormat(location, COUNT_COMPONENTS[i], GL_HALF_FLOAT, GL_FALSE, offset);
+            }
+            else if (i == COLOR && color_type_ == ColorType::UNSIGNED_BYTE) {
+                glVertexAttribFormat(location, 4, GL_UNSIGNED_BYTE, GL_TRUE, offset);
+            }
+            else {
+                glVertexAttribFormat(location, COUNT_COMPONENTS[i], GL_FLOAT, GL_FALSE, offset);
+            }
+
+            glVertexAttribBinding(location, binding_id);
+            glEnableVertexAttribArray(location);
+        }
+
+        GRE_CHECK_GL_ERRORS;
+    }
+
+    void VertexFormat::encode(size_t attribute_id, const GLfloat* data, size_t count_vertices, GLubyte* vertices) const {
+        if (!contains(attribute_id)) {
+            return;
+        }
+
+        size_t count_components = COUNT_COMPONENTS[attribute_id];
+        GLubyte* attribute = vertices + offsets_[attribute_id];
+        for (size_t i = 0; i < count_vertices; ++i, data += count_components, attribute += vertex_size_) {
+            if (attribute_id == NORMAL && normal_type_ == NormalType::INT_2_10_10_10) {
+                GLuint packed = pack_normal(data);
+                std::memcpy(attribute, &packed, sizeof(packed));
+            }
+            else if (attribute_id == TEX_COORD && tex_coord_type_ == TexCoordType::HALF_FLOAT) {
+                for (size_t j = 0; j < count_components; ++j) {
+                    GLushort half = float_to_half(data[j]);
+                    std::memcpy(attribute + sizeof(GLushort) * j, &half, sizeof(half));
+                }
+            }
+            else if (attribute_id == COLOR && color_type_ == ColorType::UNSIGNED_BYTE) {
+                for (size_t j = 0; j < count_components; ++j) {
+                    attribute[j] = static_cast<GLubyte>(std::round(std::max(std::min(data[j], 1.0f), 0.0f) * 255.0f));
+                }
+                attribute[3] = 255;
+            }
+            else {
+                std::memcpy(attribute, data, sizeof(GLfloat) * count_components);
+            }
+        }
+    }
+
+    void VertexFormat::decode(size_t attribute_id, const GLubyte* vertices, size_t count_vertices, GLfloat* data) const {
+        if (!contains(attribute_id)) {
+            return;
+        }
+
+        size_t count_components = COUNT_COMPONENTS[attribute_id];
+        const GLubyte* attribute = vertices + offsets_[attribute_id];
+        for (size_t i = 0; i < count_vertices; ++i, data += count_components, attribute += vertex_size_) {
+            if (attribute_id == NORMAL && normal_type_ == NormalType::INT_2_10_10_10) {
+                GLuint packed = 0;
+                std::memcpy(&packed, attribute, sizeof(packed));
+                unpack_normal(packed, data);
+            }
+            else if (attribute_id == TEX_COORD && tex_coord_type_ == TexCoordType::HALF_FLOAT) {
+                for (size_t j = 0; j < count_components; ++j) {
+                    GLushort half = 0;
+                    std::memcpy(&half, attribute + sizeof(GLushort) * j, sizeof(half));
+                    data[j] = half_to_float(half);
+                }
+            }
+            else if (attribute_id == COLOR && color_type_ == ColorType::UNSIGNED_BYTE) {
+                for (size_t j = 0; j < count_components; ++j) {
+                    data[j] = static_cast<GLfloat>(attribute[j]) / 255.0f;
+                }
+            }
+            else {
+                std::memcpy(data, attribute, sizeof(GLfloat) * count_components);
+            }
+        }
+    }
+
+    // Static functions
+    VertexFormat VertexFormat::compact(bool tex_coords, bool colors) noexcept {
+        return VertexFormat(
+            NormalType::INT_2_10_10_10,
+            tex_coords ? TexCoordType::HALF_FLOAT : TexCoordType::NONE,
+            colors ? ColorType::UNSIGNED_BYTE : ColorType::NONE
+        );
+    }
+}  // namespace gre
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include "../../Common/common.hpp"
+
+
+// Interleaved vertex layout with selectable attribute encodings, positions are always stored as floats
+namespace gre {
+    class VertexFormat {
+    public:
+        enum class NormalType {
+            FLOAT,
+            INT_2_10_10_10
+        };
+
+        enum class TexCoordType {
+            NONE,
+            FLOAT,
+            HALF_FLOAT
+        };
+
+        enum class ColorType {
+            NONE,
+            FLOAT,
+            UNSIGNED_BYTE
+        };
+
+        // Attribute ids match vertex shader locations
+        inline static const size_t POSITION = 0;
+        inline static const size_t NORMAL = 1;
+        inline static const size_t TEX_COORD = 2;
+        inline static const size_t COLOR = 3;
+        inline static const size_t COUNT_ATTRIBUTES = 4;
+
+        inline static const std::array<GLint, COUNT_ATTRIBUTES> COUNT_COMPONENTS = { 3, 3, 2, 3 };
+
+    private:
+        NormalType normal_type_;
+        TexCoordType tex_coord_type_;
+        ColorType color_type_;
+
+        // Byte offsets inside vertex, omitted attributes have zero size
+        std::array<size_t, COUNT_ATTRIBUTES> offsets_ = {};
+        std::array<size_t, COUNT_ATTRIBUTES> sizes_ = {};
+        size_t vertex_size_ = 0;
+
+    public:
+        // Constructors
+        explicit VertexFormat(NormalType normal_type = NormalType::FLOAT, TexCoordType tex_coord_type = TexCoordType::FLOAT, ColorType color_type = ColorType::FLOAT) noexcept;
+
+        bool operator==(const VertexFormat& other) const noexcept;
+
+        bool operator!=(const VertexFormat& other) const noexcept;
+
+        // Getters
+        NormalType get_normal_type() const noexcept;
+
+        TexCoordType get_tex_coord_type() const noexcept;
+
+        ColorType get_color_type() const noexcept;
+
+        size_t get_vertex_size() const noexcept;
+
+        size_t get_offset(size_t attribute_id) const;
+
+        // Unique among all formats
+        size_t get_id() const noexcept;
+
+        bool contains(size_t attribute_id) const noexcept;
+
+        // Sets formats of the present attributes for the bound vertex array and disables omitted ones
+        void set_attribute_formats(GLuint binding_id) const;
+
+        // Conversion between planar float data and interleaved vertices, omitted attributes are skipped
+        void encode(size_t attribute_id, const GLfloat* data, size_t count_vertices, GLubyte* vertices) const;
+
+        void decode(size_t attribute_id, const GLubyte* vertices, size_t count_vertices, GLfloat* data) const;
+
+        // Static functions
+        // Packed normals, half float texture coordinates and byte colors, unused attributes are omitted
+        static VertexFormat compact(bool tex_coords, bool colors) noexcept;
+    };
+}  // namespace gre
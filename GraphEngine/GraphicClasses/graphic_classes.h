@@ -1,4 +1,9 @@
 #pragma once
 
+#include "GeometryArena/GeometryArena.hpp"
+#include "GeometryBuffer/GeometryBuffer.hpp"
+#include "GlStateCache/GlStateCache.hpp"
 #include "Kernel/Kernel.hpp"
+#include "StreamBuffer/StreamBuffer.hpp"
 #include "Texture/Texture.hpp"
+#include "VertexFormat/VertexFormat.hpp"
@@ -11,6 +11,11 @@ namespace gre {
         double shadow_height_ = 10.0;
         double shadow_depth_ = 10.0;
 
+        // Without cascades a single shadow box is placed at shadow_position
+        size_t count_cascades_ = 0;
+        double cascade_distance_ = 100.0;
+        double cascade_split_weight_ = 0.75;
+
         Vec3 direction_;
         Matrix4x4 projection_;
 
@@ -25,9 +30,43 @@ namespace gre {
             projection_ *= Matrix4x4::translation_matrix(Vec3(0.0, 0.0, -shadow_depth_ / 2.0));
         }
 
-        Matrix4x4 get_view_matrix() const noexcept {
+        Matrix4x4 get_rotation_matrix() const noexcept {
             const Vec3& horizont = direction_.horizon();
-            return Matrix4x4(horizont, direction_ ^ horizont, direction_).transpose() * Matrix4x4::translation_matrix(-shadow_position);
+            return Matrix4x4(horizont, direction_ ^ horizont, direction_).transpose();
+        }
+
+        Matrix4x4 get_view_matrix() const noexcept {
+            return get_rotation_matrix() * Matrix4x4::translation_matrix(-shadow_position);
+        }
+
+        // Blend of the logarithmic and the uniform split of the view depth range
+        double get_cascade_split(double min_depth, double max_depth, size_t split_id) const noexcept {
+            double ratio = static_cast<double>(split_id) / static_cast<double>(count_cascades_);
+            double logarithmic_split = min_depth * pow(max_depth / min_depth, ratio);
+            double uniform_split = min_depth + (max_depth - min_depth) * ratio;
+            return cascade_split_weight_ * logarithmic_split + (1.0 - cascade_split_weight_) * uniform_split;
+        }
+
+        // Orthographic box around the sphere bounding the camera frustum between two view depths
+        Matrix4x4 get_cascade_matrix(const Camera& camera, double near_depth, double far_depth, const Vec2& resolution) const {
+            double tan_x = tan(camera.get_fov() / 2.0);
+            double tan_y = tan_x * camera.get_viewport_size().y / camera.get_viewport_size().x;
+            double slope = tan_x * tan_x + tan_y * tan_y;
+
+            // Radius depends only on the depths, so the box keeps its size while the camera moves or rotates
+            double center_depth = std::min((near_depth + far_depth) * (1.0 + slope) / 2.0, far_depth);
+            double radius = sqrt(std::max((center_depth - near_depth) * (center_depth - near_depth) + slope * near_depth * near_depth, (far_depth - center_depth) * (far_depth - center_depth) + slope * far_depth * far_depth));
+
+            // Center moves in whole texels, so static geometry is rasterized the same way in every frame
+            Matrix4x4 rotation = get_rotation_matrix();
+            Vec3 center = rotation * (camera.position + camera.get_direction() * center_depth);
+            Vec3 texel_size = Vec3(2.0 * radius / resolution.x, 2.0 * radius / resolution.y, 2.0 * radius / resolution.x);
+            center = Vec3(floor(center.x / texel_size.x) * texel_size.x, floor(center.y / texel_size.y) * texel_size.y, floor(center.z / texel_size.z) * texel_size.z);
+
+            // Casters up to the shadow depth in front of the sphere are kept
+            Matrix4x4 projection = Matrix4x4::scale_matrix(Vec3(1.0 / radius, 1.0 / radius, 2.0 / (2.0 * radius + shadow_depth_)));
+            projection *= Matrix4x4::translation_matrix(-Vec3(center.x, center.y, center.z - shadow_depth_ / 2.0));
+            return projection * rotation;
         }
 
     public:
@@ -52,16 +91,11 @@ namespace gre {
             set_projection_matrix();
         }
 
-        // MAIN shader expected
-        void set_uniforms(size_t id, const Shader& shader) const override {
-            std::string name = "lights[" + std::to_string(id) + "].";
-            set_light_uniforms(name, shader);
-
-            shader.set_uniform_i((name + "type").c_str(), LIGHT_TYPE);
-            shader.set_uniform_f((name + "direction").c_str(), direction_);
-            if (shadow) {
-                shader.set_uniform_matrix((name + "light_space").c_str(), get_light_space_matrix());
-            }
+        Record get_record() const override {
+            Record record = get_light_record();
+            record.type = LIGHT_TYPE;
+            set_record_vec3(direction_, record.direction);
+            return record;
         }
 
         void set_shadow_width(double shadow_width) {
@@ -97,6 +131,33 @@ namespace gre {
             set_projection_matrix();
         }
 
+        // Zero count returns to the single shadow box
+        void set_count_cascades(size_t count_cascades) noexcept {
+            count_cascades_ = count_cascades;
+        }
+
+        // Cascades end at this view depth or at the far plane of the camera
+        void set_cascade_distance(double cascade_distance) {
+#ifdef _DEBUG
+            if (cascade_distance < 0.0 || equality(cascade_distance, 0.0)) {
+                throw GreInvalidArgument(__FILE__, __LINE__, "set_cascade_distance, not a positive cascade distance.\n\n");
+            }
+#endif // _DEBUG
+
+            cascade_distance_ = cascade_distance;
+        }
+
+        // One gives the logarithmic split, zero gives the uniform one
+        void set_cascade_split_weight(double cascade_split_weight) {
+#ifdef _DEBUG
+            if (cascade_split_weight < 0.0 || 1.0 < cascade_split_weight) {
+                throw GreInvalidArgument(__FILE__, __LINE__, "set_cascade_split_weight, the weight is not in the range [0, 1].\n\n");
+            }
+#endif // _DEBUG
+
+            cascade_split_weight_ = cascade_split_weight;
+        }
+
         void set_direction(const Vec3& direction) {
 #ifdef _DEBUG
             try {
@@ -110,10 +171,42 @@ namespace gre {
 #endif // _DEBUG
         }
 
+        size_t get_count_cascades() const noexcept {
+            return count_cascades_;
+        }
+
         Matrix4x4 get_light_space_matrix() const noexcept override {
             return projection_ * get_view_matrix();
         }
 
+        size_t get_count_shadow_maps() const noexcept override {
+            return std::max(count_cascades_, static_cast<size_t>(1));
+        }
+
+        bool has_camera_shadow_maps() const noexcept override {
+            return count_cascades_ > 0;
+        }
+
+        // Cascades split the camera frustum from the near plane up to the cascade distance, every second one halves the resolution
+        std::vector<ShadowMap> get_shadow_maps(const Camera& camera, const Vec2& resolution) const override {
+            if (count_cascades_ == 0) {
+                return Light::get_shadow_maps(camera, resolution);
+            }
+
+            double min_depth = camera.get_min_distance();
+            double max_depth = std::max(std::min(camera.get_max_distance(), cascade_distance_), min_depth);
+
+            std::vector<ShadowMap> shadow_maps;
+            shadow_maps.reserve(count_cascades_);
+            for (size_t i = 0; i < count_cascades_; ++i) {
+                double near_depth = get_cascade_split(min_depth, max_depth, i);
+                double far_depth = get_cascade_split(min_depth, max_depth, i + 1);
+                double resolution_scale = pow(0.5, static_cast<double>(i / 2));
+                shadow_maps.push_back({ get_cascade_matrix(camera, near_depth, far_depth, resolution * resolution_scale), far_depth, resolution_scale });
+            }
+            return shadow_maps;
+        }
+
         GraphObject get_shadow_box() const {
             GraphObject shadow_box = GraphObject::cube(1);
             shadow_box.transparent = true;
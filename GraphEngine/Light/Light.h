@@ -1,23 +1,136 @@
 #pragma once
 
+#include <cstring>
+#include "../Cameras/cameras.h"
 #include "../GraphObjects/graph_objects.h"
 
 
 namespace gre {
+    // Taps of the shadow map filter, every tap is a bilinearly filtered hardware comparison
+    enum class ShadowFilter {
+        HARD,
+        PCF_4,
+        PCF_9,
+        PCF_16,
+        POISSON,  // 16 taps on a disc of the shadow softness radius
+        PCSS      // Poisson disc shrunk near the blockers, cube maps use the 20 tap filter instead
+    };
+
     class Light {
+        friend class LightStorage;
+
     protected:
+        // Light struct of the MAIN shader in std430 layout
+        struct Record {
+            GLfloat position[3];
+            GLint type;
+            GLfloat direction[3];
+            GLint shadow;
+            GLfloat ambient[3];
+            GLfloat constant;
+            GLfloat diffuse[3];
+            GLfloat linear;
+            GLfloat specular[3];
+            GLfloat quadratic;
+            GLfloat cut_in;
+            GLfloat cut_out;
+            GLfloat range;
+            GLint shadow_map_id;
+            GLint count_shadow_maps;
+            GLfloat shadow_distance;
+            GLint shadow_filter;
+            GLfloat shadow_bias;
+            GLfloat shadow_slope_bias;
+            GLfloat shadow_softness;
+            GLint padding[2];
+
+            // Record is fully initialized, padding included
+            bool operator==(const Record& other) const noexcept {
+                return std::memcmp(this, &other, sizeof(Record)) == 0;
+            }
+
+            bool operator!=(const Record& other) const noexcept {
+                return !(*this == other);
+            }
+        };
+
+        // Fraction of the full brightness below which point and spot lights are skipped by clustering
+        inline static const double ATTENUATION_CUTOFF = 1.0 / 256.0;
+
         Vec3 ambient_ = Vec3(0.25);
         Vec3 diffuse_ = Vec3(0.5);
         Vec3 specular_ = Vec3(0.75);
 
-        void set_light_uniforms(const std::string& name, const Shader& shader) const {
-            shader.set_uniform_f((name + "ambient").c_str(), ambient_);
-            shader.set_uniform_f((name + "diffuse").c_str(), diffuse_);
-            shader.set_uniform_f((name + "specular").c_str(), specular_);
-            shader.set_uniform_i((name + "shadow").c_str(), shadow);
+        // Biases are in units of the shadow map depth range
+        ShadowFilter shadow_filter_ = ShadowFilter::PCF_9;
+        double shadow_bias_ = 0.005;
+        double shadow_slope_bias_ = 0.005;
+        double shadow_softness_ = 2.0;
+
+        static void set_record_vec3(const Vec3& vector, GLfloat* destination) noexcept {
+            destination[0] = static_cast<GLfloat>(vector.x);
+            destination[1] = static_cast<GLfloat>(vector.y);
+            destination[2] = static_cast<GLfloat>(vector.z);
+        }
+
+        // Column major order
+        static void set_record_matrix(const Matrix4x4& matrix, GLfloat* destination) noexcept {
+            Mat4f(matrix).store(destination);
+        }
+
+        // Distance where attenuated light drops below ATTENUATION_CUTOFF, negative if it never does
+        GLfloat get_attenuation_range(double constant, double linear, double quadratic) const noexcept {
+            double intensity = std::max({ ambient_.x, ambient_.y, ambient_.z, diffuse_.x, diffuse_.y, diffuse_.z, specular_.x, specular_.y, specular_.z });
+            double limit = intensity / ATTENUATION_CUTOFF;
+            if (quadratic > 0.0) {
+                return static_cast<GLfloat>(std::max((-linear + sqrt(linear * linear + 4.0 * quadratic * std::max(limit - constant, 0.0))) / (2.0 * quadratic), 0.0));
+            }
+            if (linear > 0.0) {
+                return static_cast<GLfloat>(std::max((limit - constant) / linear, 0.0));
+            }
+            return -1.0f;
+        }
+
+        // Fields shared by all light types, the others are zeroed
+        Record get_light_record() const noexcept {
+            Record record;
+            std::memset(&record, 0, sizeof(Record));
+            set_record_vec3(ambient_, record.ambient);
+            set_record_vec3(diffuse_, record.diffuse);
+            set_record_vec3(specular_, record.specular);
+            record.shadow = shadow;
+            record.shadow_map_id = -1;
+            record.count_shadow_maps = shadow ? static_cast<GLint>(get_count_shadow_maps()) : 0;
+            record.shadow_filter = static_cast<GLint>(shadow_filter_);
+            record.shadow_bias = static_cast<GLfloat>(shadow_bias_);
+            record.shadow_slope_bias = static_cast<GLfloat>(shadow_slope_bias_);
+            record.shadow_softness = static_cast<GLfloat>(shadow_softness_);
+            return record;
+        }
+
+        // Part of the viewport width covered by the sphere, zero outside of the camera frustum
+        static double get_screen_coverage(const Camera& camera, const BoundingSphere& sphere) {
+            if (!Frustum(camera.get_projection_matrix() * camera.get_view_matrix()).intersects(sphere)) {
+                return 0.0;
+            }
+
+            double distance = (sphere.center - camera.position).length();
+            if (distance <= sphere.radius) {
+                return 1.0;
+            }
+            return std::min(sphere.radius / (distance * tan(camera.get_fov() / 2.0)), 1.0);
         }
 
     public:
+        // Shadow map used for fragments up to the view depth
+        struct ShadowMap {
+            Matrix4x4 light_space;
+            double max_depth;
+
+            // Side of the shadow map relative to the shadow atlas page, zero if the map is not needed for the camera
+            double resolution_scale = 1.0;
+        };
+
         bool shadow = false;
 
         Light() {
@@ -59,11 +172,74 @@ namespace gre {
             specular_ = specular;
         }
 
-        // MAIN shader expected
-        virtual void set_uniforms(size_t id, const Shader& shader) const = 0;
+        void set_shadow_filter(ShadowFilter shadow_filter) noexcept {
+            shadow_filter_ = shadow_filter;
+        }
+
+        // Slope bias is scaled by the tangent of the angle between the surface normal and the light direction
+        void set_shadow_bias(double constant_bias, double slope_bias) {
+#ifdef _DEBUG
+            if (constant_bias < 0.0 || slope_bias < 0.0) {
+                throw GreInvalidArgument(__FILE__, __LINE__, "set_shadow_bias, negative bias value.\n\n");
+            }
+#endif // _DEBUG
+
+            shadow_bias_ = constant_bias;
+            shadow_slope_bias_ = slope_bias;
+        }
+
+        // Filter radius in texels of the shadow map, the largest penumbra for PCSS
+        void set_shadow_softness(double shadow_softness) {
+#ifdef _DEBUG
+            if (shadow_softness < 0.0) {
+                throw GreInvalidArgument(__FILE__, __LINE__, "set_shadow_softness, negative shadow softness.\n\n");
+            }
+#endif // _DEBUG
+
+            shadow_softness_ = shadow_softness;
+        }
+
+        ShadowFilter get_shadow_filter() const noexcept {
+            return shadow_filter_;
+        }
+
+        double get_shadow_bias() const noexcept {
+            return shadow_bias_;
+        }
+
+        double get_shadow_slope_bias() const noexcept {
+            return shadow_slope_bias_;
+        }
+
+        double get_shadow_softness() const noexcept {
+            return shadow_softness_;
+        }
+
+        // Value of lights[id] in MAIN shader
+        virtual Record get_record() const = 0;
 
         virtual Matrix4x4 get_light_space_matrix() const = 0;
 
+        // Such lights use one cube map of the cube shadow texture array instead of 2D layers
+        virtual bool has_cube_shadow_map() const noexcept {
+            return false;
+        }
+
+        // Number of consecutive shadow maps used by the light
+        virtual size_t get_count_shadow_maps() const noexcept {
+            return 1;
+        }
+
+        // Such lights fit their shadow maps to every camera separately
+        virtual bool has_camera_shadow_maps() const noexcept {
+            return false;
+        }
+
+        // Shadow maps in order of the view depth, the page resolution allows to align them with texels
+        virtual std::vector<ShadowMap> get_shadow_maps(const Camera& /*camera*/, const Vec2& /*resolution*/) const {
+            return { ShadowMap{ get_light_space_matrix(), std::numeric_limits<double>::max() } };
+        }
+
         virtual ~Light() {
         }
     };
@@ -1,36 +1,126 @@
 #pragma once
 
+#include "../Cameras/cameras.h"
 #include "../Light/Light.h"
+#include "../Light/PointLight.h"
 
 
 namespace gre {
 	class LightStorage {
 		friend class GraphEngine;
 
+		inline static const UniformHandle NUMBER_LIGHTS_UNIFORM = UniformHandle("number_lights");
+		inline static const UniformHandle DEPTH_RANGE_UNIFORM = UniformHandle("depth_range");
+		inline static const UniformHandle VIEWPORT_SIZE_UNIFORM = UniformHandle("viewport_size");
+		inline static const UniformHandle VIEW_UNIFORM = UniformHandle("view");
+		inline static const UniformHandle PROJECTION_UNIFORM = UniformHandle("projection");
+		inline static const GLuint LIGHTS_BINDING = 5;
+		inline static const GLuint CLUSTERS_BINDING = 6;
+		inline static const GLuint DEFERRED_LIGHTS_BINDING = 7;
+		inline static const GLuint SHADOW_MAPS_BINDING = 8;
+		inline static const UniformHandle FIRST_LIGHT_UNIFORM = UniformHandle("first_light");
+		inline static const UniformHandle LIGHT_VOLUME_UNIFORM = UniformHandle("light_volume");
+
+		// Smallest tile of the shadow atlas is the page divided by 2^MAX_SHADOW_TILE_LEVEL along each side
+		inline static const size_t MAX_SHADOW_TILE_LEVEL = 4;
+		inline static const double SHADOW_TILE_HYSTERESIS = 0.75;
+
+		// Sphere circumscribed around the unit ball, scaled to the range of point and spot lights by the LIGHTING shader,
+		// buffers are shared between contexts and vertex arrays are created per context
+		inline static GLuint light_volume_vertex_buffer_ = 0;
+		inline static GLuint light_volume_index_buffer_ = 0;
+		inline static GLsizei light_volume_count_indices_ = 0;
+
+		// Light space and atlas tile of a shadow map, versions are unique among all shadow maps
+		struct ShadowState {
+			Matrix4x4 light_space;
+			size_t version = 0;
+			double max_depth = 0.0;
+			std::optional<AtlasAllocator::Tile> tile;  // Shadow maps not needed for any camera have no tile
+		};
+
+		// Cube map of a point light with shadow, versions share the counter with layers
+		struct CubeShadowState {
+			const PointLight* light = nullptr;
+			Matrix4x4 light_space;
+			size_t version = 0;
+		};
+
+		// ShadowMap struct of the MAIN shader in std430 layout
+		struct ShadowMapRecord {
+			GLfloat light_space[16];
+			GLfloat tile[4];  // Offset and size in texture coordinates of the page
+			GLfloat max_depth;
+			GLint page;       // Negative without tile
+			GLfloat padding[2];
+		};
+
+		inline static size_t last_shadow_version_ = 0;
+
+		// Pages of the shadow texture array are split into tiles sized by the importance of the shadow maps
 		GLuint depth_map_frame_buffer_ = 0;
 		GLuint depth_map_texture_id_ = 0;
+		mutable AtlasAllocator shadow_atlas_;
+		mutable std::vector<std::optional<size_t>> shadow_tile_levels_;
+
+		// Comparison sampler of both shadow arrays and the plain depth sampler used for the PCSS blocker search
+		GLuint shadow_compare_sampler_ = 0;
+		GLuint shadow_depth_sampler_ = 0;
+
+		// Six layers per point light, rendered in one layered pass
+		GLuint cube_map_frame_buffer_ = 0;
+		GLuint cube_map_texture_id_ = 0;
+		mutable size_t count_cube_maps_ = 0;
+		mutable std::vector<CubeShadowState> cube_shadow_states_;
+
+		// Changes whenever content of the shadow maps is lost
+		mutable size_t shadow_maps_version_ = 0;
+		mutable std::vector<ShadowState> shadow_states_;
+
+		// Shadow map ids of the lights with shadow in memory order, one list per camera memory id
+		mutable std::vector<std::vector<size_t>> camera_shadow_maps_;
+
+		// Layers of the lights with shadow in memory order, cascades are the ones of the current camera
+		mutable GLuint shadow_map_buffer_ = 0;
+		mutable size_t shadow_map_buffer_capacity_ = 0;
+		mutable std::vector<ShadowMapRecord> shadow_map_records_;
+
+		// Records in memory order, only the changed ones are uploaded
+		mutable GLuint light_buffer_ = 0;
+		mutable size_t light_buffer_capacity_ = 0;
+		mutable std::vector<Light::Record> light_records_;
+
+		// Counts and index lists of lights intersecting view space clusters of the current camera
+		GLuint cluster_buffer_ = 0;
+		std::array<GLuint, 3> cluster_grid_ = { 0, 0, 0 };
+		GLuint max_cluster_lights_ = 0;
+
+		// Light ids of the deferred lighting pass, lights without range are followed by lights drawn as volumes
+		mutable GLuint deferred_buffer_ = 0;
+		mutable size_t deferred_buffer_capacity_ = 0;
+		mutable std::vector<GLuint> deferred_lights_;
 
 		size_t shadow_width_ = 1024;
 		size_t shadow_height_ = 1024;
+		size_t cube_shadow_resolution_ = 512;
 
-		size_t max_count_lights_;
 		std::vector<size_t> lights_index_;
 		std::vector<size_t> free_light_id_;
 		std::vector<std::pair<size_t, Light*>> lights_;
 
 		LightStorage() noexcept {
-			max_count_lights_ = 0;
 		}
 
 		LightStorage(const LightStorage& other) {
 			shadow_width_ = other.shadow_width_;
 			shadow_height_ = other.shadow_height_;
-			max_count_lights_ = other.max_count_lights_;
+			cube_shadow_resolution_ = other.cube_shadow_resolution_;
 			lights_index_ = other.lights_index_;
 			free_light_id_ = other.free_light_id_;
 			lights_ = other.lights_;
 
-			create_depth_map_frame_buffer(max_count_lights_);
+			create_depth_map_frame_buffer();
+			create_cluster_buffer(other.cluster_grid_, other.max_cluster_lights_);
 		}
 
 		LightStorage(LightStorage&& other) noexcept {
@@ -49,46 +139,508 @@ namespace gre {
 			return *this;
 		}
 
-		void set_uniforms(const Shader& shader) const {
-			shader.set_uniform_i("number_lights", static_cast<GLint>(lights_.size()));
+		// Lights have public fields, so changes are found by comparing records with the uploaded ones
+		void update_light_buffer() const {
+			size_t dirty_begin = lights_.size();
+			size_t dirty_end = 0;
+			if (lights_.size() > light_buffer_capacity_) {
+				if (light_buffer_ == 0) {
+					glGenBuffers(1, &light_buffer_);
+				}
+				light_buffer_capacity_ = std::max(2 * light_buffer_capacity_, lights_.size());
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_buffer_);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Light::Record) * light_buffer_capacity_, NULL, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+				dirty_begin = 0;
+				dirty_end = lights_.size();
+			}
+
+			// Shadow maps are assigned to lights with shadow in memory order, point lights count cube maps separately
+			GLint shadow_map_id = 0;
+			GLint cube_map_id = 0;
+			light_records_.resize(lights_.size());
+			for (size_t i = 0; i < lights_.size(); ++i) {
+				Light::Record record = lights_[i].second->get_record();
+				if (record.shadow && lights_[i].second->has_cube_shadow_map()) {
+					record.shadow_map_id = cube_map_id++;
+				}
+				else if (record.shadow) {
+					record.shadow_map_id = shadow_map_id;
+					shadow_map_id += record.count_shadow_maps;
+				}
+
+				if (record != light_records_[i]) {
+					light_records_[i] = record;
+					dirty_begin = std::min(dirty_begin, i);
+					dirty_end = std::max(dirty_end, i + 1);
+				}
+			}
+
+			if (dirty_begin < dirty_end) {
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_buffer_);
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(Light::Record) * dirty_begin, sizeof(Light::Record) * (dirty_end - dirty_begin), &light_records_[dirty_begin]);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			}
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, light_buffer_);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Side of the tile follows the resolution scale in powers of two, small changes keep the current tile
+		static std::optional<size_t> get_shadow_tile_level(double resolution_scale, const std::optional<AtlasAllocator::Tile>& tile) {
+			if (resolution_scale <= 0.0) {
+				return std::nullopt;
+			}
+
+			double level = std::min(std::max(-log2(resolution_scale), 0.0), static_cast<double>(MAX_SHADOW_TILE_LEVEL));
+			if (tile && std::abs(level - static_cast<double>(tile->level)) < SHADOW_TILE_HYSTERESIS) {
+				return tile->level;
+			}
+			return static_cast<size_t>(std::round(level));
+		}
+
+		// Only shadow maps with a new tile size are moved, larger tiles are placed first to keep pages packed
+		void update_shadow_tiles() const {
+			std::vector<size_t> missing_tiles;
+			double required_pages = 0.0;
+			for (size_t i = 0; i < shadow_states_.size(); ++i) {
+				ShadowState& state = shadow_states_[i];
+				const std::optional<size_t>& level = shadow_tile_levels_[i];
+				if (state.tile && (!level || state.tile->level != *level)) {
+					shadow_atlas_.deallocate(*state.tile);
+					state.tile.reset();
+				}
+				if (level) {
+					required_pages += pow(0.25, static_cast<double>(*level));
+				}
+				if (level && !state.tile) {
+					missing_tiles.push_back(i);
+				}
+			}
+
+			// Pages are halved when a quarter of them is enough, every tile is placed again
+			size_t count_pages = shadow_atlas_.get_count_pages();
+			if (count_pages > 1 && required_pages <= count_pages / 4.0) {
+				shadow_atlas_ = AtlasAllocator(MAX_SHADOW_TILE_LEVEL, count_pages / 2);
+				allocate_shadow_pages();
+				missing_tiles.clear();
+				for (size_t i = 0; i < shadow_states_.size(); ++i) {
+					shadow_states_[i].tile.reset();
+					if (shadow_tile_levels_[i]) {
+						missing_tiles.push_back(i);
+					}
+				}
+			}
+
+			std::stable_sort(missing_tiles.begin(), missing_tiles.end(), [&](size_t left, size_t right) {
+				return *shadow_tile_levels_[left] < *shadow_tile_levels_[right];
+			});
+			for (size_t shadow_map_id : missing_tiles) {
+				size_t level = *shadow_tile_levels_[shadow_map_id];
+				std::optional<AtlasAllocator::Tile> tile = shadow_atlas_.allocate(level);
+				if (!tile) {
+					shadow_atlas_.grow(2 * shadow_atlas_.get_count_pages());
+					allocate_shadow_pages();
+					tile = shadow_atlas_.allocate(level);
+				}
+
+				ShadowState& state = shadow_states_[shadow_map_id];
+				state.tile = tile;
+				state.version = ++last_shadow_version_;
+			}
+		}
+
+		void fit_shadow_state(size_t shadow_map_id, const Light::ShadowMap& shadow_map) const {
+			if (shadow_states_.size() <= shadow_map_id) {
+				shadow_states_.resize(shadow_map_id + 1);
+			}
+
+			ShadowState& state = shadow_states_[shadow_map_id];
+			if (state.version == 0 || state.light_space != shadow_map.light_space) {
+				state.light_space = shadow_map.light_space;
+				state.version = ++last_shadow_version_;
+			}
+			state.max_depth = shadow_map.max_depth;
+			shadow_tile_levels_.push_back(get_shadow_tile_level(shadow_map.resolution_scale, state.tile));
+		}
+
+		// Called once per frame before any camera is drawn, versions change only for the shadow maps which moved.
+		// Cascades are kept for every camera, other shadow maps are shared and get the tile required by the camera which sees them largest
+		void fit_shadow_maps(const CamerasStorage& cameras) const {
+			size_t shadow_map_id = 0;
+			size_t cube_map_id = 0;
+			shadow_tile_levels_.clear();
+			camera_shadow_maps_.assign(cameras.size(), {});
 			for (const auto& [id, light] : lights_) {
-				light->set_uniforms(lights_index_[id], shader);
+				if (!light->shadow) {
+					continue;
+				}
+
+				if (light->has_cube_shadow_map()) {
+					if (cube_shadow_states_.size() <= cube_map_id) {
+						cube_shadow_states_.resize(cube_map_id + 1);
+					}
+					CubeShadowState& state = cube_shadow_states_[cube_map_id++];
+					Matrix4x4 light_space = light->get_light_space_matrix();
+					state.light = static_cast<const PointLight*>(light);
+					if (state.version == 0 || state.light_space != light_space) {
+						state.light_space = light_space;
+						state.version = ++last_shadow_version_;
+					}
+					continue;
+				}
+
+				std::vector<Light::ShadowMap> shared_shadow_maps;
+				for (const auto& [camera_id, camera] : cameras) {
+					std::vector<size_t>& camera_shadow_maps = camera_shadow_maps_[cameras.get_memory_id(camera_id)];
+					std::vector<Light::ShadowMap> shadow_maps = light->get_shadow_maps(camera, get_shadow_resolution());
+					if (light->has_camera_shadow_maps()) {
+						for (const Light::ShadowMap& shadow_map : shadow_maps) {
+							camera_shadow_maps.push_back(shadow_map_id);
+							fit_shadow_state(shadow_map_id++, shadow_map);
+						}
+						continue;
+					}
+
+					if (shared_shadow_maps.empty()) {
+						shared_shadow_maps = shadow_maps;
+					}
+					for (size_t i = 0; i < shared_shadow_maps.size(); ++i) {
+						shared_shadow_maps[i].resolution_scale = std::max(shared_shadow_maps[i].resolution_scale, shadow_maps[i].resolution_scale);
+						camera_shadow_maps.push_back(shadow_map_id + i);
+					}
+				}
+				for (const Light::ShadowMap& shadow_map : shared_shadow_maps) {
+					fit_shadow_state(shadow_map_id++, shadow_map);
+				}
+			}
+			cube_shadow_states_.resize(cube_map_id);
+
+			for (size_t i = shadow_map_id; i < shadow_states_.size(); ++i) {
+				if (shadow_states_[i].tile) {
+					shadow_atlas_.deallocate(*shadow_states_[i].tile);
+				}
 			}
+			shadow_states_.resize(shadow_map_id);
+
+			update_shadow_tiles();
 		}
 
-		void set_framebuffer() const {
-			glBindFramebuffer(GL_FRAMEBUFFER, depth_map_frame_buffer_);
-			glViewport(0, 0, static_cast<GLsizei>(shadow_width_), static_cast<GLsizei>(shadow_height_));
+		// Records of the shadow maps seen by the camera in the order of the light records
+		void set_shadow_maps(size_t camera_memory_id) const {
+#ifdef _DEBUG
+			if (camera_shadow_maps_.size() <= camera_memory_id) {
+				throw GreOutOfRange(__FILE__, __LINE__, "set_shadow_maps, invalid camera memory id.\n\n");
+			}
+#endif // _DEBUG
+
+			shadow_map_records_.clear();
+			for (size_t shadow_map_id : camera_shadow_maps_[camera_memory_id]) {
+				const ShadowState& state = shadow_states_[shadow_map_id];
+				ShadowMapRecord record;
+				std::memset(&record, 0, sizeof(ShadowMapRecord));
+				Light::set_record_matrix(state.light_space, record.light_space);
+				record.max_depth = static_cast<GLfloat>(std::min(state.max_depth, static_cast<double>(std::numeric_limits<GLfloat>::max())));
+				record.page = -1;
+				if (state.tile) {
+					GLfloat tile_size = static_cast<GLfloat>(1.0 / static_cast<double>(static_cast<size_t>(1) << state.tile->level));
+					record.tile[0] = static_cast<GLfloat>(state.tile->x) * tile_size;
+					record.tile[1] = static_cast<GLfloat>(state.tile->y) * tile_size;
+					record.tile[2] = tile_size;
+					record.tile[3] = tile_size;
+					record.page = static_cast<GLint>(state.tile->page);
+				}
+				shadow_map_records_.push_back(record);
+			}
+
+			if (shadow_map_records_.empty()) {
+				return;
+			}
+
+			if (shadow_map_records_.size() > shadow_map_buffer_capacity_) {
+				if (shadow_map_buffer_ == 0) {
+					glGenBuffers(1, &shadow_map_buffer_);
+				}
+				shadow_map_buffer_capacity_ = std::max(2 * shadow_map_buffer_capacity_, shadow_map_records_.size());
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadow_map_buffer_);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ShadowMapRecord) * shadow_map_buffer_capacity_, NULL, GL_DYNAMIC_DRAW);
+			}
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadow_map_buffer_);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ShadowMapRecord) * shadow_map_records_.size(), shadow_map_records_.data());
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SHADOW_MAPS_BINDING, shadow_map_buffer_);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Shadow maps of all cameras, up to date after fit_shadow_maps
+		size_t get_count_used_shadow_maps() const noexcept {
+			return shadow_states_.size();
+		}
+
+		size_t get_count_used_cube_maps() const noexcept {
+			return cube_shadow_states_.size();
+		}
+
+		const CubeShadowState& get_cube_shadow_state(size_t cube_map_id) const {
 #ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
+			if (cube_shadow_states_.size() <= cube_map_id) {
+				throw GreOutOfRange(__FILE__, __LINE__, "get_cube_shadow_state, invalid cube map id.\n\n");
+			}
 #endif // _DEBUG
+
+			return cube_shadow_states_[cube_map_id];
 		}
 
-		void set_depth_map_texture(size_t id) const {
-			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, static_cast<GLint>(depth_map_texture_id_), 0, static_cast<GLint>(lights_index_[id]));
-			glClear(GL_DEPTH_BUFFER_BIT);
+		const ShadowState& get_shadow_state(size_t shadow_map_id) const {
 #ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
+			if (shadow_states_.size() <= shadow_map_id) {
+				throw GreOutOfRange(__FILE__, __LINE__, "get_shadow_state, invalid shadow map id.\n\n");
+			}
 #endif // _DEBUG
+
+			return shadow_states_[shadow_map_id];
+		}
+
+		size_t get_shadow_maps_version() const noexcept {
+			return shadow_maps_version_;
+		}
+
+		// Bins lights into clusters of the camera frustum, MAIN shader receives the cluster parameters
+		void cluster_lights(const Camera& camera, const Shader& cluster_shader, const Shader& main_shader) const {
+			GLfloat min_distance = static_cast<GLfloat>(camera.get_min_distance());
+			GLfloat max_distance = static_cast<GLfloat>(camera.get_max_distance());
+
+			cluster_shader.set_uniform_i(NUMBER_LIGHTS_UNIFORM, static_cast<GLint>(lights_.size()));
+			cluster_shader.set_uniform_f(DEPTH_RANGE_UNIFORM, min_distance, max_distance);
+			cluster_shader.set_uniform_matrix(VIEW_UNIFORM, camera.get_view_matrix());
+			cluster_shader.set_uniform_matrix(PROJECTION_UNIFORM, camera.get_projection_matrix());
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTERS_BINDING, cluster_buffer_);
+
+			const std::array<GLint, 3>& group_size = cluster_shader.get_work_group_size();
+			cluster_shader.dispatch(
+				(cluster_grid_[0] + group_size[0] - 1) / group_size[0],
+				(cluster_grid_[1] + group_size[1] - 1) / group_size[1],
+				(cluster_grid_[2] + group_size[2] - 1) / group_size[2]
+			);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+			GRE_CHECK_GL_ERRORS;
+
+			main_shader.set_uniform_f(DEPTH_RANGE_UNIFORM, min_distance, max_distance);
+			main_shader.set_uniform_f(VIEWPORT_SIZE_UNIFORM, camera.get_viewport_size());
+		}
+
+		// Additive blending is expected, geometry buffer depth limits volumes to the surfaces inside them
+		void draw_deferred(const Shader& lighting_shader, GLuint screen_vertex_array) const {
+			deferred_lights_.clear();
+			for (size_t i = 0; i < light_records_.size(); ++i) {
+				if (light_records_[i].type == 0 || light_records_[i].range < 0.0f) {
+					deferred_lights_.push_back(static_cast<GLuint>(i));
+				}
+			}
+			GLsizei count_screen_lights = static_cast<GLsizei>(deferred_lights_.size());
+			for (size_t i = 0; i < light_records_.size(); ++i) {
+				if (light_records_[i].type != 0 && light_records_[i].range > 0.0f) {
+					deferred_lights_.push_back(static_cast<GLuint>(i));
+				}
+			}
+			GLsizei count_volume_lights = static_cast<GLsizei>(deferred_lights_.size()) - count_screen_lights;
+
+			if (deferred_lights_.empty()) {
+				return;
+			}
+
+			if (deferred_lights_.size() > deferred_buffer_capacity_) {
+				if (deferred_buffer_ == 0) {
+					glGenBuffers(1, &deferred_buffer_);
+				}
+				deferred_buffer_capacity_ = std::max(2 * deferred_buffer_capacity_, deferred_lights_.size());
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, deferred_buffer_);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * deferred_buffer_capacity_, NULL, GL_DYNAMIC_DRAW);
+			}
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, deferred_buffer_);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * deferred_lights_.size(), deferred_lights_.data());
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEFERRED_LIGHTS_BINDING, deferred_buffer_);
+
+			// Directional and unbounded lights shade every covered pixel
+			if (count_screen_lights > 0) {
+				lighting_shader.set_uniform_i(FIRST_LIGHT_UNIFORM, 0);
+				lighting_shader.set_uniform_i(LIGHT_VOLUME_UNIFORM, 0);
+				GlStateCache::current().bind_vertex_array(screen_vertex_array);
+
+				glDisable(GL_DEPTH_TEST);
+				glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count_screen_lights);
+				glEnable(GL_DEPTH_TEST);
+			}
+
+			// Back faces behind the stored surface mark pixels inside the volume, clamping keeps volumes cut by the far plane
+			if (count_volume_lights > 0) {
+				lighting_shader.set_uniform_i(FIRST_LIGHT_UNIFORM, count_screen_lights);
+				lighting_shader.set_uniform_i(LIGHT_VOLUME_UNIFORM, 1);
+				GlStateCache::current().bind_vertex_array(get_light_volume_array());
+
+				glDepthFunc(GL_GREATER);
+				glCullFace(GL_FRONT);
+				glEnable(GL_DEPTH_CLAMP);
+				glDrawElementsInstanced(GL_TRIANGLES, light_volume_count_indices_, GL_UNSIGNED_INT, NULL, count_volume_lights);
+				glDisable(GL_DEPTH_CLAMP);
+				glCullFace(GL_BACK);
+				glDepthFunc(GL_LESS);
+			}
+
+			GRE_CHECK_GL_ERRORS;
 		}
 
-		void create_depth_map_frame_buffer(size_t max_count_lights) {
-			max_count_lights_ = max_count_lights;
+		void create_cluster_buffer(const std::array<GLuint, 3>& cluster_grid, GLuint max_cluster_lights) {
+			cluster_grid_ = cluster_grid;
+			max_cluster_lights_ = max_cluster_lights;
 
-			if (max_count_lights_ == 0) {
+			size_t count_clusters = static_cast<size_t>(cluster_grid_[0]) * cluster_grid_[1] * cluster_grid_[2];
+			if (count_clusters == 0) {
 				return;
 			}
 
+			glGenBuffers(1, &cluster_buffer_);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, cluster_buffer_);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * count_clusters * (1 + static_cast<size_t>(max_cluster_lights_)), NULL, GL_DYNAMIC_COPY);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Cube map array grows geometrically with the number of point lights with shadow, atlas pages grow with their tiles
+		void update_shadow_maps() const {
+			size_t count_used_cube_maps = 0;
+			for (const auto& [id, light] : lights_) {
+				if (light->shadow && light->has_cube_shadow_map()) {
+					++count_used_cube_maps;
+				}
+			}
+
+			if (count_used_cube_maps > count_cube_maps_) {
+				count_cube_maps_ = std::max(2 * count_cube_maps_, count_used_cube_maps);
+				shadow_maps_version_ = ++last_shadow_version_;
+				allocate_cube_maps();
+			}
+		}
+
+		// Content of all pages is lost
+		void allocate_shadow_pages() const {
+			shadow_maps_version_ = ++last_shadow_version_;
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, static_cast<GLsizei>(shadow_width_), static_cast<GLsizei>(shadow_height_), static_cast<GLsizei>(shadow_atlas_.get_count_pages()), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_2D_ARRAY, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void set_framebuffer() const {
+			update_shadow_maps();
+			glBindFramebuffer(GL_FRAMEBUFFER, depth_map_frame_buffer_);
+			glViewport(0, 0, static_cast<GLsizei>(shadow_width_), static_cast<GLsizei>(shadow_height_));
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void set_cube_map_framebuffer() const {
+			update_shadow_maps();
+			glBindFramebuffer(GL_FRAMEBUFFER, cube_map_frame_buffer_);
+			glViewport(0, 0, static_cast<GLsizei>(cube_shadow_resolution_), static_cast<GLsizei>(cube_shadow_resolution_));
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Clearing a layered attachment clears every layer, so faces of the cube map are cleared one by one
+		void set_cube_map_texture(size_t cube_map_id) const {
+			for (size_t i = 0; i < 6; ++i) {
+				glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cube_map_texture_id_, 0, static_cast<GLint>(6 * cube_map_id + i));
+				glClear(GL_DEPTH_BUFFER_BIT);
+			}
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cube_map_texture_id_, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Shadow maps are compared in hardware, the depth unit reads the same array without comparison
+		void bind_shadow_maps(GLuint shadow_maps_unit, GLuint cube_shadow_maps_unit, GLuint shadow_depth_maps_unit) const {
+			GlStateCache& state_cache = GlStateCache::current();
+			state_cache.bind_texture(shadow_maps_unit, GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
+			state_cache.bind_texture(cube_shadow_maps_unit, GL_TEXTURE_CUBE_MAP_ARRAY, cube_map_texture_id_);
+			state_cache.bind_texture(shadow_depth_maps_unit, GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
+			glBindSampler(shadow_maps_unit, shadow_compare_sampler_);
+			glBindSampler(cube_shadow_maps_unit, shadow_compare_sampler_);
+			glBindSampler(shadow_depth_maps_unit, shadow_depth_sampler_);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void unbind_shadow_maps(GLuint shadow_maps_unit, GLuint cube_shadow_maps_unit, GLuint shadow_depth_maps_unit) const {
+			GlStateCache& state_cache = GlStateCache::current();
+			glBindSampler(shadow_depth_maps_unit, 0);
+			glBindSampler(cube_shadow_maps_unit, 0);
+			glBindSampler(shadow_maps_unit, 0);
+			state_cache.bind_texture(shadow_depth_maps_unit, GL_TEXTURE_2D_ARRAY, 0);
+			state_cache.bind_texture(cube_shadow_maps_unit, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+			state_cache.bind_texture(shadow_maps_unit, GL_TEXTURE_2D_ARRAY, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Sampler parameters override the ones of the textures, cube maps ignore the wrap mode with seamless filtering
+		void create_shadow_samplers() {
+			GLfloat border_color[] = { 1.0, 1.0, 1.0, 1.0 };
+
+			glGenSamplers(1, &shadow_compare_sampler_);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+			glSamplerParameterfv(shadow_compare_sampler_, GL_TEXTURE_BORDER_COLOR, border_color);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glSamplerParameteri(shadow_compare_sampler_, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+			glGenSamplers(1, &shadow_depth_sampler_);
+			glSamplerParameteri(shadow_depth_sampler_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glSamplerParameteri(shadow_depth_sampler_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glSamplerParameteri(shadow_depth_sampler_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glSamplerParameteri(shadow_depth_sampler_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glSamplerParameteri(shadow_depth_sampler_, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		void allocate_cube_maps() const {
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_CUBE_MAP_ARRAY, cube_map_texture_id_);
+			glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT, static_cast<GLsizei>(cube_shadow_resolution_), static_cast<GLsizei>(cube_shadow_resolution_), static_cast<GLsizei>(6 * count_cube_maps_), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Other tiles of the page are kept, so clearing is limited to the tile
+		void set_depth_map_texture(const AtlasAllocator::Tile& tile) const {
+			GLsizei tile_width = static_cast<GLsizei>(shadow_width_ >> tile.level);
+			GLsizei tile_height = static_cast<GLsizei>(shadow_height_ >> tile.level);
+			GLint tile_x = static_cast<GLint>(tile.x) * tile_width;
+			GLint tile_y = static_cast<GLint>(tile.y) * tile_height;
+
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, static_cast<GLint>(depth_map_texture_id_), 0, static_cast<GLint>(tile.page));
+			glViewport(tile_x, tile_y, tile_width, tile_height);
+			glScissor(tile_x, tile_y, tile_width, tile_height);
+			glEnable(GL_SCISSOR_TEST);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glDisable(GL_SCISSOR_TEST);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		// Starts with one atlas page, pages are added when tiles of lights with shadow do not fit
+		void create_depth_map_frame_buffer() {
+			shadow_atlas_ = AtlasAllocator(MAX_SHADOW_TILE_LEVEL, 1);
+
 			glGenTextures(1, &depth_map_texture_id_);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
-			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, static_cast<GLsizei>(shadow_width_), static_cast<GLsizei>(shadow_height_), static_cast<GLsizei>(max_count_lights_), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			allocate_shadow_pages();
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
 			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
 			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 			GLfloat border_olor[] = { 1.0, 1.0, 1.0, 1.0 };
 			glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border_olor);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_2D_ARRAY, 0);
 
 			glGenFramebuffers(1, &depth_map_frame_buffer_);
 			glBindFramebuffer(GL_FRAMEBUFFER, depth_map_frame_buffer_);
@@ -103,18 +655,65 @@ namespace gre {
 			}
 #endif // _DEBUG
 
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			// Depth is sampled in shaders without comparison, cube maps are filtered across faces
+			count_cube_maps_ = 1;
+			glGenTextures(1, &cube_map_texture_id_);
+			allocate_cube_maps();
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_CUBE_MAP_ARRAY, cube_map_texture_id_);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			GlStateCache::current().bind_texture(0, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+			glGenFramebuffers(1, &cube_map_frame_buffer_);
+			glBindFramebuffer(GL_FRAMEBUFFER, cube_map_frame_buffer_);
+
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cube_map_texture_id_, 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+
 #ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				throw GreRuntimeError(__FILE__, __LINE__, "create_depth_map_frame_buffer, cube map framebuffer is not complete.\n\n");
+			}
 #endif // _DEBUG
+
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			create_shadow_samplers();
+			GRE_CHECK_GL_ERRORS;
 		}
 
 		void swap(LightStorage& other) noexcept {
 			std::swap(depth_map_frame_buffer_, other.depth_map_frame_buffer_);
 			std::swap(depth_map_texture_id_, other.depth_map_texture_id_);
+			std::swap(shadow_atlas_, other.shadow_atlas_);
+			std::swap(shadow_compare_sampler_, other.shadow_compare_sampler_);
+			std::swap(shadow_depth_sampler_, other.shadow_depth_sampler_);
+			shadow_tile_levels_.swap(other.shadow_tile_levels_);
+			std::swap(cube_map_frame_buffer_, other.cube_map_frame_buffer_);
+			std::swap(cube_map_texture_id_, other.cube_map_texture_id_);
+			std::swap(count_cube_maps_, other.count_cube_maps_);
+			cube_shadow_states_.swap(other.cube_shadow_states_);
+			std::swap(shadow_maps_version_, other.shadow_maps_version_);
+			shadow_states_.swap(other.shadow_states_);
+			camera_shadow_maps_.swap(other.camera_shadow_maps_);
+			std::swap(shadow_map_buffer_, other.shadow_map_buffer_);
+			std::swap(shadow_map_buffer_capacity_, other.shadow_map_buffer_capacity_);
+			shadow_map_records_.swap(other.shadow_map_records_);
+			std::swap(light_buffer_, other.light_buffer_);
+			std::swap(light_buffer_capacity_, other.light_buffer_capacity_);
+			light_records_.swap(other.light_records_);
+			std::swap(cluster_buffer_, other.cluster_buffer_);
+			std::swap(cluster_grid_, other.cluster_grid_);
+			std::swap(max_cluster_lights_, other.max_cluster_lights_);
+			std::swap(deferred_buffer_, other.deferred_buffer_);
+			std::swap(deferred_buffer_capacity_, other.deferred_buffer_capacity_);
+			deferred_lights_.swap(other.deferred_lights_);
 			std::swap(shadow_width_, other.shadow_width_);
 			std::swap(shadow_height_, other.shadow_height_);
-			std::swap(max_count_lights_, other.max_count_lights_);
+			std::swap(cube_shadow_resolution_, other.cube_shadow_resolution_);
 			lights_index_.swap(other.lights_index_);
 			free_light_id_.swap(other.free_light_id_);
 			lights_.swap(other.lights_);
@@ -123,12 +722,103 @@ namespace gre {
 		void deallocate() {
 			glDeleteFramebuffers(1, &depth_map_frame_buffer_);
 			glDeleteTextures(1, &depth_map_texture_id_);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
+			GlStateCache::current().on_texture_deleted(depth_map_texture_id_);
+			glDeleteSamplers(1, &shadow_compare_sampler_);
+			glDeleteSamplers(1, &shadow_depth_sampler_);
+			glDeleteFramebuffers(1, &cube_map_frame_buffer_);
+			glDeleteTextures(1, &cube_map_texture_id_);
+			GlStateCache::current().on_texture_deleted(cube_map_texture_id_);
+			glDeleteBuffers(1, &light_buffer_);
+			glDeleteBuffers(1, &cluster_buffer_);
+			glDeleteBuffers(1, &deferred_buffer_);
+			glDeleteBuffers(1, &shadow_map_buffer_);
+			GRE_CHECK_GL_ERRORS;
 
 			depth_map_frame_buffer_ = 0;
 			depth_map_texture_id_ = 0;
+			shadow_atlas_.clear();
+			shadow_tile_levels_.clear();
+			shadow_compare_sampler_ = 0;
+			shadow_depth_sampler_ = 0;
+			cube_map_frame_buffer_ = 0;
+			cube_map_texture_id_ = 0;
+			count_cube_maps_ = 0;
+			cube_shadow_states_.clear();
+			light_buffer_ = 0;
+			light_buffer_capacity_ = 0;
+			light_records_.clear();
+			shadow_states_.clear();
+			camera_shadow_maps_.clear();
+			shadow_map_buffer_ = 0;
+			shadow_map_buffer_capacity_ = 0;
+			shadow_map_records_.clear();
+			cluster_buffer_ = 0;
+			deferred_buffer_ = 0;
+			deferred_buffer_capacity_ = 0;
+		}
+
+		static void create_light_volume_buffers() {
+			if (light_volume_vertex_buffer_ != 0) {
+				return;
+			}
+
+			// Faces of the sphere stay outside the unit ball
+			const size_t count_slices = 16;
+			const size_t count_stacks = 8;
+			const double radius = 1.0 / (cos(PI / count_slices) * cos(PI / (2.0 * count_stacks)));
+
+			std::vector<GLfloat> vertices;
+			for (size_t i = 0; i <= count_stacks; ++i) {
+				double theta = PI * static_cast<double>(i) / count_stacks;
+				for (size_t j = 0; j < count_slices; ++j) {
+					double phi = 2.0 * PI * static_cast<double>(j) / count_slices;
+					vertices.push_back(static_cast<GLfloat>(radius * sin(theta) * cos(phi)));
+					vertices.push_back(static_cast<GLfloat>(radius * cos(theta)));
+					vertices.push_back(static_cast<GLfloat>(radius * sin(theta) * sin(phi)));
+				}
+			}
+
+			std::vector<GLuint> indices;
+			for (size_t i = 0; i < count_stacks; ++i) {
+				for (size_t j = 0; j < count_slices; ++j) {
+					GLuint top_left = static_cast<GLuint>(i * count_slices + j);
+					GLuint top_right = static_cast<GLuint>(i * count_slices + (j + 1) % count_slices);
+					GLuint bottom_left = top_left + static_cast<GLuint>(count_slices);
+					GLuint bottom_right = top_right + static_cast<GLuint>(count_slices);
+					indices.insert(indices.end(), { top_left, bottom_left, top_right, top_right, bottom_left, bottom_right });
+				}
+			}
+			light_volume_count_indices_ = static_cast<GLsizei>(indices.size());
+
+			glGenBuffers(1, &light_volume_vertex_buffer_);
+			glBindBuffer(GL_ARRAY_BUFFER, light_volume_vertex_buffer_);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			glGenBuffers(1, &light_volume_index_buffer_);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, light_volume_index_buffer_);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
+		}
+
+		static GLuint get_light_volume_array() {
+			GlStateCache& state_cache = GlStateCache::current();
+			GlStateCache::SharedVertexArray& light_volume_array = state_cache.get_shared_vertex_array(&light_volume_vertex_buffer_);
+			if (light_volume_array.version != 0) {
+				return light_volume_array.vertex_array_id;
+			}
+
+			state_cache.bind_vertex_array(light_volume_array.vertex_array_id);
+			glBindBuffer(GL_ARRAY_BUFFER, light_volume_vertex_buffer_);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(0));
+			glEnableVertexAttribArray(0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, light_volume_index_buffer_);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			GRE_CHECK_GL_ERRORS;
+
+			light_volume_array.version = 1;
+			return light_volume_array.vertex_array_id;
 		}
 
 	public:
@@ -155,16 +845,18 @@ namespace gre {
 			return lights_[lights_index_[id]].second;
 		}
 
+		// Resolution of an atlas page, tiles keep their place and share of the page
 		void set_shadow_resolution(size_t width, size_t height) {
-			glBindTexture(GL_TEXTURE_2D_ARRAY, depth_map_texture_id_);
-			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, static_cast<GLsizei>(width), static_cast<GLsizei>(height), static_cast<GLsizei>(max_count_lights_), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-#ifdef _DEBUG
-			check_gl_errors(__FILE__, __LINE__, __func__);
-#endif // _DEBUG
-
 			shadow_width_ = width;
 			shadow_height_ = height;
+			allocate_shadow_pages();
+		}
+
+		// Faces of the cube maps are square
+		void set_cube_shadow_resolution(size_t resolution) {
+			cube_shadow_resolution_ = resolution;
+			allocate_cube_maps();
+			shadow_maps_version_ = ++last_shadow_version_;
 		}
 
 		size_t get_memory_id(size_t id) const {
@@ -187,14 +879,19 @@ namespace gre {
 			return lights_[memory_id].first;
 		}
 
-		size_t get_max_count_lights() const noexcept {
-			return max_count_lights_;
-		}
-
 		Vec2 get_shadow_resolution() const noexcept {
 			return Vec2(static_cast<double>(shadow_width_), static_cast<double>(shadow_height_));
 		}
 
+		size_t get_cube_shadow_resolution() const noexcept {
+			return cube_shadow_resolution_;
+		}
+
+		// Layers of the shadow texture array
+		size_t get_count_shadow_pages() const noexcept {
+			return shadow_atlas_.get_count_pages();
+		}
+
 		bool contains(size_t id) const noexcept {
 			return id < lights_index_.size() && lights_index_[id] < std::numeric_limits<size_t>::max();
 		}
@@ -250,12 +947,6 @@ namespace gre {
 		}
 
 		size_t insert(Light* light) {
-#ifdef _DEBUG
-			if (lights_.size() == max_count_lights_) {
-				throw GreRuntimeError(__FILE__, __LINE__, "insert, too many lights created.\n\n");
-			}
-#endif // _DEBUG
-
 			size_t free_light_id = lights_index_.size();
 			if (free_light_id_.empty()) {
 				lights_index_.push_back(lights_.size());
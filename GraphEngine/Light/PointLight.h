@@ -10,6 +10,15 @@ namespace gre {
         double constant_ = 1.0;
         double linear_ = 0.0;
         double quadratic_ = 0.0;
+        double shadow_distance_ = 10.0;
+
+        // Cube map face directions with the texture axes of the face, see the cube map selection table of the OpenGL specification
+        Matrix4x4 get_face_view_matrix(size_t face_id) const noexcept {
+            static const Vec3 directions[6] = { Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0), Vec3(0.0, 1.0, 0.0), Vec3(0.0, -1.0, 0.0), Vec3(0.0, 0.0, 1.0), Vec3(0.0, 0.0, -1.0) };
+            static const Vec3 horizons[6] = { Vec3(0.0, 0.0, -1.0), Vec3(0.0, 0.0, 1.0), Vec3(1.0, 0.0, 0.0), Vec3(1.0, 0.0, 0.0), Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0) };
+            static const Vec3 verticals[6] = { Vec3(0.0, -1.0, 0.0), Vec3(0.0, -1.0, 0.0), Vec3(0.0, 0.0, 1.0), Vec3(0.0, 0.0, -1.0), Vec3(0.0, -1.0, 0.0), Vec3(0.0, -1.0, 0.0) };
+            return Matrix4x4(horizons[face_id], verticals[face_id], directions[face_id]).transpose() * Matrix4x4::translation_matrix(-position);
+        }
 
     public:
         Vec3 position;
@@ -22,16 +31,27 @@ namespace gre {
             this->position = position;
         }
 
-        // MAIN shader expected
-        void set_uniforms(size_t id, const Shader& shader) const override {
-            std::string name = "lights[" + std::to_string(id) + "].";
-            set_light_uniforms(name, shader);
+        Record get_record() const override {
+            Record record = get_light_record();
+            record.type = LIGHT_TYPE;
+            record.constant = static_cast<GLfloat>(constant_);
+            record.linear = static_cast<GLfloat>(linear_);
+            record.quadratic = static_cast<GLfloat>(quadratic_);
+            record.range = get_attenuation_range(constant_, linear_, quadratic_);
+            record.shadow_distance = static_cast<GLfloat>(shadow_distance_);
+            set_record_vec3(position, record.position);
+            return record;
+        }
 
-            shader.set_uniform_i((name + "type").c_str(), LIGHT_TYPE);
-            shader.set_uniform_f((name + "constant").c_str(), static_cast<GLfloat>(constant_));
-            shader.set_uniform_f((name + "linear").c_str(), static_cast<GLfloat>(linear_));
-            shader.set_uniform_f((name + "quadratic").c_str(), static_cast<GLfloat>(quadratic_));
-            shader.set_uniform_f((name + "position").c_str(), position);
+        // Casters farther than the distance from the light do not shade
+        void set_shadow_distance(double shadow_distance) {
+#ifdef _DEBUG
+            if (shadow_distance < 0.0 || equality(shadow_distance, 0.0)) {
+                throw GreInvalidArgument(__FILE__, __LINE__, "set_shadow_distance, not a positive shadow distance.\n\n");
+            }
+#endif // _DEBUG
+
+            shadow_distance_ = shadow_distance;
         }
 
         void set_constant(double coefficient) {
@@ -64,8 +84,32 @@ namespace gre {
             quadratic_ = coefficient;
         }
 
+        double get_shadow_distance() const noexcept {
+            return shadow_distance_;
+        }
+
+        // Box around the shadow distance, each face of the cube map lies inside of it
         Matrix4x4 get_light_space_matrix() const noexcept override {
-            return Matrix4x4(0.0);
+            return Matrix4x4::scale_matrix(1.0 / shadow_distance_) * Matrix4x4::translation_matrix(-position);
+        }
+
+        bool has_cube_shadow_map() const noexcept override {
+            return true;
+        }
+
+        // Perspective projections with the right angle, depth written by the shader is the distance to the light
+        std::array<Matrix4x4, 6> get_cube_face_matrices() const noexcept {
+            const double min_distance = shadow_distance_ / 1000.0;
+            Matrix4x4 projection = Matrix4x4::scale_matrix(Vec3(1.0, 1.0, (shadow_distance_ + min_distance) / (shadow_distance_ - min_distance)));
+            projection *= Matrix4x4::translation_matrix(Vec3(0.0, 0.0, -2.0 * shadow_distance_ * min_distance / (shadow_distance_ + min_distance)));
+            projection[3][3] = 0.0;
+            projection[3][2] = 1.0;
+
+            std::array<Matrix4x4, 6> face_matrices;
+            for (size_t i = 0; i < 6; ++i) {
+                face_matrices[i] = projection * get_face_view_matrix(i);
+            }
+            return face_matrices;
         }
 
         GraphObject get_light_object() const {
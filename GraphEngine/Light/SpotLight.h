@@ -65,22 +65,18 @@ namespace gre {
             set_projection_matrix();
         }
 
-        // MAIN shader expected
-        void set_uniforms(size_t id, const Shader& shader) const override {
-            std::string name = "lights[" + std::to_string(id) + "].";
-            set_light_uniforms(name, shader);
-
-            shader.set_uniform_i((name + "type").c_str(), LIGHT_TYPE);
-            shader.set_uniform_f((name + "constant").c_str(), static_cast<GLfloat>(constant_));
-            shader.set_uniform_f((name + "linear").c_str(), static_cast<GLfloat>(linear_));
-            shader.set_uniform_f((name + "quadratic").c_str(), static_cast<GLfloat>(quadratic_));
-            shader.set_uniform_f((name + "cut_in").c_str(), static_cast<GLfloat>(cos(border_in_)));
-            shader.set_uniform_f((name + "cut_out").c_str(), static_cast<GLfloat>(cos(border_out_)));
-            shader.set_uniform_f((name + "direction").c_str(), direction_);
-            shader.set_uniform_f((name + "position").c_str(), position);
-            if (shadow) {
-                shader.set_uniform_matrix((name + "light_space").c_str(), get_light_space_matrix());
-            }
+        Record get_record() const override {
+            Record record = get_light_record();
+            record.type = LIGHT_TYPE;
+            record.constant = static_cast<GLfloat>(constant_);
+            record.linear = static_cast<GLfloat>(linear_);
+            record.quadratic = static_cast<GLfloat>(quadratic_);
+            record.range = get_attenuation_range(constant_, linear_, quadratic_);
+            record.cut_in = static_cast<GLfloat>(cos(border_in_));
+            record.cut_out = static_cast<GLfloat>(cos(border_out_));
+            set_record_vec3(direction_, record.direction);
+            set_record_vec3(position, record.position);
+            return record;
         }
 
         void set_shadow_distance(double shadow_min_distance, double shadow_max_distance) {
@@ -153,6 +149,19 @@ namespace gre {
             return projection_ * get_view_matrix();
         }
 
+        // Resolution follows the screen size of the shadowed part of the cone, lit only up to the attenuation range
+        std::vector<ShadowMap> get_shadow_maps(const Camera& camera, const Vec2& /*resolution*/) const override {
+            double length = shadow_max_distance_;
+            double range = get_attenuation_range(constant_, linear_, quadratic_);
+            if (range >= 0.0) {
+                length = std::min(length, range);
+            }
+
+            double radius = sqrt(length * length / 4.0 + length * length * tan(border_out_) * tan(border_out_));
+            BoundingSphere cone_sphere(position + direction_ * (length / 2.0), radius);
+            return { ShadowMap{ get_light_space_matrix(), std::numeric_limits<double>::max(), get_screen_coverage(camera, cone_sphere) } };
+        }
+
         GraphObject get_shadow_box() const {
 #ifdef _DEBUG
             if (equality(shadow_max_distance_, 0.0)) {
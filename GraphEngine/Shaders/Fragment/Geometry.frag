@@ -0,0 +1,85 @@
+#version 430 core
+
+const int NR_CAMERAS = 1;
+
+
+struct Material {
+    vec3 ambient;
+    float alpha;
+    vec3 diffuse;
+    float shininess;
+    vec3 specular;
+    bool shadow;
+    vec3 emission;
+    bool use_vertex_color;
+    bool use_diffuse_map, use_specular_map, use_emission_map;
+};
+
+
+in vec2 tex_coord;
+in vec3 frag_pos;
+in vec3 norm;
+in vec3 vert_color;
+in float object_model_id;
+
+// Attachment ids must match GeometryBuffer
+layout (location = 0) out vec4 position_shininess;
+layout (location = 1) out vec4 normal_shadow;
+layout (location = 2) out vec4 ambient_color;
+layout (location = 3) out vec4 diffuse_alpha;
+layout (location = 4) out vec4 specular_color;
+layout (location = 5) out vec4 emission_coverage;
+
+uniform int object_id;
+uniform int material_id;
+uniform int camera_id;
+uniform sampler2D diffuse_map;
+uniform sampler2D specular_map;
+uniform sampler2D emission_map;
+uniform vec2 check_point;
+
+
+layout(std430, binding=0) buffer central_object {
+    int central_object_id[NR_CAMERAS];
+    int central_object_model_id[NR_CAMERAS];
+    float depth[NR_CAMERAS];
+};
+
+layout(std430, binding=4) readonly buffer materials_buffer {
+    Material materials[];
+};
+
+
+void main() {
+    if (abs(gl_FragCoord.x - check_point.x) <= 1 && abs(gl_FragCoord.y - check_point.y) <= 1 && gl_FragCoord.z < depth[camera_id]) {
+        central_object_id[camera_id] = object_id;
+        central_object_model_id[camera_id] = int(object_model_id);
+        depth[camera_id] = gl_FragCoord.z;
+    }
+
+    Material material = materials[material_id];
+    if (material.use_vertex_color) {
+        material.ambient = vert_color;
+        material.diffuse = vert_color;
+    }
+    if (material.use_diffuse_map) {
+        vec4 diffuse_color = texture(diffuse_map, tex_coord);
+        material.ambient = vec3(diffuse_color);
+        material.diffuse = vec3(diffuse_color);
+        material.alpha = diffuse_color.w;
+    }
+    if (material.use_specular_map)
+        material.specular = vec3(texture(specular_map, tex_coord));
+    if (material.use_emission_map)
+        material.emission = vec3(texture(emission_map, tex_coord));
+
+    if (material.alpha < 0.1)
+        discard;
+
+    position_shininess = vec4(frag_pos, material.shininess);
+    normal_shadow = vec4(normalize(norm), material.shadow ? 1.0 : 0.0);
+    ambient_color = vec4(material.ambient, 1.0);
+    diffuse_alpha = vec4(material.diffuse, material.alpha);
+    specular_color = vec4(material.specular, 1.0);
+    emission_coverage = vec4(material.emission, 1.0);
+}
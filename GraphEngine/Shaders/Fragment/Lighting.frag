@@ -0,0 +1,308 @@
+#version 430 core
+
+// Shadow filters must match ShadowFilter in Light.h
+const int SHADOW_FILTER_HARD = 0;
+const int SHADOW_FILTER_PCF_4 = 1;
+const int SHADOW_FILTER_PCF_9 = 2;
+const int SHADOW_FILTER_PCF_16 = 3;
+const int SHADOW_FILTER_POISSON = 4;
+const int SHADOW_FILTER_PCSS = 5;
+
+// Unit disc samples of the Poisson and PCSS shadow filters
+const vec2 POISSON_DISC[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725), vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464), vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420), vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590), vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// Sample directions of the cube shadow filter
+const vec3 CUBE_SHADOW_OFFSETS[20] = vec3[](
+    vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
+    vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+    vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+    vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+    vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
+
+struct Light {
+    vec3 position;
+    int type;
+    vec3 direction;
+    bool shadow;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+    float cut_in, cut_out;
+    float range;
+    int shadow_map_id;
+    int count_shadow_maps;
+    float shadow_distance;
+    int shadow_filter;
+    float shadow_bias;
+    float shadow_slope_bias;
+    float shadow_softness;
+};
+
+struct ShadowMap {
+    mat4 light_space;
+    vec4 tile;
+    float max_depth;
+    int page;
+};
+
+struct Material {
+    vec3 ambient;
+    float alpha;
+    vec3 diffuse;
+    float shininess;
+    vec3 specular;
+    bool shadow;
+    vec3 emission;
+};
+
+
+flat in int light_id;
+
+out vec4 color;
+
+uniform sampler2DArrayShadow shadow_maps;
+uniform samplerCubeArrayShadow cube_shadow_maps;
+uniform sampler2DArray shadow_depth_maps;  // Same texture as shadow_maps without comparison
+uniform sampler2D position_texture;
+uniform sampler2D normal_texture;
+uniform sampler2D ambient_texture;
+uniform sampler2D diffuse_texture;
+uniform sampler2D specular_texture;
+uniform sampler2D emission_texture;
+uniform vec3 view_pos;
+uniform mat4 view;
+
+
+layout(std430, binding=5) readonly buffer lights_buffer {
+    Light lights[];
+};
+
+layout(std430, binding=8) readonly buffer shadow_maps_buffer {
+    ShadowMap shadow_map_spaces[];
+};
+
+
+// Read from the geometry buffer before lighting
+vec3 frag_pos;
+float view_depth;
+
+
+// Fraction of the light blocked at the tap, the hardware comparison is filtered bilinearly
+float shadow_tap(vec3 coords, vec2 offset, vec4 tile_bounds, float reference) {
+    return 1.0 - texture(shadow_maps, vec4(clamp(coords.xy + offset, tile_bounds.xy, tile_bounds.zw), coords.z, reference));
+}
+
+
+// Bias grows with the tangent of the angle between the normal and the light direction
+float calc_shadow_bias(Light light, vec3 light_dir, vec3 normal) {
+    float cos_theta = clamp(dot(normal, light_dir), 0.001, 1.0);
+    return light.shadow_bias + light.shadow_slope_bias * min(sqrt(1.0 - cos_theta * cos_theta) / cos_theta, 10.0);
+}
+
+
+float calc_shadow(Light light, vec3 light_dir, vec3 normal, int id) {
+    if (!light.shadow)
+        return 0.0;
+
+    // Cascades are ordered by the view depth, the last one covers the rest
+    int last_id = id + light.count_shadow_maps - 1;
+    while (id < last_id && view_depth > shadow_map_spaces[id].max_depth)
+        ++id;
+
+    ShadowMap shadow_map = shadow_map_spaces[id];
+    if (shadow_map.page < 0)
+        return 0.0;
+
+    vec4 frag_pos_light_space = shadow_map.light_space * vec4(frag_pos, 1.0);
+    frag_pos_light_space = frag_pos_light_space / frag_pos_light_space.w;
+    vec3 proj_coords = vec3(frag_pos_light_space) * 0.5 + 0.5;
+
+    if(proj_coords.z > 1.0 || any(lessThan(proj_coords.xy, vec2(0.0))) || any(greaterThan(proj_coords.xy, vec2(1.0))))
+        return 0.0;
+
+    // Taps are clamped to the atlas tile, so the filter never reads neighbouring tiles
+    float reference = proj_coords.z - calc_shadow_bias(light, light_dir, normal);
+    vec2 texel_size = 1.0 / textureSize(shadow_maps, 0).xy;
+    vec3 coords = vec3(shadow_map.tile.xy + proj_coords.xy * shadow_map.tile.zw, shadow_map.page);
+    vec4 tile_bounds = vec4(shadow_map.tile.xy + 0.5 * texel_size, shadow_map.tile.xy + shadow_map.tile.zw - 0.5 * texel_size);
+
+    if (light.shadow_filter == SHADOW_FILTER_HARD)
+        return shadow_tap(coords, vec2(0.0), tile_bounds, reference);
+
+    // Grid of 2, 3 or 4 taps per side centered at the fragment
+    if (light.shadow_filter <= SHADOW_FILTER_PCF_16) {
+        int size = light.shadow_filter + 1;
+        float shadow = 0.0;
+        for (int x = 0; x < size; ++x) {
+            for (int y = 0; y < size; ++y) {
+                shadow += shadow_tap(coords, (vec2(x, y) - 0.5 * float(size - 1)) * texel_size, tile_bounds, reference);
+            }
+        }
+        return shadow / float(size * size);
+    }
+
+    // Blockers inside the softness radius shrink the penumbra towards the contact points
+    float radius = light.shadow_softness;
+    if (light.shadow_filter == SHADOW_FILTER_PCSS) {
+        float blocker_depth = 0.0;
+        int count_blockers = 0;
+        for (int i = 0; i < 16; ++i) {
+            vec2 sample_coords = clamp(coords.xy + POISSON_DISC[i] * light.shadow_softness * texel_size, tile_bounds.xy, tile_bounds.zw);
+            float sample_depth = texture(shadow_depth_maps, vec3(sample_coords, coords.z)).r;
+            if (sample_depth < reference) {
+                blocker_depth += sample_depth;
+                ++count_blockers;
+            }
+        }
+
+        if (count_blockers == 0)
+            return 0.0;
+
+        blocker_depth /= float(count_blockers);
+        radius = clamp(light.shadow_softness * (reference - blocker_depth) / max(blocker_depth, 0.001), 1.0, light.shadow_softness);
+    }
+
+    float shadow = 0.0;
+    for (int i = 0; i < 16; ++i) {
+        shadow += shadow_tap(coords, POISSON_DISC[i] * radius * texel_size, tile_bounds, reference);
+    }
+    return shadow / 16.0;
+}
+
+
+float calc_cube_shadow(Light light, vec3 light_dir, vec3 normal, int id) {
+    if (!light.shadow)
+        return 0.0;
+
+    // Cube maps keep the distance to the light divided by the shadow distance
+    vec3 light_to_frag = frag_pos - light.position;
+    float current_depth = length(light_to_frag) / light.shadow_distance;
+
+    if (current_depth > 1.0)
+        return 0.0;
+
+    float reference = current_depth - calc_shadow_bias(light, light_dir, normal);
+    if (light.shadow_filter == SHADOW_FILTER_HARD)
+        return 1.0 - texture(cube_shadow_maps, vec4(light_to_frag, id), reference);
+
+    // Other filters spread the samples over the softness radius in texels of the face
+    float radius = light.shadow_softness * length(light_to_frag) / float(textureSize(cube_shadow_maps, 0).x);
+    float shadow = 0.0;
+    for (int i = 0; i < 20; ++i) {
+        shadow += 1.0 - texture(cube_shadow_maps, vec4(light_to_frag + CUBE_SHADOW_OFFSETS[i] * radius, id), reference);
+    }
+
+    return shadow / 20.0;
+}
+
+
+vec3 calc_dir_light(Light light, vec3 normal, vec3 view_dir, Material material, int id) {
+    vec3 light_dir = normalize(-light.direction);
+    float diff = max(dot(normal, light_dir), 0.0);
+
+    vec3 halfway_dir = normalize(light_dir + view_dir);
+    float spec = pow(max(dot(normal, halfway_dir), 0.0), material.shininess);
+
+    float shadow = material.shadow ? calc_shadow(light, light_dir, normal, id) : 0.0;
+    vec3 ambient = light.ambient * material.ambient;
+    vec3 diffuse = light.diffuse * diff * material.diffuse;
+    vec3 specular = light.specular * spec * material.specular;
+
+    if (dot(light_dir, normal) < 0.0)
+        return ambient;
+
+    return ambient + (1.0 - shadow) * (diffuse + specular);
+}
+
+
+vec3 calc_point_light(Light light, vec3 normal, vec3 view_dir, Material material, int id) {
+    vec3 light_dir = normalize(light.position - frag_pos);
+
+    float diff = max(dot(normal, light_dir), 0.0);
+
+    vec3 halfway_dir = normalize(light_dir + view_dir);
+    float spec = pow(max(dot(normal, halfway_dir), 0.0), material.shininess);
+
+    float distance = length(light.position - frag_pos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    
+    float shadow = material.shadow ? calc_cube_shadow(light, light_dir, normal, id) : 0.0;
+    vec3 ambient = light.ambient * material.ambient * attenuation;
+    vec3 diffuse = light.diffuse * diff * material.diffuse * attenuation;
+    vec3 specular = light.specular * spec * material.specular * attenuation;
+
+    if (dot(light_dir, normal) < 0.0)
+        return ambient;
+
+    return ambient + (1.0 - shadow) * (diffuse + specular);
+}
+
+
+vec3 calc_spot_light(Light light, vec3 normal, vec3 view_dir, Material material, int id) {
+    vec3 light_dir = normalize(light.position - frag_pos);
+    float diff = max(dot(normal, light_dir), 0.0);
+
+    vec3 halfway_dir = normalize(light_dir + view_dir);
+    float spec = pow(max(dot(normal, halfway_dir), 0.0), material.shininess);
+
+    float distance = length(light.position - frag_pos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    float theta = dot(light_dir, normalize(-light.direction));
+    float intensity = clamp((theta - light.cut_out) / (light.cut_in - light.cut_out), 0.0, 1.0);    
+    
+    float shadow = material.shadow ? calc_shadow(light, light_dir, normal, id) : 0.0;
+    vec3 ambient = light.ambient * material.ambient * attenuation;
+    vec3 diffuse = light.diffuse * diff * material.diffuse * attenuation * intensity;
+    vec3 specular = light.specular * spec * material.specular * attenuation * intensity;
+
+    if (dot(light_dir, normal) < 0.0)
+        return ambient;
+
+    return ambient + (1.0 - shadow) * (diffuse + specular);
+}
+
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (texelFetch(emission_texture, pixel, 0).a == 0.0)
+        discard;
+
+    vec4 position_shininess = texelFetch(position_texture, pixel, 0);
+    vec4 normal_shadow = texelFetch(normal_texture, pixel, 0);
+    vec4 diffuse_alpha = texelFetch(diffuse_texture, pixel, 0);
+
+    Material material;
+    material.ambient = texelFetch(ambient_texture, pixel, 0).rgb;
+    material.alpha = diffuse_alpha.a;
+    material.diffuse = diffuse_alpha.rgb;
+    material.shininess = position_shininess.w;
+    material.specular = texelFetch(specular_texture, pixel, 0).rgb;
+    material.shadow = normal_shadow.w > 0.5;
+
+    frag_pos = position_shininess.xyz;
+    view_depth = (view * vec4(frag_pos, 1.0)).z;
+    vec3 normal = normal_shadow.xyz;
+    vec3 view_dir = normalize(view_pos - frag_pos);
+
+    Light light = lights[light_id];
+    vec3 result_color;
+    if (light.type == 0)
+        result_color = calc_dir_light(light, normal, view_dir, material, light.shadow_map_id);
+    else if (light.type == 1)
+        result_color = calc_point_light(light, normal, view_dir, material, light.shadow_map_id);
+    else
+        result_color = calc_spot_light(light, normal, view_dir, material, light.shadow_map_id);
+
+    color = vec4(result_color, 0.0);
+}
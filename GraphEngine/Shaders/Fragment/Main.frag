@@ -1,21 +1,78 @@
 #version 430 core
 
-const int NR_LIGHTS = 3;
 const int NR_CAMERAS = 1;
 
+// Cluster grid must match Cluster.comp
+const uint CLUSTERS_X = 16;
+const uint CLUSTERS_Y = 9;
+const uint CLUSTERS_Z = 24;
+const uint MAX_CLUSTER_LIGHTS = 128;
+
+// Shadow filters must match ShadowFilter in Light.h
+const int SHADOW_FILTER_HARD = 0;
+const int SHADOW_FILTER_PCF_4 = 1;
+const int SHADOW_FILTER_PCF_9 = 2;
+const int SHADOW_FILTER_PCF_16 = 3;
+const int SHADOW_FILTER_POISSON = 4;
+const int SHADOW_FILTER_PCSS = 5;
+
+// Unit disc samples of the Poisson and PCSS shadow filters
+const vec2 POISSON_DISC[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725), vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464), vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420), vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590), vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// Sample directions of the cube shadow filter
+const vec3 CUBE_SHADOW_OFFSETS[20] = vec3[](
+    vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
+    vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+    vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+    vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+    vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
 
 struct Light {
-    bool shadow;
+    vec3 position;
     int type;
-    float constant, linear, quadratic, cut_in, cut_out;
-    vec3 position, direction, ambient, diffuse, specular;
+    vec3 direction;
+    bool shadow;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+    float cut_in, cut_out;
+    float range;
+    int shadow_map_id;
+    int count_shadow_maps;
+    float shadow_distance;
+    int shadow_filter;
+    float shadow_bias;
+    float shadow_slope_bias;
+    float shadow_softness;
+};
+
+struct ShadowMap {
     mat4 light_space;
+    vec4 tile;
+    float max_depth;
+    int page;
 };
 
 struct Material {
-    bool shadow, use_vertex_color;
-    float shininess, alpha;
-    vec3 ambient, diffuse, specular, emission;
+    vec3 ambient;
+    float alpha;
+    vec3 diffuse;
+    float shininess;
+    vec3 specular;
+    bool shadow;
+    vec3 emission;
+    bool use_vertex_color;
+    bool use_diffuse_map, use_specular_map, use_emission_map;
 };
 
 
@@ -27,21 +84,20 @@ in float object_model_id;
 
 out vec4 color;
 
-uniform bool use_diffuse_map;
-uniform bool use_specular_map;
-uniform bool use_emission_map;
 uniform int object_id;
+uniform int material_id;
 uniform int camera_id;
-uniform int number_lights;
 uniform float gamma;
 uniform sampler2D diffuse_map;
 uniform sampler2D specular_map;
 uniform sampler2D emission_map;
-uniform sampler2DArray shadow_maps;
+uniform sampler2DArrayShadow shadow_maps;
+uniform samplerCubeArrayShadow cube_shadow_maps;
+uniform sampler2DArray shadow_depth_maps;  // Same texture as shadow_maps without comparison
 uniform vec2 check_point;
+uniform vec2 depth_range;
+uniform vec2 viewport_size;
 uniform vec3 view_pos;
-uniform Material object_material;
-uniform Light lights[NR_LIGHTS];
 
 
 layout(std430, binding=0) buffer central_object {
@@ -50,31 +106,134 @@ layout(std430, binding=0) buffer central_object {
     float depth[NR_CAMERAS];
 };
 
+layout(std430, binding=4) readonly buffer materials_buffer {
+    Material materials[];
+};
+
+layout(std430, binding=5) readonly buffer lights_buffer {
+    Light lights[];
+};
+
+layout(std430, binding=6) readonly buffer light_clusters {
+    uint cluster_light_counts[CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z];
+    uint cluster_light_indices[];
+};
+
+layout(std430, binding=8) readonly buffer shadow_maps_buffer {
+    ShadowMap shadow_map_spaces[];
+};
+
+
+// Computed by main before lighting
+float view_depth;
+
+
+// Fraction of the light blocked at the tap, the hardware comparison is filtered bilinearly
+float shadow_tap(vec3 coords, vec2 offset, vec4 tile_bounds, float reference) {
+    return 1.0 - texture(shadow_maps, vec4(clamp(coords.xy + offset, tile_bounds.xy, tile_bounds.zw), coords.z, reference));
+}
+
+
+// Bias grows with the tangent of the angle between the normal and the light direction
+float calc_shadow_bias(Light light, vec3 light_dir, vec3 normal) {
+    float cos_theta = clamp(dot(normal, light_dir), 0.001, 1.0);
+    return light.shadow_bias + light.shadow_slope_bias * min(sqrt(1.0 - cos_theta * cos_theta) / cos_theta, 10.0);
+}
+
 
 float calc_shadow(Light light, vec3 light_dir, vec3 normal, int id) {
     if (!light.shadow)
         return 0.0;
 
-    float bias = 0.01;
-    
-    vec4 frag_pos_light_space = light.light_space * vec4(frag_pos, 1.0);
+    // Cascades are ordered by the view depth, the last one covers the rest
+    int last_id = id + light.count_shadow_maps - 1;
+    while (id < last_id && view_depth > shadow_map_spaces[id].max_depth)
+        ++id;
+
+    ShadowMap shadow_map = shadow_map_spaces[id];
+    if (shadow_map.page < 0)
+        return 0.0;
+
+    vec4 frag_pos_light_space = shadow_map.light_space * vec4(frag_pos, 1.0);
     frag_pos_light_space = frag_pos_light_space / frag_pos_light_space.w;
     vec3 proj_coords = vec3(frag_pos_light_space) * 0.5 + 0.5;
-    float current_depth = proj_coords.z;
 
-    if(proj_coords.z > 1.0)
+    if(proj_coords.z > 1.0 || any(lessThan(proj_coords.xy, vec2(0.0))) || any(greaterThan(proj_coords.xy, vec2(1.0))))
         return 0.0;
 
-    float shadow = 0.0;
+    // Taps are clamped to the atlas tile, so the filter never reads neighbouring tiles
+    float reference = proj_coords.z - calc_shadow_bias(light, light_dir, normal);
     vec2 texel_size = 1.0 / textureSize(shadow_maps, 0).xy;
-    for (int x = -1; x <= 1; ++x) {
-        for(int y = -1; y <= 1; ++y) {
-            float pcf_depth = texture(shadow_maps, vec3(proj_coords.xy + vec2(x, y) * texel_size, id)).r;
-            shadow += current_depth - bias > pcf_depth ? 1.0 : 0.0;
+    vec3 coords = vec3(shadow_map.tile.xy + proj_coords.xy * shadow_map.tile.zw, shadow_map.page);
+    vec4 tile_bounds = vec4(shadow_map.tile.xy + 0.5 * texel_size, shadow_map.tile.xy + shadow_map.tile.zw - 0.5 * texel_size);
+
+    if (light.shadow_filter == SHADOW_FILTER_HARD)
+        return shadow_tap(coords, vec2(0.0), tile_bounds, reference);
+
+    // Grid of 2, 3 or 4 taps per side centered at the fragment
+    if (light.shadow_filter <= SHADOW_FILTER_PCF_16) {
+        int size = light.shadow_filter + 1;
+        float shadow = 0.0;
+        for (int x = 0; x < size; ++x) {
+            for (int y = 0; y < size; ++y) {
+                shadow += shadow_tap(coords, (vec2(x, y) - 0.5 * float(size - 1)) * texel_size, tile_bounds, reference);
+            }
         }
+        return shadow / float(size * size);
+    }
+
+    // Blockers inside the softness radius shrink the penumbra towards the contact points
+    float radius = light.shadow_softness;
+    if (light.shadow_filter == SHADOW_FILTER_PCSS) {
+        float blocker_depth = 0.0;
+        int count_blockers = 0;
+        for (int i = 0; i < 16; ++i) {
+            vec2 sample_coords = clamp(coords.xy + POISSON_DISC[i] * light.shadow_softness * texel_size, tile_bounds.xy, tile_bounds.zw);
+            float sample_depth = texture(shadow_depth_maps, vec3(sample_coords, coords.z)).r;
+            if (sample_depth < reference) {
+                blocker_depth += sample_depth;
+                ++count_blockers;
+            }
+        }
+
+        if (count_blockers == 0)
+            return 0.0;
+
+        blocker_depth /= float(count_blockers);
+        radius = clamp(light.shadow_softness * (reference - blocker_depth) / max(blocker_depth, 0.001), 1.0, light.shadow_softness);
     }
 
-    return shadow / 9.0;
+    float shadow = 0.0;
+    for (int i = 0; i < 16; ++i) {
+        shadow += shadow_tap(coords, POISSON_DISC[i] * radius * texel_size, tile_bounds, reference);
+    }
+    return shadow / 16.0;
+}
+
+
+float calc_cube_shadow(Light light, vec3 light_dir, vec3 normal, int id) {
+    if (!light.shadow)
+        return 0.0;
+
+    // Cube maps keep the distance to the light divided by the shadow distance
+    vec3 light_to_frag = frag_pos - light.position;
+    float current_depth = length(light_to_frag) / light.shadow_distance;
+
+    if (current_depth > 1.0)
+        return 0.0;
+
+    float reference = current_depth - calc_shadow_bias(light, light_dir, normal);
+    if (light.shadow_filter == SHADOW_FILTER_HARD)
+        return 1.0 - texture(cube_shadow_maps, vec4(light_to_frag, id), reference);
+
+    // Other filters spread the samples over the softness radius in texels of the face
+    float radius = light.shadow_softness * length(light_to_frag) / float(textureSize(cube_shadow_maps, 0).x);
+    float shadow = 0.0;
+    for (int i = 0; i < 20; ++i) {
+        shadow += 1.0 - texture(cube_shadow_maps, vec4(light_to_frag + CUBE_SHADOW_OFFSETS[i] * radius, id), reference);
+    }
+
+    return shadow / 20.0;
 }
 
 
@@ -108,6 +267,7 @@ vec3 calc_point_light(Light light, vec3 normal, vec3 view_dir, Material material
     float distance = length(light.position - frag_pos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     
+    float shadow = material.shadow ? calc_cube_shadow(light, light_dir, normal, id) : 0.0;
     vec3 ambient = light.ambient * material.ambient * attenuation;
     vec3 diffuse = light.diffuse * diff * material.diffuse * attenuation;
     vec3 specular = light.specular * spec * material.specular * attenuation;
@@ -115,7 +275,7 @@ vec3 calc_point_light(Light light, vec3 normal, vec3 view_dir, Material material
     if (dot(light_dir, normal) < 0.0)
         return ambient;
 
-    return ambient + diffuse + specular;
+    return ambient + (1.0 - shadow) * (diffuse + specular);
 }
 
 
@@ -151,20 +311,20 @@ void main() {
         depth[camera_id] = gl_FragCoord.z;
     }
 
-    Material material = object_material;
-    if (object_material.use_vertex_color) {
+    Material material = materials[material_id];
+    if (material.use_vertex_color) {
         material.ambient = vert_color;
         material.diffuse = vert_color;
     }
-    if (use_diffuse_map) {
+    if (material.use_diffuse_map) {
         vec4 diffuse_color = texture(diffuse_map, tex_coord);
         material.ambient = vec3(diffuse_color);
         material.diffuse = vec3(diffuse_color);
         material.alpha = diffuse_color.w;
     }
-    if (use_specular_map)
+    if (material.use_specular_map)
         material.specular = vec3(texture(specular_map, tex_coord));
-    if (use_emission_map)
+    if (material.use_emission_map)
         material.emission = vec3(texture(emission_map, tex_coord));
 
     if (material.alpha < 0.1)
@@ -173,17 +333,22 @@ void main() {
     vec3 normal = normalize(norm);
     vec3 view_dir = normalize(view_pos - frag_pos);
 
+    // View depth is kept in w by the projection
+    view_depth = 1.0 / gl_FragCoord.w;
+    uint slice = uint(clamp(log(view_depth / depth_range.x) / log(depth_range.y / depth_range.x) * float(CLUSTERS_Z), 0.0, float(CLUSTERS_Z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / viewport_size * vec2(CLUSTERS_X, CLUSTERS_Y)), uvec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+    uint cluster_id = (slice * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x;
+
     vec3 result_color = vec3(0.0);
-    for (int i = 0; i < NR_LIGHTS; i++) {
-        if (i == number_lights)
-            break;
-
-        if (lights[i].type == 0)
-            result_color += calc_dir_light(lights[i], normal, view_dir, material, i);
-        else if (lights[i].type == 1)
-            result_color += calc_point_light(lights[i], normal, view_dir, material, i);
+    for (uint i = 0; i < cluster_light_counts[cluster_id]; i++) {
+        Light light = lights[cluster_light_indices[cluster_id * MAX_CLUSTER_LIGHTS + i]];
+
+        if (light.type == 0)
+            result_color += calc_dir_light(light, normal, view_dir, material, light.shadow_map_id);
+        else if (light.type == 1)
+            result_color += calc_point_light(light, normal, view_dir, material, light.shadow_map_id);
         else
-            result_color += calc_spot_light(lights[i], normal, view_dir, material, i);
+            result_color += calc_spot_light(light, normal, view_dir, material, light.shadow_map_id);
     }
 
     color = vec4(pow(result_color + material.emission, vec3(1.0 / gamma)), material.alpha);
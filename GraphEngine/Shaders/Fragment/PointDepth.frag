@@ -0,0 +1,13 @@
+#version 430 core
+
+
+in vec3 frag_pos;
+
+uniform vec3 light_position;
+uniform float shadow_distance;
+
+
+// Linear distance keeps the same precision over the whole range
+void main() {
+    gl_FragDepth = length(frag_pos - light_position) / shadow_distance;
+}
@@ -0,0 +1,22 @@
+#version 430 core
+
+
+in vec2 tex_coord;
+
+out vec4 color;
+
+uniform float gamma;
+uniform sampler2D diffuse_texture;
+uniform sampler2D emission_texture;
+uniform sampler2D lighting_texture;
+
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 emission_coverage = texelFetch(emission_texture, pixel, 0);
+    if (emission_coverage.a == 0.0)
+        discard;
+
+    vec3 result_color = texelFetch(lighting_texture, pixel, 0).rgb;
+    color = vec4(pow(result_color + emission_coverage.rgb, vec3(1.0 / gamma)), texelFetch(diffuse_texture, pixel, 0).a);
+}
@@ -4,9 +4,13 @@
 layout (location = 0) in vec3 position;
 layout (location = 4) in mat4 model;
 
-uniform mat4 light_space;
+// Same transform as in Main.vert, so the depth pre-pass matches the shaded pass exactly
+invariant gl_Position;
+
+uniform mat4 view;
+uniform mat4 projection;
 
 
 void main() {
-    gl_Position = light_space * model * vec4(position, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
@@ -0,0 +1,56 @@
+#version 430 core
+
+
+struct Light {
+    vec3 position;
+    int type;
+    vec3 direction;
+    bool shadow;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+    float cut_in, cut_out;
+    float range;
+    int shadow_map_id;
+    int count_shadow_maps;
+    float shadow_distance;
+    int shadow_filter;
+    float shadow_bias;
+    float shadow_slope_bias;
+    float shadow_softness;
+};
+
+
+layout (location = 0) in vec3 position;
+
+flat out int light_id;
+
+uniform int first_light;
+uniform bool light_volume;
+uniform mat4 view;
+uniform mat4 projection;
+
+
+layout(std430, binding=5) readonly buffer lights_buffer {
+    Light lights[];
+};
+
+layout(std430, binding=7) readonly buffer deferred_lights {
+    uint light_indices[];
+};
+
+
+void main() {
+    light_id = int(light_indices[first_light + gl_InstanceID]);
+    if (!light_volume) {
+        gl_Position = vec4(position.xy, 0.0, 1.0);
+        return;
+    }
+
+    // Unit sphere is scaled to the light range
+    Light light = lights[light_id];
+    gl_Position = projection * view * vec4(light.position + position * light.range, 1.0);
+}
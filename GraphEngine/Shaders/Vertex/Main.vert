@@ -6,6 +6,8 @@ layout (location = 1) in vec3 vertex_normal;
 layout (location = 2) in vec2 texture_coord;
 layout (location = 3) in vec3 vertex_color;
 layout (location = 4) in mat4 instance_model;
+layout (location = 8) in uint instance_model_id;
+layout (location = 9) in mat3 instance_normal;
 
 out vec2 tex_coord;
 out vec3 frag_pos;
@@ -13,23 +15,17 @@ out vec3 norm;
 out vec3 vert_color;
 out float object_model_id;
 
-uniform int model_id;
-uniform mat4 not_instance_model;
+invariant gl_Position;
+
 uniform mat4 view;
 uniform mat4 projection;
 
 
 void main() {
-    mat4 model = not_instance_model;
-    object_model_id = model_id;
-    if (model_id == -1) {
-        model = instance_model;
-        object_model_id = gl_InstanceID;
-    }
-
-    gl_Position = projection * view * model * vec4(position, 1.0);
+    gl_Position = projection * view * instance_model * vec4(position, 1.0);
     tex_coord = vec2(texture_coord.x, 1.0 - texture_coord.y);
-    frag_pos = vec3(model * vec4(position, 1.0f));
-    norm = transpose(inverse(mat3(model))) * vertex_normal;
+    frag_pos = vec3(instance_model * vec4(position, 1.0f));
+    norm = instance_normal * vertex_normal;
+    object_model_id = instance_model_id;
     vert_color = vertex_color;
 }